@@ -1,4 +1,4 @@
-QT       += core gui sql concurrent multimedia multimediawidgets
+QT       += core gui sql network concurrent multimedia multimediawidgets
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -16,17 +16,83 @@ DEFINES += QT_DEPRECATED_WARNINGS
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    allocationtracker.cpp \
+    annualsettlement.cpp \
+    bonusoptimizer.cpp \
+    changepassworddialog.cpp \
+    columnaremployeestore.cpp \
+    configstore.cpp \
+    contributiontable.cpp \
+    credentialstore.cpp \
+    databasemaintenance.cpp \
+    databasepreloader.cpp \
+    databasesnapshot.cpp \
+    deductionsdialog.cpp \
+    diagnosticsdialog.cpp \
+    employeesearchindex.cpp \
+    employeestore.cpp \
+    instrumentedapplication.cpp \
+    jobscheduler.cpp \
     logindialog.cpp \
     main.cpp \
+    metricsregistry.cpp \
+    paybreakdown.cpp \
+    paybreakdowndialog.cpp \
+    payrolldashboard.cpp \
+    payrolldialog.cpp \
+    payrollledger.cpp \
+    salaryrankindex.cpp \
+    salarystatspanel.cpp \
+    scenariobenchmark.cpp \
+    sharedtaxring.cpp \
+    slowquerylog.cpp \
     sqlmanager.cpp \
+    startupprofiler.cpp \
     taxcalccenter.cpp \
-    wagestax.cpp
+    taxschedule.cpp \
+    taxserver.cpp \
+    tracerecorder.cpp \
+    wagestax.cpp \
+    watchedfile.cpp
 
 HEADERS += \
+    allocationtracker.h \
+    annualsettlement.h \
+    bonusoptimizer.h \
+    changepassworddialog.h \
+    columnaremployeestore.h \
+    configstore.h \
+    contributiontable.h \
+    credentialstore.h \
+    databasemaintenance.h \
+    databasepreloader.h \
+    databasesnapshot.h \
+    deductionsdialog.h \
+    diagnosticsdialog.h \
+    employeesearchindex.h \
+    employeestore.h \
+    instrumentedapplication.h \
+    jobscheduler.h \
     logindialog.h \
+    metricsregistry.h \
+    paybreakdown.h \
+    paybreakdowndialog.h \
+    payrolldashboard.h \
+    payrolldialog.h \
+    payrollledger.h \
+    salaryrankindex.h \
+    salarystatspanel.h \
+    scenariobenchmark.h \
+    sharedtaxring.h \
+    slowquerylog.h \
     sqlmanager.h \
+    startupprofiler.h \
     taxcalccenter.h \
-    wagestax.h
+    taxschedule.h \
+    taxserver.h \
+    tracerecorder.h \
+    wagestax.h \
+    watchedfile.h
 
 FORMS += \
     logindialog.ui \
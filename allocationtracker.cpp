@@ -0,0 +1,222 @@
+﻿#include "allocationtracker.h"
+#include <QMutex>
+#include <QTextStream>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+std::atomic<bool> AllocationTracker::enabled(false);
+
+namespace
+{
+    // 单个范围的统计，全部是原子计数，operator new 中不能再分配内存
+    struct ScopeStats
+    {
+        std::atomic<const char*> name;
+        std::atomic<quint64> entries;      // 进入次数（即操作次数）
+        std::atomic<quint64> allocations;  // 分配次数
+        std::atomic<quint64> bytes;        // 分配字节数
+        std::atomic<quint64> frees;        // 释放次数
+    };
+
+    // 静态数组，零初始化，不依赖构造顺序（operator new 可能在静态初始化期间就被调用）
+    ScopeStats scopes[AllocationTracker::MaxScopes];
+
+    // 已登记的范围数量（第 0 个保留给“未在任何范围内”）
+    std::atomic<int> scopeCount(1);
+
+    // 登记新范围时加锁
+    QMutex registerMutex;
+
+    // 当前线程所在的范围
+    thread_local int currentScope = 0;
+}
+
+// 开启或关闭统计
+void AllocationTracker::setEnabled(bool on)
+{
+    enabled.store(on, std::memory_order_relaxed);
+}
+
+// 按名称取得范围序号
+int AllocationTracker::scopeIndex(const char* name)
+{
+    int count = scopeCount.load(std::memory_order_acquire);
+    for (int i = 1; i < count; ++i)
+    {
+        if (std::strcmp(scopes[i].name.load(std::memory_order_relaxed), name) == 0)
+        {
+            return i;
+        }
+    }
+
+    QMutexLocker locker(&registerMutex);
+    count = scopeCount.load(std::memory_order_acquire);
+    for (int i = 1; i < count; ++i)
+    {
+        if (std::strcmp(scopes[i].name.load(std::memory_order_relaxed), name) == 0)
+        {
+            return i;
+        }
+    }
+    if (count >= MaxScopes)
+    {
+        return 0;  // 范围过多时归入“未在任何范围内”
+    }
+    scopes[count].name.store(name, std::memory_order_relaxed);
+    scopeCount.store(count + 1, std::memory_order_release);
+    return count;
+}
+
+// 清零所有统计
+void AllocationTracker::reset()
+{
+    for (ScopeStats& scope : scopes)
+    {
+        scope.entries.store(0, std::memory_order_relaxed);
+        scope.allocations.store(0, std::memory_order_relaxed);
+        scope.bytes.store(0, std::memory_order_relaxed);
+        scope.frees.store(0, std::memory_order_relaxed);
+    }
+}
+
+// 统计文本
+QString AllocationTracker::toText()
+{
+    QString text;
+    QTextStream out(&text);
+
+    if (!isEnabled())
+    {
+        out << "allocation tracking disabled (start with --alloc-tracking)\n";
+        out.flush();
+        return text;
+    }
+
+    out << QString("%1 %2 %3 %4 %5 %6 %7\n")
+        .arg("scope", -12).arg("ops", 10).arg("allocs", 12).arg("bytes", 14)
+        .arg("frees", 12).arg("allocs/op", 10).arg("bytes/op", 12);
+
+    int count = scopeCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; ++i)
+    {
+        const ScopeStats& scope = scopes[i];
+        quint64 entries = scope.entries.load(std::memory_order_relaxed);
+        quint64 allocations = scope.allocations.load(std::memory_order_relaxed);
+        quint64 bytes = scope.bytes.load(std::memory_order_relaxed);
+        out << QString("%1 %2 %3 %4 %5 %6 %7\n")
+            .arg(i == 0 ? "(unscoped)" : scope.name.load(std::memory_order_relaxed), -12)
+            .arg(entries, 10)
+            .arg(allocations, 12)
+            .arg(bytes, 14)
+            .arg(scope.frees.load(std::memory_order_relaxed), 12)
+            .arg(entries ? double(allocations) / entries : 0.0, 10, 'f', 1)
+            .arg(entries ? double(bytes) / entries : 0.0, 12, 'f', 0);
+    }
+    out.flush();
+    return text;
+}
+
+// 记录一次分配
+void AllocationTracker::onAllocate(std::size_t size)
+{
+    if (!isEnabled())
+    {
+        return;
+    }
+    ScopeStats& scope = scopes[currentScope];
+    scope.allocations.fetch_add(1, std::memory_order_relaxed);
+    scope.bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+// 记录一次释放
+void AllocationTracker::onFree()
+{
+    if (!isEnabled())
+    {
+        return;
+    }
+    scopes[currentScope].frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+// 进入范围
+int AllocationTracker::enterScope(int index)
+{
+    int previous = currentScope;
+    currentScope = index;
+    if (isEnabled())
+    {
+        scopes[index].entries.fetch_add(1, std::memory_order_relaxed);
+    }
+    return previous;
+}
+
+// 离开范围
+void AllocationTracker::leaveScope(int previous)
+{
+    currentScope = previous;
+}
+
+// 替换全局 operator new / operator delete
+// 每次分配先记账再交给 malloc，释放交给 free；数组版本和 nothrow 版本同样处理
+
+void* operator new(std::size_t size)
+{
+    AllocationTracker::onAllocate(size);
+    void* pointer = std::malloc(size ? size : 1);
+    if (!pointer)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    AllocationTracker::onAllocate(size);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return ::operator new(size, std::nothrow);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    if (pointer)
+    {
+        AllocationTracker::onFree();
+        std::free(pointer);
+    }
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    ::operator delete(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+    ::operator delete(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+    ::operator delete(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    ::operator delete(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+    ::operator delete(pointer);
+}
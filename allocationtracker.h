@@ -0,0 +1,65 @@
+﻿#ifndef ALLOCATIONTRACKER_H
+#define ALLOCATIONTRACKER_H
+
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+
+// AllocationTracker 类统计每个“操作范围”（查询、渲染、重算等）内的堆分配次数和字节数
+// 统计通过替换全局 operator new / operator delete 实现（见 allocationtracker.cpp），
+// 默认关闭，使用 --alloc-tracking 开启；关闭时每次分配只多一次原子读取
+// 注意：Qt 容器（QString、QByteArray、QVector 等）的数据区直接使用 malloc 分配，不经过 operator new，
+// 因此这里统计的是控件、列表项、布局、std 容器以及其他通过 new 创建的对象
+class AllocationTracker
+{
+public:
+    // 最多可以登记的范围数量（第 0 个是“未在任何范围内”）
+    static const int MaxScopes = 32;
+
+    // 开启或关闭统计
+    static void setEnabled(bool on);
+    static bool isEnabled()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    // 按名称取得范围序号，第一次使用时登记；名称必须是静态字符串
+    static int scopeIndex(const char* name);
+
+    // 清零所有统计
+    static void reset();
+
+    // 统计文本，用于诊断窗口
+    static QString toText();
+
+    // 由 operator new / delete 调用
+    static void onAllocate(std::size_t size);
+    static void onFree();
+
+    // 由 AllocationScope 调用：切换当前线程的范围，返回之前的范围
+    static int enterScope(int index);
+    static void leaveScope(int previous);
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+// AllocationScope 类以 RAII 方式把当前线程的分配归入指定范围，范围可以嵌套，分配计入最内层
+class AllocationScope
+{
+public:
+    explicit AllocationScope(const char* name)
+        : previous(AllocationTracker::enterScope(AllocationTracker::scopeIndex(name)))
+    {
+    }
+
+    ~AllocationScope()
+    {
+        AllocationTracker::leaveScope(previous);
+    }
+
+private:
+    int previous;
+};
+
+#endif // ALLOCATIONTRACKER_H
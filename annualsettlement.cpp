@@ -0,0 +1,265 @@
+﻿#include "annualsettlement.h"
+#include "payrollledger.h"     // 年度分区表名
+#include "taxcalccenter.h"     // 年度税率表的批量计算
+#include "metricsregistry.h"   // 汇算耗时统计
+#include "tracerecorder.h"     // 时间线区间
+#include "slowquerylog.h"      // 慢查询日志与执行计划
+#include "databasemaintenance.h" // 改动行数统计
+#include "jobscheduler.h"      // 分块并行计算
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+
+namespace
+{
+    // 并行计算时每块的员工数，块足够大时线程调度的开销可以忽略
+    const int ChunkSize = 16384;
+
+    // 按操作区分的耗时直方图
+    MetricsHistogram& settlementLatency(const char* operation)
+    {
+        return MetricsRegistry::instance().histogram("wagestax_settlement_ns",
+            QString("operation=\"%1\"").arg(operation), "AnnualSettlement operation latency in nanoseconds");
+    }
+}
+
+// AnnualSettlement 构造函数
+AnnualSettlement::AnnualSettlement(const QString& connectionName)
+    : connection(connectionName)
+{
+
+}
+
+// 打开数据库并创建汇算结果表
+bool AnnualSettlement::open()
+{
+    if (!connection.open())
+    {
+        return false;
+    }
+
+    // 按 (年度, 员工) 组织；按应补/应退金额排序的查询使用表达式索引
+    QSqlQuery query(connection.database());
+    if (!query.exec("CREATE TABLE IF NOT EXISTS annual_settlement ("
+            "year INTEGER NOT NULL, "
+            "employee_id INTEGER NOT NULL, "
+            "name TEXT NOT NULL, "
+            "months INTEGER NOT NULL, "
+            "income REAL NOT NULL, "
+            "withheld REAL NOT NULL, "
+            "liability REAL NOT NULL, "
+            "balance REAL NOT NULL, "
+            "PRIMARY KEY (year, employee_id)) WITHOUT ROWID")
+        || !query.exec("CREATE INDEX IF NOT EXISTS idx_annual_settlement_balance ON annual_settlement (year, abs(balance))"))
+    {
+        qDebug() << "Failed to create annual_settlement:" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+// 关闭数据库
+void AnnualSettlement::close()
+{
+    connection.close();
+}
+
+// 并行计算年度应纳税额，每块写入各自的输出区间，线程之间没有共享的写入
+void AnnualSettlement::computeLiabilities(const double* incomes, const double* deductions, double* liabilities, int count)
+{
+    const int chunks = (count + ChunkSize - 1) / ChunkSize;
+    JobScheduler::instance().parallelFor("settlement_chunk", chunks, [=](int chunk) {
+        const int begin = chunk * ChunkSize;
+        TaxCalcCenter::calculateAnnualTaxBatch(incomes + begin, deductions + begin, liabilities + begin,
+            qMin(ChunkSize, count - begin));
+    });
+}
+
+// 执行年度汇算
+AnnualSettlement::Summary AnnualSettlement::settle(int year, SqlManager& source, QString* error)
+{
+    static MetricsHistogram& latency = settlementLatency("settle");
+    ScopedLatency timer(latency);
+    TraceSpan span("AnnualSettlement::settle", "sql");
+
+    Summary summary;
+    if (year < 1000 || year > 9999)
+    {
+        SqlManager::reportError(error, "Annual settlement", QString::fromLocal8Bit("年度格式应为 YYYY"));
+        return summary;
+    }
+
+    // 读取在来源连接的一个读事务中进行，期数和各期结果来自同一时刻的数据，不阻塞写入
+    QSqlDatabase sourceDb = source.database();
+    const bool reading = sourceDb.transaction();
+    auto endRead = [&]() {
+        if (reading)
+        {
+            sourceDb.commit();
+        }
+    };
+
+    // 该年度的期数；分区表在第一次核算时创建，没有核算记录的年度无法汇算
+    const QString yearText = QString::number(year);
+    int periods = 0;
+    int openPeriods = 0;
+    {
+        QSqlQuery count(sourceDb);
+        count.prepare("SELECT COUNT(*), SUM(status = 'open') FROM payroll_run WHERE period LIKE ?");
+        count.addBindValue(yearText + "-%");
+        if (!count.exec() || !count.next() || count.value(0).toInt() == 0)
+        {
+            count.finish();
+            endRead();
+            SqlManager::reportError(error, "Annual settlement", QString::fromLocal8Bit("%1 年没有工资核算记录").arg(year));
+            return summary;
+        }
+        periods = count.value(0).toInt();
+        openPeriods = count.value(1).toInt();
+    }
+
+    // 读取：一次 GROUP BY 得到连续的列，姓名取自该员工 run_id 最大（最后创建）的一期
+    std::vector<int> ids;
+    std::vector<int> months;
+    std::vector<QString> names;
+    std::vector<double> incomes;
+    std::vector<double> deductions;
+    std::vector<double> withheld;
+    {
+        TraceSpan readSpan("AnnualSettlement::read", "sql");
+        QSqlQuery read(sourceDb);
+        QueryProbe probe(read, sourceDb);
+        read.setForwardOnly(true);
+        if (!read.exec(QString("SELECT employee_id, COUNT(*), SUM(salary), SUM(tax), name, MAX(run_id), SUM(deduction) "
+                "FROM %1 GROUP BY employee_id").arg(PayrollLedger::partitionFor(yearText + "-01"))))
+        {
+            SqlManager::reportError(error, "Annual settlement", read.lastError().text());
+            read.finish();
+            endRead();
+            return summary;
+        }
+        while (read.next())
+        {
+            ids.push_back(read.value(0).toInt());
+            months.push_back(read.value(1).toInt());
+            incomes.push_back(read.value(2).toDouble());
+            withheld.push_back(read.value(3).toDouble());
+            names.push_back(read.value(4).toString());
+            deductions.push_back(read.value(6).toDouble());
+        }
+        probe.setRows(int(ids.size()));
+    }
+    endRead();
+
+    // 计算：按块并行
+    const int count = int(ids.size());
+    std::vector<double> liabilities(ids.size());
+    {
+        TraceSpan computeSpan("AnnualSettlement::compute", "worker");
+        computeLiabilities(incomes.data(), deductions.data(), liabilities.data(), count);
+    }
+
+    // 写入：一个事务，先删除该年度旧结果（主键前缀范围删除），插入语句只准备一次
+    TraceSpan writeSpan("AnnualSettlement::write", "sql");
+    QSqlDatabase db = connection.database();
+    QSqlQuery query(db);
+    if (!db.transaction())
+    {
+        SqlManager::reportError(error, "Annual settlement", db.lastError().text());
+        return summary;
+    }
+    query.prepare("DELETE FROM annual_settlement WHERE year = ?");
+    query.addBindValue(year);
+    if (!query.exec())
+    {
+        SqlManager::reportError(error, "Annual settlement", query.lastError().text());
+        db.rollback();
+        return summary;
+    }
+    DatabaseMaintenance::recordChurn(query.numRowsAffected());
+
+    QSqlQuery insert(db);
+    insert.prepare("INSERT INTO annual_settlement (year, employee_id, name, months, income, withheld, liability, balance) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?)");
+    Summary totals;
+    for (int i = 0; i < count; ++i)
+    {
+        const double balance = liabilities[i] - withheld[i];
+        insert.bindValue(0, year);
+        insert.bindValue(1, ids[i]);
+        insert.bindValue(2, names[i]);
+        insert.bindValue(3, months[i]);
+        insert.bindValue(4, incomes[i]);
+        insert.bindValue(5, withheld[i]);
+        insert.bindValue(6, liabilities[i]);
+        insert.bindValue(7, balance);
+        if (!insert.exec())
+        {
+            SqlManager::reportError(error, "Annual settlement", insert.lastError().text());
+            insert.finish();
+            db.rollback();
+            return summary;
+        }
+
+        totals.totalIncome += incomes[i];
+        totals.totalWithheld += withheld[i];
+        totals.totalLiability += liabilities[i];
+        if (balance > 0)
+        {
+            totals.totalDue += balance;
+        }
+        else
+        {
+            totals.totalRefund -= balance;
+        }
+    }
+    insert.finish();
+    if (!db.commit())
+    {
+        SqlManager::reportError(error, "Annual settlement", db.lastError().text());
+        db.rollback();
+        return summary;
+    }
+
+    summary = totals;
+    summary.year = year;
+    summary.periods = periods;
+    summary.openPeriods = openPeriods;
+    summary.headcount = count;
+    summary.elapsedMs = timer.elapsedNs() / 1000000;
+    qDebug() << "Annual settlement" << year << "finished:" << count << "employees in" << summary.elapsedMs << "ms";
+    return summary;
+}
+
+// 已保存的汇算结果
+std::vector<AnnualSettlement::Entry> AnnualSettlement::results(int year, int limit)
+{
+    static MetricsHistogram& latency = settlementLatency("results");
+    ScopedLatency timer(latency);
+    std::vector<Entry> result;
+    QSqlQuery query(connection.database());
+    QueryProbe probe(query, connection.database());
+    query.prepare("SELECT employee_id, name, months, income, withheld, liability FROM annual_settlement "
+        "WHERE year = ? ORDER BY abs(balance) DESC LIMIT ?");
+    query.addBindValue(year);
+    query.addBindValue(limit);
+    if (!query.exec())
+    {
+        qDebug() << "Annual settlement query failed:" << query.lastError().text();
+        return result;
+    }
+    while (query.next())
+    {
+        Entry entry;
+        entry.employeeId = query.value(0).toInt();
+        entry.name = query.value(1).toString();
+        entry.months = query.value(2).toInt();
+        entry.income = query.value(3).toDouble();
+        entry.withheld = query.value(4).toDouble();
+        entry.liability = query.value(5).toDouble();
+        result.push_back(entry);
+    }
+    probe.setRows(int(result.size()));
+    return result;
+}
@@ -0,0 +1,76 @@
+﻿#ifndef ANNUALSETTLEMENT_H
+#define ANNUALSETTLEMENT_H
+
+#include <QString>
+#include <vector>
+#include "sqlmanager.h"
+
+// AnnualSettlement 类执行年度汇算：
+// 把一年中各期工资核算（PayrollLedger）的结果按员工汇总为全年收入和已预扣税额，
+// 用年度税率表计算全年应纳税额，差额即应补（正数）或应退（负数）的税款。
+//   - 读取：在调用方给出的连接（通常是报表快照）的一个读事务中，对该年度分区做一次 GROUP BY employee_id，
+//     得到员工 ID、全年收入、全年专项扣除、已预扣税额等连续数组；
+//   - 计算：数组按块分给线程池，每块调用一次 TaxCalcCenter::calculateAnnualTaxBatch；
+//   - 写入：在一个事务中替换 annual_settlement 表中该年度的全部结果。
+class AnnualSettlement
+{
+public:
+    // 一名员工的汇算结果
+    struct Entry
+    {
+        int employeeId = 0;       // 员工 ID
+        QString name;             // 最近一期核算时的姓名
+        int months = 0;           // 参与核算的期数
+        double income = 0;        // 全年收入
+        double withheld = 0;      // 已预扣税额
+        double liability = 0;     // 全年应纳税额
+        double balance() const { return liability - withheld; }  // 正数应补，负数应退
+    };
+
+    // 一个年度的汇算合计
+    struct Summary
+    {
+        int year = 0;             // 年度
+        int periods = 0;          // 该年度已核算的期数
+        int openPeriods = 0;      // 其中尚未结账的期数
+        int headcount = 0;        // 人数
+        double totalIncome = 0;   // 收入合计
+        double totalWithheld = 0; // 已预扣合计
+        double totalLiability = 0; // 应纳税额合计
+        double totalDue = 0;      // 应补税额合计
+        double totalRefund = 0;   // 应退税额合计（正数）
+        qint64 elapsedMs = 0;     // 耗时（毫秒）
+    };
+
+    // 构造函数
+    // 参数:
+    //   - connectionName: 使用的数据库连接名（线程规则见 SqlManager 构造函数）
+    explicit AnnualSettlement(const QString& connectionName = "wagestax_settlement");
+
+    // 打开数据库并创建 annual_settlement 表（已存在时跳过），返回是否成功
+    bool open();
+
+    // 关闭并移除数据库连接
+    void close();
+
+    // settle 函数对一个年度执行汇算并保存结果，重复执行会替换该年度的旧结果
+    // 核算记录从 source 读取（通常是报表快照），写锁只在保存结果期间持有
+    // 参数:
+    //   - year: 年度
+    //   - source: 读取 payroll_run 和年度分区的连接
+    //   - error: 失败时写入原因（可以为空）
+    // 返回值：汇算合计，失败时 year 为 0
+    Summary settle(int year, SqlManager& source, QString* error = nullptr);
+
+    // results 函数返回已保存的汇算结果，按应补或应退金额的绝对值从大到小排列
+    std::vector<Entry> results(int year, int limit);
+
+    // computeLiabilities 函数并行计算年度应纳税额，incomes、deductions 和 liabilities 长度均为 count
+    static void computeLiabilities(const double* incomes, const double* deductions, double* liabilities, int count);
+
+private:
+    // 数据库连接，与工资核算结果位于同一个数据库
+    SqlManager connection;
+};
+
+#endif // ANNUALSETTLEMENT_H
@@ -0,0 +1,173 @@
+﻿#include "bonusoptimizer.h"
+#include "employeestore.h"     // 员工数据来源
+#include "taxcalccenter.h"     // 税率表与批量计税
+#include "metricsregistry.h"   // 优化耗时统计
+#include "tracerecorder.h"     // 时间线区间
+#include "jobscheduler.h"      // 分块并行计算
+#include <QDebug>
+
+namespace
+{
+    // 每页读取的员工数
+    const int PageSize = 4096;
+
+    // 并行计算时每块的员工数，每名员工有 CandidateCount（19）个候选值，
+    // 一块的 5 个临时数组共 8192 × 19 × 5 × 8 字节，约 6.2 MB
+    const int ChunkSize = 8192;
+}
+
+const int BonusOptimizer::CandidateCount = 2 * TaxCalcCenter::BracketCount + 1;
+
+// 一名员工的候选奖金额
+void BonusOptimizer::candidates(double package, double deduction, double* out)
+{
+    // 税率表在两次读取之间被替换时，该员工的候选值可能不是新表的边界，只影响这一次结果是否最优，不影响税额本身
+    const TaxSchedule& table = TaxCalcCenter::schedule();
+    int n = 0;
+    out[n++] = 0;
+    out[n++] = package;
+
+    // 奖金侧：月均奖金恰好等于第 k 档下限时仍按第 k - 1 档计税
+    for (int k = 1; k < TaxCalcCenter::BracketCount; ++k)
+    {
+        out[n++] = 12 * table.lower[k];
+    }
+
+    // 工资侧：全年应纳税所得额恰好等于年度第 k 档下限
+    const double exempt = 12 * table.threshold + deduction;
+    for (int k = 0; k < TaxCalcCenter::BracketCount; ++k)
+    {
+        out[n++] = package - exempt - 12 * table.lower[k];
+    }
+
+    for (int i = 0; i < n; ++i)
+    {
+        out[i] = out[i] < 0 ? 0 : out[i];
+        out[i] = out[i] > package ? package : out[i];
+    }
+}
+
+// 在当前线程中求最优拆分
+void BonusOptimizer::optimizeBatch(Plan* plans, int count)
+{
+    const int total = count * CandidateCount;
+    std::vector<double> bonuses(total);
+    std::vector<double> salaries(total);
+    std::vector<double> deductions(total);
+    std::vector<double> bonusTaxes(total);
+    std::vector<double> salaryTaxes(total);
+
+    for (int i = 0; i < count; ++i)
+    {
+        double* candidate = bonuses.data() + i * CandidateCount;
+        candidates(plans[i].package, plans[i].deduction, candidate);
+        for (int j = 0; j < CandidateCount; ++j)
+        {
+            salaries[i * CandidateCount + j] = plans[i].package - candidate[j];
+            deductions[i * CandidateCount + j] = plans[i].deduction;
+        }
+    }
+
+    // 全部候选值各调用一次批量计税
+    TaxCalcCenter::calculateBonusTaxBatch(bonuses.data(), bonusTaxes.data(), total);
+    TaxCalcCenter::calculateAnnualTaxBatch(salaries.data(), deductions.data(), salaryTaxes.data(), total);
+
+    for (int i = 0; i < count; ++i)
+    {
+        // 第一个候选值是全部发工资；税额相同时保留靠前的候选值，不为零收益改变发放方式
+        const int base = i * CandidateCount;
+        int best = base;
+        for (int j = base + 1; j < base + CandidateCount; ++j)
+        {
+            if (salaryTaxes[j] + bonusTaxes[j] < salaryTaxes[best] + bonusTaxes[best] - 0.005)
+            {
+                best = j;
+            }
+        }
+
+        Plan& plan = plans[i];
+        plan.baselineTax = salaryTaxes[base] + bonusTaxes[base];
+        plan.bonus = bonuses[best];
+        plan.salaryTax = salaryTaxes[best];
+        plan.bonusTax = bonusTaxes[best];
+    }
+}
+
+// 并行求最优拆分
+void BonusOptimizer::optimize(std::vector<Plan>& plans)
+{
+    Plan* data = plans.data();
+    const int count = int(plans.size());
+    const int chunks = (count + ChunkSize - 1) / ChunkSize;
+    JobScheduler::instance().parallelFor("bonus_optimizer_chunk", chunks, [=](int chunk) {
+        const int begin = chunk * ChunkSize;
+        optimizeBatch(data + begin, qMin(ChunkSize, count - begin));
+    });
+}
+
+// 为全公司求最优拆分
+BonusOptimizer::Summary BonusOptimizer::run(EmployeeStore& source, std::vector<Plan>& plans, QString* error)
+{
+    static MetricsHistogram& latency = MetricsRegistry::instance().histogram("wagestax_bonus_optimizer_ns",
+        QString(), "BonusOptimizer::run latency in nanoseconds");
+    ScopedLatency timer(latency);
+    TraceSpan span("BonusOptimizer::run", "worker");
+
+    Summary summary;
+    plans.clear();
+
+    // 读取：按主键分页取出全部员工
+    {
+        TraceSpan readSpan("BonusOptimizer::read", "sql");
+        int lastId = 0;
+        for (;;)
+        {
+            std::vector<EmployeeRecord> page = source.queryRecordsAfter(lastId, PageSize);
+            if (page.empty())
+            {
+                break;
+            }
+            lastId = page.back().id;
+
+            for (const EmployeeRecord& record : page)
+            {
+                Plan plan;
+                plan.employeeId = record.id;
+                plan.name = record.name;
+                plan.package = record.salary * 12;
+                plan.deduction = record.deduction * 12;
+                plans.push_back(plan);
+            }
+
+            if (int(page.size()) < PageSize)
+            {
+                break;
+            }
+        }
+    }
+
+    if (plans.empty())
+    {
+        if (error)
+        {
+            *error = QString::fromLocal8Bit("没有员工数据");
+        }
+        return summary;
+    }
+
+    optimize(plans);
+
+    summary.headcount = int(plans.size());
+    for (const Plan& plan : plans)
+    {
+        summary.improved += plan.saving() > 0 ? 1 : 0;
+        summary.totalPackage += plan.package;
+        summary.totalBonus += plan.bonus;
+        summary.totalBaselineTax += plan.baselineTax;
+        summary.totalOptimizedTax += plan.totalTax();
+    }
+    summary.elapsedMs = timer.elapsedNs() / 1000000;
+    qDebug() << "Bonus optimizer finished:" << summary.headcount << "employees," << summary.improved
+             << "improved in" << summary.elapsedMs << "ms";
+    return summary;
+}
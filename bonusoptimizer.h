@@ -0,0 +1,72 @@
+﻿#ifndef BONUSOPTIMIZER_H
+#define BONUSOPTIMIZER_H
+
+#include <QString>
+#include <vector>
+
+class EmployeeStore;
+
+// BonusOptimizer 类为每名员工寻找年终奖与工资之间使总税额最小的拆分方式。
+// 年薪总额（package）拆成全年一次性奖金 B 和工资 package - B 两部分：
+//   - 工资部分与专项扣除一起按年度税率表计税（TaxCalcCenter::calculateAnnualTaxBatch）；
+//   - 奖金部分单独计税：B / 12 确定税率和速算扣除数，税额 = B × 税率 - 速算扣除数（TaxCalcCenter::calculateBonusTaxBatch）。
+// 两部分税额都是 B 的分段线性函数，奖金税额在档位边界处向上跳变，边界之上的一段区间多发奖金反而到手更少（“盲区”）。
+// 分段线性函数的最小值只可能出现在分段端点上，而跳变是向上的，每一段的最优点都落在“恰好不超过边界”的位置，
+// 因此只需比较以下候选值，不需要逐个金额扫描：
+//   - 全部发工资（B = 0）和全部发奖金（B = package）；
+//   - 奖金恰好位于各档上沿：B = 12 × 第 k 档下限；
+//   - 工资恰好位于年度各档上沿：package - B = 12 × (起征点 + 第 k 档下限) + 全年专项扣除。
+// 超出 [0, package] 的候选值截断到端点。全公司的员工按块分给线程池，每块把全部候选值一次性交给批量计税函数。
+class BonusOptimizer
+{
+public:
+    // 每名员工比较的候选值个数：两个端点，奖金侧 BracketCount - 1 个边界，工资侧 BracketCount 个边界
+    static const int CandidateCount;
+
+    // 一名员工的拆分方案，package 和 deduction 是输入，其余由 optimize 填写
+    struct Plan
+    {
+        int employeeId = 0;       // 员工 ID
+        QString name;             // 姓名
+        double package = 0;       // 年薪总额
+        double deduction = 0;     // 全年专项扣除
+        double bonus = 0;         // 最优方案中的年终奖
+        double salaryTax = 0;     // 最优方案中工资部分的税额
+        double bonusTax = 0;      // 最优方案中奖金部分的税额
+        double baselineTax = 0;   // 全部按工资发放时的税额
+        double salary() const { return package - bonus; }
+        double totalTax() const { return salaryTax + bonusTax; }
+        double saving() const { return baselineTax - totalTax(); }
+    };
+
+    // 全公司的优化合计
+    struct Summary
+    {
+        int headcount = -1;           // 人数，失败时为 -1
+        int improved = 0;             // 拆分后税额下降的人数
+        double totalPackage = 0;      // 年薪合计
+        double totalBonus = 0;        // 年终奖合计
+        double totalBaselineTax = 0;  // 全部按工资发放时的税额合计
+        double totalOptimizedTax = 0; // 最优拆分的税额合计
+        qint64 elapsedMs = 0;         // 耗时（毫秒）
+    };
+
+    // candidates 函数写出一名员工的候选奖金额（已截断到 [0, package]），out 的长度为 CandidateCount
+    static void candidates(double package, double deduction, double* out);
+
+    // optimizeBatch 函数在当前线程中为 count 名员工求最优拆分
+    static void optimizeBatch(Plan* plans, int count);
+
+    // optimize 函数把 plans 按块分给线程池并行求最优拆分
+    static void optimize(std::vector<Plan>& plans);
+
+    // run 函数以员工当前月薪的 12 倍作为年薪总额、月度专项扣除的 12 倍作为全年专项扣除，为全公司求最优拆分
+    // 参数:
+    //   - source: 员工数据来源
+    //   - plans: 输出全部员工的方案，按员工 ID 排列
+    //   - error: 失败时写入原因（可以为空）
+    // 返回值：合计，失败时 headcount 为 -1
+    static Summary run(EmployeeStore& source, std::vector<Plan>& plans, QString* error = nullptr);
+};
+
+#endif // BONUSOPTIMIZER_H
@@ -0,0 +1,147 @@
+﻿#include "changepassworddialog.h"
+#include "credentialstore.h"  // 账号验证与保存
+#include "jobscheduler.h"     // 后台任务
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+
+namespace
+{
+    // 后台修改使用的连接名
+    const char* WorkerConnection = "wagestax_password_worker";
+
+    // 新密码的最小长度，与登录对话框的检查一致
+    const int MinimumLength = 6;
+
+    // 创建密码输入框
+    QLineEdit* createPasswordInput(QWidget* parent)
+    {
+        QLineEdit* input = new QLineEdit(parent);
+        input->setEchoMode(QLineEdit::Password);
+        return input;
+    }
+}
+
+// ChangePasswordDialog 构造函数，创建界面
+ChangePasswordDialog::ChangePasswordDialog(const QString& username, const QString& token, QWidget* parent)
+    : QDialog(parent)
+    , username(username)
+    , token(token)
+    , currentLabel(new QLabel(QString::fromLocal8Bit("当前密码"), this))
+    , currentPassword(createPasswordInput(this))
+    , newPassword(createPasswordInput(this))
+    , confirmPassword(createPasswordInput(this))
+    , status(new QLabel(this))
+    , buttons(new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, this))
+{
+    setWindowTitle(QString::fromLocal8Bit("修改密码 - %1").arg(username));
+
+    QFormLayout* layout = new QFormLayout(this);
+    layout->addRow(currentLabel, currentPassword);
+    layout->addRow(QString::fromLocal8Bit("新密码"), newPassword);
+    layout->addRow(QString::fromLocal8Bit("确认新密码"), confirmPassword);
+    layout->addRow(status);
+    layout->addRow(buttons);
+
+    // 会话仍然有效时不必再输入当前密码
+    QString tokenUser;
+    const bool fresh = CredentialStore::validateToken(token, &tokenUser) && tokenUser == username;
+    setCurrentPasswordVisible(!fresh);
+    status->setText(fresh ? QString::fromLocal8Bit("本次登录已验证，无需再次输入当前密码。") : QString());
+
+    connect(buttons, &QDialogButtonBox::accepted, this, &ChangePasswordDialog::submit);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    connect(&watcher, &QFutureWatcher<Outcome>::finished, this, &ChangePasswordDialog::onChangeFinished);
+}
+
+// ChangePasswordDialog 析构函数
+ChangePasswordDialog::~ChangePasswordDialog()
+{
+    watcher.waitForFinished();
+}
+
+// 新会话令牌
+QString ChangePasswordDialog::sessionToken() const
+{
+    return token;
+}
+
+// 显示或隐藏当前密码一行
+void ChangePasswordDialog::setCurrentPasswordVisible(bool visible)
+{
+    currentLabel->setVisible(visible);
+    currentPassword->setVisible(visible);
+}
+
+// 检查输入后在后台修改
+void ChangePasswordDialog::submit()
+{
+    if (watcher.isRunning())
+    {
+        return;
+    }
+    if (newPassword->text().length() < MinimumLength)
+    {
+        status->setText(QString::fromLocal8Bit("新密码至少 %1 个字符。").arg(MinimumLength));
+        return;
+    }
+    if (newPassword->text() != confirmPassword->text())
+    {
+        status->setText(QString::fromLocal8Bit("两次输入的新密码不一致。"));
+        return;
+    }
+
+    // 对话框打开期间会话可能已经过期，此时改为要求输入当前密码
+    QString tokenUser;
+    const bool fresh = CredentialStore::validateToken(token, &tokenUser) && tokenUser == username;
+    if (!fresh && currentPassword->isHidden())
+    {
+        setCurrentPasswordVisible(true);
+        currentPassword->setFocus();
+        status->setText(QString::fromLocal8Bit("会话已过期，请输入当前密码。"));
+        return;
+    }
+
+    buttons->button(QDialogButtonBox::Ok)->setEnabled(false);
+    status->setText(QString::fromLocal8Bit("正在保存 ..."));
+
+    const QString account = username;
+    const QString current = fresh ? QString() : currentPassword->text();
+    const QString replacement = newPassword->text();
+    watcher.setFuture(JobScheduler::instance().run<Outcome>("change_password", JobScheduler::High, [account, current, replacement, fresh]() {
+        Outcome outcome;
+        CredentialStore store(WorkerConnection);
+        if (!store.open())
+        {
+            outcome.error = QString::fromLocal8Bit("无法打开数据库");
+        }
+        else if (!fresh && !store.verify(account, current).accepted)
+        {
+            outcome.error = QString::fromLocal8Bit("当前密码错误。");
+        }
+        else if (store.setPassword(account, replacement, &outcome.error))
+        {
+            // 修改密码使该账号原有的会话全部失效，用新密码重新发放令牌
+            outcome.changed = true;
+            outcome.token = store.verify(account, replacement).token;
+        }
+        store.close();
+        return outcome;
+    }));
+}
+
+// 后台修改完成
+void ChangePasswordDialog::onChangeFinished()
+{
+    buttons->button(QDialogButtonBox::Ok)->setEnabled(true);
+    Outcome outcome = watcher.result();
+    if (!outcome.changed)
+    {
+        status->setText(outcome.error);
+        return;
+    }
+    token = outcome.token;
+    accept();
+}
@@ -0,0 +1,64 @@
+﻿#ifndef CHANGEPASSWORDDIALOG_H
+#define CHANGEPASSWORDDIALOG_H
+
+#include <QDialog>
+#include <QFutureWatcher>
+
+class QDialogButtonBox;
+class QLabel;
+class QLineEdit;
+
+// ChangePasswordDialog 类用于修改当前登录账号的密码。
+// 会话令牌仍在有效期内（刚登录不久）时不必再次输入当前密码，令牌过期后需要输入当前密码重新验证。
+// 验证和派生新哈希都在后台线程进行；修改成功后该账号原有的会话全部失效，对话框用新密码重新发放令牌。
+class ChangePasswordDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    // 构造函数
+    // 参数:
+    //   - username: 当前登录的账号
+    //   - token: 登录时发放的会话令牌
+    ChangePasswordDialog(const QString& username, const QString& token, QWidget* parent = nullptr);
+
+    // 析构函数，等待正在进行的修改结束
+    ~ChangePasswordDialog();
+
+    // 修改成功后的新会话令牌
+    QString sessionToken() const;
+
+private slots:
+    // 点击确定：检查输入后在后台修改
+    void submit();
+
+    // 后台修改完成
+    void onChangeFinished();
+
+private:
+    // 后台修改的结果
+    struct Outcome
+    {
+        bool changed = false;
+        QString token;
+        QString error;
+    };
+
+    // 显示或隐藏当前密码一行
+    void setCurrentPasswordVisible(bool visible);
+
+    QString username;
+    QString token;
+
+    QLabel* currentLabel;
+    QLineEdit* currentPassword;
+    QLineEdit* newPassword;
+    QLineEdit* confirmPassword;
+    QLabel* status;
+    QDialogButtonBox* buttons;
+
+    // 后台修改任务
+    QFutureWatcher<Outcome> watcher;
+};
+
+#endif // CHANGEPASSWORDDIALOG_H
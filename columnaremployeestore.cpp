@@ -0,0 +1,461 @@
+﻿#include "columnaremployeestore.h"
+#include "sqlmanager.h"       // 统一的显示格式
+#include "taxcalccenter.h"    // 计税
+#include "metricsregistry.h"  // 操作耗时统计
+#include "tracerecorder.h"    // 时间线区间
+#include <algorithm>
+
+namespace
+{
+    // 按操作类型区分的耗时直方图
+    MetricsHistogram& operationLatency(const char* operation)
+    {
+        return MetricsRegistry::instance().histogram("wagestax_columnar_op_ns",
+            QString("operation=\"%1\"").arg(operation), "ColumnarEmployeeStore operation latency in nanoseconds");
+    }
+}
+
+// 进程内共享的表
+ColumnarEmployeeStore::Table& ColumnarEmployeeStore::table()
+{
+    static Table data;
+    return data;
+}
+
+// 二分查找 ID 所在的行
+int ColumnarEmployeeStore::rowOf(const Table& data, int id)
+{
+    auto it = std::lower_bound(data.ids.begin(), data.ids.end(), id);
+    if (it == data.ids.end() || *it != id)
+    {
+        return -1;
+    }
+    return int(it - data.ids.begin());
+}
+
+// 满足范围条件的行号，先检查工资列再检查税额列
+std::vector<size_t> ColumnarEmployeeStore::matchingRows(const Table& data, const EmployeeQuery& query)
+{
+    std::vector<size_t> rows;
+    bool filterSalary = !query.salary.isUnbounded();
+    bool filterTax = !query.tax.isUnbounded();
+    for (size_t row = 0; row < data.ids.size(); ++row)
+    {
+        if ((!filterSalary || query.salary.contains(data.salaries[row]))
+            && (!filterTax || query.tax.contains(data.taxes[row])))
+        {
+            rows.push_back(row);
+        }
+    }
+    return rows;
+}
+
+// 格式化一行
+std::pair<int, QString> ColumnarEmployeeStore::formatRow(const Table& data, size_t row)
+{
+    return std::make_pair(data.ids[row],
+        SqlManager::formatEmployee(data.ids[row], data.names[row], data.salaries[row], data.taxes[row]));
+}
+
+// 内存存储无需打开
+bool ColumnarEmployeeStore::open()
+{
+    return true;
+}
+
+// 内存存储无需关闭，数据在进程运行期间一直保留
+void ColumnarEmployeeStore::close()
+{
+
+}
+
+// 添加一名员工
+bool ColumnarEmployeeStore::addEmployee(const QString& name, double salary)
+{
+    static MetricsHistogram& latency = operationLatency("insert");
+    ScopedLatency timer(latency);
+
+    double tax = TaxCalcCenter::calculateTax(salary);
+    Table& data = table();
+    int id = 0;
+    {
+        QWriteLocker locker(&data.lock);
+        id = data.nextId++;
+        data.ids.push_back(id);
+        data.names.push_back(name);
+        data.salaries.push_back(salary);
+        data.taxes.push_back(tax);
+        data.deductions.push_back(0);
+        data.summary.add(salary, 0, tax, 1);
+    }
+
+    // 在锁外通知，接收方可以立即回查
+    emit EmployeeStoreEvents::instance()->employeeSaved(id, name, salary, SqlManager::formatEmployee(id, name, salary, tax));
+    return true;
+}
+
+// 批量添加员工，税额直接写入税额列
+int ColumnarEmployeeStore::addEmployees(const std::vector<std::pair<QString, double>>& employees)
+{
+    static MetricsHistogram& latency = operationLatency("bulk_insert");
+    ScopedLatency timer(latency);
+    TraceSpan span("ColumnarEmployeeStore::addEmployees", "store");
+
+    Table& data = table();
+    size_t count = employees.size();
+    {
+        QWriteLocker locker(&data.lock);
+        size_t first = data.ids.size();
+
+        data.ids.reserve(first + count);
+        data.names.reserve(first + count);
+        data.salaries.reserve(first + count);
+        for (const auto& employee : employees)
+        {
+            data.ids.push_back(data.nextId++);
+            data.names.push_back(employee.first);
+            data.salaries.push_back(employee.second);
+        }
+
+        data.taxes.resize(first + count);
+        data.deductions.resize(first + count, 0);
+        TaxCalcCenter::calculateTaxBatch(data.salaries.data() + first, data.taxes.data() + first, int(count));
+        for (size_t row = first; row < first + count; ++row)
+        {
+            data.summary.add(data.salaries[row], 0, data.taxes[row], 1);
+        }
+    }
+
+    emit EmployeeStoreEvents::instance()->employeesReset();
+    return int(count);
+}
+
+// 修改员工并重新计税
+bool ColumnarEmployeeStore::updateEmployee(int id, const QString& name, double salary)
+{
+    static MetricsHistogram& latency = operationLatency("update");
+    ScopedLatency timer(latency);
+
+    double tax = 0;
+    Table& data = table();
+    {
+        QWriteLocker locker(&data.lock);
+        int row = rowOf(data, id);
+        if (row < 0)
+        {
+            return false;
+        }
+        tax = TaxCalcCenter::calculateTax(salary, data.deductions[size_t(row)]);
+        const double deduction = data.deductions[size_t(row)];
+        data.summary.add(data.salaries[size_t(row)], deduction, data.taxes[size_t(row)], -1);
+        data.summary.add(salary, deduction, tax, 1);
+        data.names[size_t(row)] = name;
+        data.salaries[size_t(row)] = salary;
+        data.taxes[size_t(row)] = tax;
+    }
+
+    emit EmployeeStoreEvents::instance()->employeeSaved(id, name, salary, SqlManager::formatEmployee(id, name, salary, tax));
+    return true;
+}
+
+// 员工的专项扣除
+EmployeeDeductions ColumnarEmployeeStore::deductions(int id)
+{
+    Table& data = table();
+    QReadLocker locker(&data.lock);
+    return data.deductionItems.value(id);
+}
+
+// 设置专项扣除并重新计税
+bool ColumnarEmployeeStore::setDeductions(int id, const EmployeeDeductions& deductions)
+{
+    static MetricsHistogram& latency = operationLatency("update_deductions");
+    ScopedLatency timer(latency);
+
+    Table& data = table();
+    QString name;
+    double salary = 0;
+    double tax = 0;
+    {
+        QWriteLocker locker(&data.lock);
+        int row = rowOf(data, id);
+        if (row < 0)
+        {
+            return false;
+        }
+        name = data.names[size_t(row)];
+        salary = data.salaries[size_t(row)];
+        tax = TaxCalcCenter::calculateTax(salary, deductions.total());
+        data.summary.add(salary, data.deductions[size_t(row)], data.taxes[size_t(row)], -1);
+        data.summary.add(salary, deductions.total(), tax, 1);
+        data.taxes[size_t(row)] = tax;
+        data.deductions[size_t(row)] = deductions.total();
+        data.deductionItems.insert(id, deductions);
+    }
+
+    emit EmployeeStoreEvents::instance()->employeeSaved(id, name, salary, SqlManager::formatEmployee(id, name, salary, tax));
+    return true;
+}
+
+// 删除员工
+bool ColumnarEmployeeStore::deleteEmployee(int id)
+{
+    static MetricsHistogram& latency = operationLatency("delete");
+    ScopedLatency timer(latency);
+
+    Table& data = table();
+    {
+        QWriteLocker locker(&data.lock);
+        int row = rowOf(data, id);
+        if (row < 0)
+        {
+            return false;
+        }
+        data.summary.add(data.salaries[size_t(row)], data.deductions[size_t(row)], data.taxes[size_t(row)], -1);
+        data.ids.erase(data.ids.begin() + row);
+        data.names.erase(data.names.begin() + row);
+        data.salaries.erase(data.salaries.begin() + row);
+        data.taxes.erase(data.taxes.begin() + row);
+        data.deductions.erase(data.deductions.begin() + row);
+        data.deductionItems.remove(id);
+    }
+
+    emit EmployeeStoreEvents::instance()->employeeRemoved(id);
+    return true;
+}
+
+// 删除全部员工
+void ColumnarEmployeeStore::clear()
+{
+    Table& data = table();
+    {
+        QWriteLocker locker(&data.lock);
+        data.ids.clear();
+        data.names.clear();
+        data.salaries.clear();
+        data.taxes.clear();
+        data.deductions.clear();
+        data.deductionItems.clear();
+        data.nextId = 1;
+        data.summary = PayrollSummary();
+    }
+
+    emit EmployeeStoreEvents::instance()->employeesReset();
+}
+
+// 查询全部员工
+std::vector<std::pair<int, QString>> ColumnarEmployeeStore::queryEmployees()
+{
+    static MetricsHistogram& latency = operationLatency("select_all");
+    ScopedLatency timer(latency);
+    TraceSpan span("ColumnarEmployeeStore::queryEmployees", "store");
+
+    Table& data = table();
+    QReadLocker locker(&data.lock);
+    std::vector<std::pair<int, QString>> result;
+    result.reserve(data.ids.size());
+    for (size_t row = 0; row < data.ids.size(); ++row)
+    {
+        result.push_back(formatRow(data, row));
+    }
+    return result;
+}
+
+// 按 ID 和/或姓名查询
+std::vector<std::pair<int, QString>> ColumnarEmployeeStore::queryEmployeeByIdOrName(int id, const QString& name)
+{
+    static MetricsHistogram& latency = operationLatency("select_by_id_or_name");
+    ScopedLatency timer(latency);
+
+    Table& data = table();
+    QReadLocker locker(&data.lock);
+    std::vector<std::pair<int, QString>> result;
+
+    // 指定 ID 时最多一行
+    if (id != -1)
+    {
+        int row = rowOf(data, id);
+        if (row >= 0 && (name.isEmpty() || data.names[size_t(row)] == name))
+        {
+            result.push_back(formatRow(data, size_t(row)));
+        }
+        return result;
+    }
+
+    // 只按姓名时扫描姓名列，两者都未指定时返回全部
+    for (size_t row = 0; row < data.ids.size(); ++row)
+    {
+        if (name.isEmpty() || data.names[row] == name)
+        {
+            result.push_back(formatRow(data, row));
+        }
+    }
+    return result;
+}
+
+// 按 ID 查询详细信息
+std::vector<std::tuple<int, QString, double>> ColumnarEmployeeStore::queryEmployeeByIdOrName(int id)
+{
+    static MetricsHistogram& latency = operationLatency("select_by_id");
+    ScopedLatency timer(latency);
+
+    Table& data = table();
+    QReadLocker locker(&data.lock);
+    std::vector<std::tuple<int, QString, double>> result;
+    if (id == -1)
+    {
+        for (size_t row = 0; row < data.ids.size(); ++row)
+        {
+            result.emplace_back(data.ids[row], data.names[row], data.salaries[row]);
+        }
+        return result;
+    }
+
+    int row = rowOf(data, id);
+    if (row >= 0)
+    {
+        result.emplace_back(data.ids[size_t(row)], data.names[size_t(row)], data.salaries[size_t(row)]);
+    }
+    return result;
+}
+
+// 按 ID 顺序分页查询
+std::vector<std::pair<int, QString>> ColumnarEmployeeStore::queryEmployeesAfter(int lastId, int limit)
+{
+    static MetricsHistogram& latency = operationLatency("select_page");
+    ScopedLatency timer(latency);
+
+    Table& data = table();
+    QReadLocker locker(&data.lock);
+    size_t row = size_t(std::upper_bound(data.ids.begin(), data.ids.end(), lastId) - data.ids.begin());
+    size_t end = qMin(data.ids.size(), row + size_t(qMax(0, limit)));
+
+    std::vector<std::pair<int, QString>> result;
+    result.reserve(end - row);
+    for (; row < end; ++row)
+    {
+        result.push_back(formatRow(data, row));
+    }
+    return result;
+}
+
+// 按排序和范围条件查询：过滤后只对前 limit 行做部分排序
+std::vector<std::pair<int, QString>> ColumnarEmployeeStore::queryEmployees(const EmployeeQuery& query)
+{
+    static MetricsHistogram& latency = operationLatency("select_spec");
+    ScopedLatency timer(latency);
+    TraceSpan span("ColumnarEmployeeStore::queryEmployees(spec)", "store");
+
+    Table& data = table();
+    QReadLocker locker(&data.lock);
+    std::vector<size_t> rows = matchingRows(data, query);
+
+    // 行号与 ID 同序，相同值之间按行号比较即按 ID 排序
+    auto less = [&data, &query](size_t left, size_t right) {
+        switch (query.sortKey)
+        {
+        case EmployeeQuery::ByName:
+            if (data.names[left] != data.names[right])
+            {
+                return data.names[left] < data.names[right];
+            }
+            break;
+        case EmployeeQuery::BySalary:
+            if (data.salaries[left] != data.salaries[right])
+            {
+                return data.salaries[left] < data.salaries[right];
+            }
+            break;
+        case EmployeeQuery::ByTax:
+            if (data.taxes[left] != data.taxes[right])
+            {
+                return data.taxes[left] < data.taxes[right];
+            }
+            break;
+        default:
+            break;
+        }
+        return left < right;
+    };
+
+    size_t count = qMin(rows.size(), size_t(qMax(0, query.limit)));
+    if (query.descending)
+    {
+        std::partial_sort(rows.begin(), rows.begin() + count, rows.end(),
+            [&less](size_t left, size_t right) { return less(right, left); });
+    }
+    else
+    {
+        std::partial_sort(rows.begin(), rows.begin() + count, rows.end(), less);
+    }
+
+    std::vector<std::pair<int, QString>> result;
+    result.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        result.push_back(formatRow(data, rows[i]));
+    }
+    return result;
+}
+
+// 统计满足范围条件的员工
+int ColumnarEmployeeStore::countEmployees(const EmployeeQuery& query)
+{
+    Table& data = table();
+    QReadLocker locker(&data.lock);
+    int count = 0;
+    for (size_t row = 0; row < data.ids.size(); ++row)
+    {
+        if (query.salary.contains(data.salaries[row]) && query.tax.contains(data.taxes[row]))
+        {
+            ++count;
+        }
+    }
+    return count;
+}
+
+// 按 ID 顺序分页查询完整数据
+std::vector<EmployeeRecord> ColumnarEmployeeStore::queryRecordsAfter(int lastId, int limit)
+{
+    static MetricsHistogram& latency = operationLatency("select_page");
+    ScopedLatency timer(latency);
+
+    Table& data = table();
+    QReadLocker locker(&data.lock);
+    size_t row = size_t(std::upper_bound(data.ids.begin(), data.ids.end(), lastId) - data.ids.begin());
+    size_t end = qMin(data.ids.size(), row + size_t(qMax(0, limit)));
+
+    std::vector<EmployeeRecord> result;
+    result.reserve(end - row);
+    for (; row < end; ++row)
+    {
+        EmployeeRecord record;
+        record.id = data.ids[row];
+        record.name = data.names[row];
+        record.salary = data.salaries[row];
+        record.tax = data.taxes[row];
+        record.deduction = data.deductions[row];
+        if (record.deduction != 0)
+        {
+            record.socialInsurance = data.deductionItems.value(record.id).socialInsurance;
+        }
+        result.push_back(record);
+    }
+    return result;
+}
+
+// 工资汇总
+PayrollSummary ColumnarEmployeeStore::payrollSummary()
+{
+    Table& data = table();
+    QReadLocker locker(&data.lock);
+    return data.summary;
+}
+
+// 员工总数
+int ColumnarEmployeeStore::countEmployees()
+{
+    Table& data = table();
+    QReadLocker locker(&data.lock);
+    return int(data.ids.size());
+}
@@ -0,0 +1,61 @@
+﻿#ifndef COLUMNAREMPLOYEESTORE_H
+#define COLUMNAREMPLOYEESTORE_H
+
+#include "employeestore.h"
+#include <QHash>
+#include <QReadWriteLock>
+
+// ColumnarEmployeeStore 类是不经过 SQL 的纯内存员工存储
+// 数据按列保存（ID、姓名、工资、税额、专项扣除合计各一个数组），ID 单调递增，按 ID 查找使用二分查找；
+// 批量添加时税额直接由 TaxCalcCenter::calculateTaxBatch 写入税额列。
+// 同一进程内的所有实例共享同一张表，由读写锁保护，界面线程和后台线程可以同时使用。
+class ColumnarEmployeeStore : public EmployeeStore
+{
+public:
+    bool open() override;
+    void close() override;
+    bool addEmployee(const QString& name, double salary) override;
+    int addEmployees(const std::vector<std::pair<QString, double>>& employees) override;
+    bool updateEmployee(int id, const QString& name, double salary) override;
+    EmployeeDeductions deductions(int id) override;
+    bool setDeductions(int id, const EmployeeDeductions& deductions) override;
+    bool deleteEmployee(int id) override;
+    void clear() override;
+    std::vector<std::pair<int, QString>> queryEmployees() override;
+    std::vector<std::pair<int, QString>> queryEmployeeByIdOrName(int id, const QString& name) override;
+    std::vector<std::tuple<int, QString, double>> queryEmployeeByIdOrName(int id) override;
+    std::vector<std::pair<int, QString>> queryEmployeesAfter(int lastId, int limit) override;
+    std::vector<std::pair<int, QString>> queryEmployees(const EmployeeQuery& query) override;
+    int countEmployees(const EmployeeQuery& query) override;
+    std::vector<EmployeeRecord> queryRecordsAfter(int lastId, int limit) override;
+    int countEmployees() override;
+    PayrollSummary payrollSummary() override;
+
+private:
+    // 进程内共享的列式表
+    struct Table
+    {
+        QReadWriteLock lock;
+        std::vector<int> ids;          // 按升序排列
+        std::vector<QString> names;
+        std::vector<double> salaries;
+        std::vector<double> taxes;
+        std::vector<double> deductions;   // 专项扣除合计，与工资列对齐，批量计税直接读取
+        QHash<int, EmployeeDeductions> deductionItems;  // 扣除明细，只保存设置过扣除的员工
+        int nextId = 1;
+        PayrollSummary summary;        // 每次增删改时增量更新
+    };
+
+    static Table& table();
+
+    // 按 ID 查找行号，不存在时返回 -1（调用方需持有锁）
+    static int rowOf(const Table& data, int id);
+
+    // 满足范围条件的行号（调用方需持有锁）
+    static std::vector<size_t> matchingRows(const Table& data, const EmployeeQuery& query);
+
+    // 格式化第 row 行（调用方需持有锁）
+    static std::pair<int, QString> formatRow(const Table& data, size_t row);
+};
+
+#endif // COLUMNAREMPLOYEESTORE_H
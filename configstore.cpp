@@ -0,0 +1,189 @@
+﻿#include "configstore.h"
+#include "watchedfile.h"  // 文件热加载监视
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QTextStream>
+
+// 全局实例
+ConfigStore& ConfigStore::instance()
+{
+    static ConfigStore store;
+    return store;
+}
+
+// 默认的配置文件
+QString ConfigStore::defaultPath()
+{
+    return "config.txt";
+}
+
+// ConfigStore 构造函数
+ConfigStore::ConfigStore()
+    : path(defaultPath())
+{
+
+}
+
+// 解析文件
+QHash<QString, QString> ConfigStore::parse(const QString& path, bool* exists)
+{
+    QHash<QString, QString> parsed;
+    QFile file(path);
+    *exists = file.open(QIODevice::ReadOnly | QIODevice::Text);
+    if (!*exists)
+    {
+        return parsed;
+    }
+
+    QTextStream in(&file);
+    in.setCodec("UTF-8");
+    while (!in.atEnd())
+    {
+        QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#'))
+        {
+            continue;
+        }
+        int separator = line.indexOf('=');
+        if (separator > 0)
+        {
+            parsed.insert(line.left(separator).trimmed(), line.mid(separator + 1).trimmed());
+        }
+    }
+    return parsed;
+}
+
+// 读取配置文件
+bool ConfigStore::load(const QString& configPath)
+{
+    bool exists = false;
+    QHash<QString, QString> parsed = parse(configPath, &exists);
+
+    QWriteLocker locker(&lock);
+    path = configPath;
+    entries.swap(parsed);
+    qDebug() << "Config" << configPath << (exists ? "loaded:" : "not found:") << entries.size() << "entries";
+    return exists;
+}
+
+// 开始监视
+void ConfigStore::watch()
+{
+    if (file)
+    {
+        return;
+    }
+
+    // 配置文件被修改、创建、替换或删除时重新读取
+    file = new WatchedFile(path, this);
+    file->markLoaded();
+    connect(file, &WatchedFile::changed, this, &ConfigStore::reload);
+    file->start();
+
+    // 全局实例在 QCoreApplication 之后才析构，监视器需要在事件循环结束时先释放
+    connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, [this]() {
+        delete file;
+        file = nullptr;
+    });
+}
+
+// 重新读取并通知变化的键
+void ConfigStore::reload()
+{
+    QHash<QString, QString> previous;
+    {
+        QReadLocker locker(&lock);
+        previous = entries;
+    }
+    load(path);
+    if (file)
+    {
+        file->markLoaded();
+    }
+
+    QStringList keys;
+    {
+        QReadLocker locker(&lock);
+        for (auto it = entries.constBegin(); it != entries.constEnd(); ++it)
+        {
+            if (!previous.contains(it.key()) || previous.value(it.key()) != it.value())
+            {
+                keys << it.key();
+            }
+        }
+        for (auto it = previous.constBegin(); it != previous.constEnd(); ++it)
+        {
+            if (!entries.contains(it.key()))
+            {
+                keys << it.key();
+            }
+        }
+    }
+    if (!keys.isEmpty())
+    {
+        keys.sort();
+        qDebug() << "Config changed:" << keys;
+        emit changed(keys);
+    }
+}
+
+// 是否存在某个键
+bool ConfigStore::contains(const QString& key) const
+{
+    QReadLocker locker(&lock);
+    return entries.contains(key);
+}
+
+// 字符串值
+QString ConfigStore::value(const QString& key, const QString& defaultValue) const
+{
+    QReadLocker locker(&lock);
+    return entries.value(key, defaultValue);
+}
+
+// 整数值
+int ConfigStore::intValue(const QString& key, int defaultValue) const
+{
+    bool ok = false;
+    int result = value(key).toInt(&ok);
+    return ok ? result : defaultValue;
+}
+
+// 浮点值
+double ConfigStore::doubleValue(const QString& key, double defaultValue) const
+{
+    bool ok = false;
+    double result = value(key).toDouble(&ok);
+    return ok ? result : defaultValue;
+}
+
+// 布尔值
+bool ConfigStore::boolValue(const QString& key, bool defaultValue) const
+{
+    const QString text = value(key).toLower();
+    if (text == "true" || text == "yes" || text == "on" || text == "1")
+    {
+        return true;
+    }
+    if (text == "false" || text == "no" || text == "off" || text == "0")
+    {
+        return false;
+    }
+    return defaultValue;
+}
+
+// 以 prefix 开头的配置项
+QHash<QString, QString> ConfigStore::section(const QString& prefix) const
+{
+    QHash<QString, QString> result;
+    QReadLocker locker(&lock);
+    for (auto it = entries.constBegin(); it != entries.constEnd(); ++it)
+    {
+        if (it.key().startsWith(prefix))
+        {
+            result.insert(it.key().mid(prefix.size()), it.value());
+        }
+    }
+    return result;
+}
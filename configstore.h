@@ -0,0 +1,78 @@
+﻿#ifndef CONFIGSTORE_H
+#define CONFIGSTORE_H
+
+#include <QHash>
+#include <QObject>
+#include <QReadWriteLock>
+#include <QString>
+#include <QStringList>
+
+class WatchedFile;
+
+// ConfigStore 类是程序唯一的配置来源：config.txt 只在启动和文件变化时完整读取一次，
+// 解析为“键 → 值”的哈希表，之后的查找都是 O(1)，不再逐行扫描文件。
+// 文件格式为每行 key=value，空行和以 # 开头的行忽略，同一个键出现多次时以最后一次为准。
+// 登录、数据库路径、SQLite PRAGMA（以 sqlite. 开头的键）和日志设置都从这里读取。
+// 查找可以在任意线程中进行；调用 watch 后文件变化会自动重新读取并发出 changed 信号，
+// 已经生效的设置（如存储后端）不会因此切换，PRAGMA 在之后新打开的连接上生效。
+class ConfigStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 全局实例
+    static ConfigStore& instance();
+
+    // 默认的配置文件
+    static QString defaultPath();
+
+    // load 函数读取配置文件并替换全部配置项，文件不存在时配置为空，返回文件是否存在
+    bool load(const QString& path = defaultPath());
+
+    // watch 函数开始监视当前配置文件，必须在有事件循环的线程（主线程）中调用
+    void watch();
+
+    // 是否存在某个键
+    bool contains(const QString& key) const;
+
+    // 字符串值，不存在时返回 defaultValue
+    QString value(const QString& key, const QString& defaultValue = QString()) const;
+
+    // 整数值，不存在或格式错误时返回 defaultValue
+    int intValue(const QString& key, int defaultValue = 0) const;
+
+    // 浮点值，不存在或格式错误时返回 defaultValue
+    double doubleValue(const QString& key, double defaultValue = 0) const;
+
+    // 布尔值，true/yes/on/1 为真，false/no/off/0 为假，其他情况返回 defaultValue
+    bool boolValue(const QString& key, bool defaultValue = false) const;
+
+    // section 函数返回以 prefix 开头的全部配置项，键中去掉 prefix
+    QHash<QString, QString> section(const QString& prefix) const;
+
+signals:
+    // 配置文件重新读取后发出，参数为新增、删除或值发生变化的键
+    void changed(const QStringList& keys);
+
+private slots:
+    // 重新读取并通知
+    void reload();
+
+private:
+    ConfigStore();
+
+    // 解析文件内容
+    static QHash<QString, QString> parse(const QString& path, bool* exists);
+
+    // 配置项，查找时持有读锁
+    mutable QReadWriteLock lock;
+    QHash<QString, QString> entries;
+
+    // 配置文件路径
+    QString path;
+
+    // 配置文件监视，watch 时创建，程序退出前释放
+    WatchedFile* file = nullptr;
+};
+
+#endif // CONFIGSTORE_H
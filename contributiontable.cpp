@@ -0,0 +1,120 @@
+﻿#include "contributiontable.h"
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+namespace
+{
+    // 读取 [a, b] 形式的数值对，格式错误时返回 false
+    bool readPair(const QJsonObject& object, const char* key, double& first, double& second)
+    {
+        QJsonArray pair = object.value(key).toArray();
+        if (pair.size() != 2 || !pair[0].isDouble() || !pair[1].isDouble())
+        {
+            return false;
+        }
+        first = pair[0].toDouble();
+        second = pair[1].toDouble();
+        return true;
+    }
+}
+
+// 默认的规则文件
+QString ContributionTable::defaultPath()
+{
+    return "city_contributions.json";
+}
+
+// 内置规则：常见的个人 8%/2%/0.5%/12%、单位 16%/9.8%/0.5%/12% 比例，基数不设上下限
+CityContribution ContributionTable::builtIn()
+{
+    CityContribution city;
+    city.city = QString::fromLocal8Bit("默认");
+    city.socialBaseFloor = 0;
+    city.socialBaseCeiling = 1e12;
+    city.housingBaseFloor = 0;
+    city.housingBaseCeiling = 1e12;
+    city.pensionEmployee = 0.08;
+    city.pensionEmployer = 0.16;
+    city.medicalEmployee = 0.02;
+    city.medicalEmployer = 0.098;
+    city.unemploymentEmployee = 0.005;
+    city.unemploymentEmployer = 0.005;
+    city.housingEmployee = 0.12;
+    city.housingEmployer = 0.12;
+    return city;
+}
+
+// 从文件加载
+bool ContributionTable::load(const QString& path, QString* error)
+{
+    auto fail = [&](const QString& message) {
+        qDebug() << "Contribution table" << path << ":" << message;
+        if (error)
+        {
+            *error = message;
+        }
+        return false;
+    };
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return fail(file.errorString());
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (document.isNull())
+    {
+        return fail(parseError.errorString());
+    }
+
+    std::vector<CityContribution> loaded;
+    for (const QJsonValue& value : document.object().value("cities").toArray())
+    {
+        QJsonObject object = value.toObject();
+        CityContribution city;
+        city.city = object.value("city").toString();
+        if (city.city.isEmpty()
+            || !readPair(object, "social_base", city.socialBaseFloor, city.socialBaseCeiling)
+            || !readPair(object, "housing_base", city.housingBaseFloor, city.housingBaseCeiling)
+            || !readPair(object, "pension", city.pensionEmployee, city.pensionEmployer)
+            || !readPair(object, "medical", city.medicalEmployee, city.medicalEmployer)
+            || !readPair(object, "unemployment", city.unemploymentEmployee, city.unemploymentEmployer)
+            || !readPair(object, "housing_fund", city.housingEmployee, city.housingEmployer))
+        {
+            return fail(QString("invalid entry #%1").arg(loaded.size() + 1));
+        }
+        loaded.push_back(city);
+    }
+    if (loaded.empty())
+    {
+        return fail("no cities");
+    }
+
+    entries.swap(loaded);
+    qDebug() << "Loaded contribution rules for" << entries.size() << "cities from" << path;
+    return true;
+}
+
+// 全部城市
+const std::vector<CityContribution>& ContributionTable::cities() const
+{
+    return entries;
+}
+
+// 按城市名查找
+const CityContribution* ContributionTable::find(const QString& city) const
+{
+    for (const CityContribution& entry : entries)
+    {
+        if (entry.city == city)
+        {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,57 @@
+﻿#ifndef CONTRIBUTIONTABLE_H
+#define CONTRIBUTIONTABLE_H
+
+#include <QString>
+#include <vector>
+
+// CityContribution 结构体是一个城市的社会保险和住房公积金缴费规则
+// 缴费基数为工资，但不低于下限、不高于上限；社会保险（养老、医疗、失业）共用一组上下限，住房公积金单独一组
+struct CityContribution
+{
+    QString city;
+
+    double socialBaseFloor = 0;      // 社会保险缴费基数下限
+    double socialBaseCeiling = 0;    // 社会保险缴费基数上限
+    double housingBaseFloor = 0;     // 住房公积金缴费基数下限
+    double housingBaseCeiling = 0;   // 住房公积金缴费基数上限
+
+    // 个人和单位的缴费比例
+    double pensionEmployee = 0;
+    double pensionEmployer = 0;
+    double medicalEmployee = 0;
+    double medicalEmployer = 0;
+    double unemploymentEmployee = 0;
+    double unemploymentEmployer = 0;
+    double housingEmployee = 0;
+    double housingEmployer = 0;
+};
+
+// ContributionTable 类保存从文件加载的各城市缴费规则
+// 文件为 JSON 格式，例如：
+// { "cities": [ { "city": "北京", "social_base": [6821, 35283], "housing_base": [2420, 35283],
+//                 "pension": [0.08, 0.16], "medical": [0.02, 0.098], "unemployment": [0.005, 0.005],
+//                 "housing_fund": [0.12, 0.12] } ] }
+// 其中 *_base 为 [下限, 上限]，各险种为 [个人比例, 单位比例]
+class ContributionTable
+{
+public:
+    // 默认的规则文件
+    static QString defaultPath();
+
+    // 从文件加载，成功时替换当前规则；失败时保留原有规则并写入原因
+    bool load(const QString& path, QString* error = nullptr);
+
+    // 全部城市
+    const std::vector<CityContribution>& cities() const;
+
+    // 按城市名查找，不存在时返回 nullptr
+    const CityContribution* find(const QString& city) const;
+
+    // 没有规则文件时使用的内置规则（只有一个“默认”城市）
+    static CityContribution builtIn();
+
+private:
+    std::vector<CityContribution> entries{ builtIn() };
+};
+
+#endif // CONTRIBUTIONTABLE_H
@@ -0,0 +1,333 @@
+﻿#include "credentialstore.h"
+#include "configstore.h"      // 目标耗时、会话有效期、初始账号
+#include "metricsregistry.h"  // 验证耗时统计
+#include "tracerecorder.h"    // 时间线区间
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMessageAuthenticationCode>
+#include <QMutex>
+#include <QPasswordDigestor>
+#include <QRandomGenerator>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+
+namespace
+{
+    // 盐和哈希的长度（字节）
+    const int SaltSize = 16;
+    const int HashSize = 32;
+
+    // 迭代次数的下限，测算结果再低也不使用更少的迭代
+    const int MinimumIterations = 10000;
+
+    // 已保存的迭代次数低于当前水平的这个比例时，登录成功后重新保存
+    const double UpgradeRatio = 0.5;
+
+    // 随机字节
+    QByteArray randomBytes(int size)
+    {
+        QByteArray bytes(size, Qt::Uninitialized);
+        QRandomGenerator::system()->fillRange(reinterpret_cast<quint32*>(bytes.data()), size / int(sizeof(quint32)));
+        return bytes;
+    }
+
+    // 比较两个哈希，耗时与第一个不同字节的位置无关
+    bool constantTimeEquals(const QByteArray& a, const QByteArray& b)
+    {
+        if (a.size() != b.size())
+        {
+            return false;
+        }
+        unsigned char difference = 0;
+        for (int i = 0; i < a.size(); ++i)
+        {
+            difference |= static_cast<unsigned char>(a[i] ^ b[i]);
+        }
+        return difference == 0;
+    }
+
+    // 会话缓存：已验证凭据和已发放令牌，进程内共享
+    // 凭据以“进程密钥 + 用户名 + 密码”的 HMAC 为键，不保存密码本身；进程密钥每次启动随机生成
+    struct Session
+    {
+        QString username;
+        QString token;
+        qint64 expiresAt = 0;     // 毫秒时间戳
+    };
+
+    struct SessionCache
+    {
+        QMutex mutex;
+        QByteArray secret = randomBytes(32);
+        QHash<QByteArray, Session> byCredential;
+        QHash<QString, Session> byToken;
+
+        // 凭据的缓存键
+        QByteArray keyOf(const QString& username, const QString& password) const
+        {
+            return QMessageAuthenticationCode::hash(username.toUtf8() + '\0' + password.toUtf8(), secret, QCryptographicHash::Sha256);
+        }
+
+        // 删除已过期的会话
+        void expire(qint64 now)
+        {
+            for (auto it = byCredential.begin(); it != byCredential.end();)
+            {
+                it = it->expiresAt <= now ? byCredential.erase(it) : it + 1;
+            }
+            for (auto it = byToken.begin(); it != byToken.end();)
+            {
+                it = it->expiresAt <= now ? byToken.erase(it) : it + 1;
+            }
+        }
+    };
+
+    SessionCache& sessions()
+    {
+        static SessionCache cache;
+        return cache;
+    }
+
+    // 会话有效期（毫秒）
+    qint64 sessionTtlMs()
+    {
+        return qint64(ConfigStore::instance().intValue("session_ttl_seconds", 300)) * 1000;
+    }
+}
+
+// CredentialStore 构造函数
+CredentialStore::CredentialStore(const QString& connectionName)
+    : connection(connectionName)
+{
+
+}
+
+// 打开数据库，创建 users 表和初始账号
+bool CredentialStore::open()
+{
+    if (!connection.open())
+    {
+        return false;
+    }
+
+    QSqlQuery query(connection.database());
+    if (!query.exec("CREATE TABLE IF NOT EXISTS users ("
+        "username TEXT PRIMARY KEY, "
+        "salt BLOB NOT NULL, "
+        "hash BLOB NOT NULL, "                // PBKDF2-HMAC-SHA256
+        "iterations INTEGER NOT NULL, "       // 派生哈希时的迭代次数
+        "updated_at TEXT NOT NULL)"))
+    {
+        qDebug() << "Failed to create users:" << query.lastError().text();
+        return false;
+    }
+
+    if (!query.exec("SELECT 1 FROM users LIMIT 1"))
+    {
+        qDebug() << "Failed to read users:" << query.lastError().text();
+        return false;
+    }
+    if (!query.next())
+    {
+        query.finish();
+        const QString username = ConfigStore::instance().value("login_username", "admin");
+        const QString password = ConfigStore::instance().value("login_password", "admin");
+        if (!store(username, password, false, nullptr))
+        {
+            return false;
+        }
+        qWarning() << "Created initial account" << username << "- change its password after the first login (account menu in the main window).";
+    }
+    return true;
+}
+
+// 关闭数据库
+void CredentialStore::close()
+{
+    connection.close();
+}
+
+// 验证用户名和密码
+CredentialStore::Verification CredentialStore::verify(const QString& username, const QString& password)
+{
+    static MetricsHistogram& latency = MetricsRegistry::instance().histogram("wagestax_login_verify_ns",
+        QString(), "CredentialStore::verify latency in nanoseconds");
+    ScopedLatency timer(latency);
+    TraceSpan span("CredentialStore::verify", "worker");
+
+    Verification result;
+    SessionCache& cache = sessions();
+    const QByteArray key = cache.keyOf(username, password);
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    // 有效期内验证过同样的凭据
+    {
+        QMutexLocker locker(&cache.mutex);
+        cache.expire(now);
+        auto it = cache.byCredential.constFind(key);
+        if (it != cache.byCredential.constEnd())
+        {
+            result.accepted = true;
+            result.cached = true;
+            result.token = it->token;
+            result.elapsedMs = timer.elapsedNs() / 1000000;
+            return result;
+        }
+    }
+
+    QSqlQuery query(connection.database());
+    query.prepare("SELECT salt, hash, iterations FROM users WHERE username = ?");
+    query.addBindValue(username);
+    if (!query.exec())
+    {
+        result.error = query.lastError().text();
+        return result;
+    }
+
+    if (query.next())
+    {
+        const QByteArray salt = query.value(0).toByteArray();
+        const QByteArray hash = query.value(1).toByteArray();
+        const int storedIterations = query.value(2).toInt();
+        query.finish();
+        result.accepted = constantTimeEquals(derive(password, salt, storedIterations), hash);
+
+        // 旧账号的迭代次数明显偏低时，趁知道明文密码重新保存
+        if (result.accepted && storedIterations < iterations() * UpgradeRatio)
+        {
+            store(username, password, true, nullptr);
+        }
+    }
+    else
+    {
+        // 账号不存在时同样派生一次哈希，使耗时与密码错误时相同
+        derive(password, randomBytes(SaltSize), iterations());
+    }
+
+    if (result.accepted)
+    {
+        Session session;
+        session.username = username;
+        session.token = QString::fromLatin1(randomBytes(32).toHex());
+        session.expiresAt = now + sessionTtlMs();
+        result.token = session.token;
+
+        QMutexLocker locker(&cache.mutex);
+        cache.byCredential.insert(key, session);
+        cache.byToken.insert(session.token, session);
+    }
+    result.elapsedMs = timer.elapsedNs() / 1000000;
+    return result;
+}
+
+// 设置密码
+bool CredentialStore::setPassword(const QString& username, const QString& password, QString* error)
+{
+    return store(username, password, true, error);
+}
+
+// 保存账号，并使该账号的会话缓存失效
+bool CredentialStore::store(const QString& username, const QString& password, bool replace, QString* error)
+{
+    const int cost = iterations();
+    const QByteArray salt = randomBytes(SaltSize);
+    const QByteArray hash = derive(password, salt, cost);
+
+    QSqlQuery query(connection.database());
+    query.prepare(QString("INSERT OR %1 INTO users (username, salt, hash, iterations, updated_at) VALUES (?, ?, ?, ?, ?)")
+        .arg(replace ? "REPLACE" : "IGNORE"));
+    query.addBindValue(username);
+    query.addBindValue(salt);
+    query.addBindValue(hash);
+    query.addBindValue(cost);
+    query.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
+    if (!query.exec())
+    {
+        qDebug() << "Failed to store credentials:" << query.lastError().text();
+        if (error)
+        {
+            *error = query.lastError().text();
+        }
+        return false;
+    }
+
+    SessionCache& cache = sessions();
+    QMutexLocker locker(&cache.mutex);
+    for (auto it = cache.byCredential.begin(); it != cache.byCredential.end();)
+    {
+        it = it->username == username ? cache.byCredential.erase(it) : it + 1;
+    }
+    for (auto it = cache.byToken.begin(); it != cache.byToken.end();)
+    {
+        it = it->username == username ? cache.byToken.erase(it) : it + 1;
+    }
+    return true;
+}
+
+// 检查会话令牌
+bool CredentialStore::validateToken(const QString& token, QString* username)
+{
+    SessionCache& cache = sessions();
+    QMutexLocker locker(&cache.mutex);
+    cache.expire(QDateTime::currentMSecsSinceEpoch());
+    auto it = cache.byToken.constFind(token);
+    if (it == cache.byToken.constEnd())
+    {
+        return false;
+    }
+    if (username)
+    {
+        *username = it->username;
+    }
+    return true;
+}
+
+// 使会话令牌失效
+void CredentialStore::revokeToken(const QString& token)
+{
+    SessionCache& cache = sessions();
+    QMutexLocker locker(&cache.mutex);
+    cache.byToken.remove(token);
+    for (auto it = cache.byCredential.begin(); it != cache.byCredential.end();)
+    {
+        it = it->token == token ? cache.byCredential.erase(it) : it + 1;
+    }
+}
+
+// 新密码使用的迭代次数
+int CredentialStore::iterations()
+{
+    static const int tuned = tuneIterations(ConfigStore::instance().intValue("password_hash_target_ms", 250));
+    return tuned;
+}
+
+// 测算迭代次数：先用少量迭代测出单次迭代的耗时，再按目标耗时换算
+int CredentialStore::tuneIterations(int targetMs)
+{
+    const QByteArray salt = randomBytes(SaltSize);
+    const int probe = 2000;
+    int rounds = 0;
+    QElapsedTimer timer;
+    timer.start();
+    do
+    {
+        derive("calibration", salt, probe);
+        ++rounds;
+    } while (timer.elapsed() < 20);
+
+    const double nsPerIteration = double(timer.nsecsElapsed()) / (double(probe) * rounds);
+    const double wanted = double(qMax(1, targetMs)) * 1e6 / nsPerIteration;
+    const int result = qMax(MinimumIterations, int(qMin(wanted, 1e8) / 1000) * 1000);
+    qDebug() << "Password hash cost tuned to" << result << "iterations for" << targetMs << "ms";
+    return result;
+}
+
+// PBKDF2-HMAC-SHA256
+QByteArray CredentialStore::derive(const QString& password, const QByteArray& salt, int iterations)
+{
+    return QPasswordDigestor::deriveKeyPbkdf2(QCryptographicHash::Sha256, password.toUtf8(), salt, iterations, HashSize);
+}
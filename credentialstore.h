@@ -0,0 +1,70 @@
+﻿#ifndef CREDENTIALSTORE_H
+#define CREDENTIALSTORE_H
+
+#include <QByteArray>
+#include <QString>
+#include "sqlmanager.h"
+
+// CredentialStore 类保存并验证登录账号。
+// 密码不以明文保存：users 表中每个账号有随机盐和 PBKDF2-HMAC-SHA256 派生出的哈希，以及派生时使用的迭代次数。
+// 迭代次数在进程中第一次需要时按目标耗时（配置项 password_hash_target_ms，默认 250 毫秒）测算，
+// 新设置的密码使用测算结果；旧账号登录成功时如果迭代次数明显低于当前水平，会用新的迭代次数重新保存。
+// 派生哈希是有意放慢的，验证应在后台线程中使用独立连接进行。
+// 验证成功后发放会话令牌，并在有效期（配置项 session_ttl_seconds，默认 300 秒）内记住这组凭据：
+// 同一进程中的其他会话或批处理任务在有效期内用同样的凭据或令牌认证时不再重新派生哈希。
+// 本进程中修改密码会立即清除该账号的缓存；其他进程修改密码时，本进程缓存的旧凭据在有效期结束前仍然有效。
+// users 表为空时（新数据库）按配置项 login_username / login_password（默认 admin / admin）创建初始账号。
+class CredentialStore
+{
+public:
+    // 一次验证的结果
+    struct Verification
+    {
+        bool accepted = false;    // 是否通过
+        bool cached = false;      // 是否由会话缓存直接确认（没有派生哈希）
+        QString token;            // 通过时的会话令牌
+        QString error;            // 数据库错误等无法完成验证的原因
+        qint64 elapsedMs = 0;     // 耗时（毫秒）
+    };
+
+    // 构造函数
+    // 参数:
+    //   - connectionName: 使用的数据库连接名（线程规则见 SqlManager 构造函数）
+    explicit CredentialStore(const QString& connectionName = "wagestax_credentials");
+
+    // 打开数据库并创建 users 表（已存在时跳过），表为空时创建初始账号，返回是否成功
+    bool open();
+
+    // 关闭并移除数据库连接
+    void close();
+
+    // verify 函数验证用户名和密码，会话缓存命中时直接返回
+    Verification verify(const QString& username, const QString& password);
+
+    // setPassword 函数设置（或新建）账号的密码，并使该账号的会话缓存失效
+    bool setPassword(const QString& username, const QString& password, QString* error = nullptr);
+
+    // validateToken 函数检查会话令牌是否有效，有效时写出对应的用户名
+    static bool validateToken(const QString& token, QString* username = nullptr);
+
+    // revokeToken 函数使会话令牌失效
+    static void revokeToken(const QString& token);
+
+    // iterations 函数返回新密码使用的迭代次数，第一次调用时测算
+    static int iterations();
+
+    // tuneIterations 函数测算本机上派生一次哈希耗时约 targetMs 毫秒所需的迭代次数
+    static int tuneIterations(int targetMs);
+
+    // derive 函数以 PBKDF2-HMAC-SHA256 从密码和盐派生 32 字节哈希
+    static QByteArray derive(const QString& password, const QByteArray& salt, int iterations);
+
+private:
+    // 保存账号，replace 为 false 时账号已存在则不修改
+    bool store(const QString& username, const QString& password, bool replace, QString* error);
+
+    // 数据库连接，与员工数据位于同一个数据库
+    SqlManager connection;
+};
+
+#endif // CREDENTIALSTORE_H
@@ -0,0 +1,267 @@
+﻿#include "databasemaintenance.h"
+#include "sqlmanager.h"        // 维护使用的连接
+#include "employeestore.h"     // 存储后端与数据库路径
+#include "configstore.h"       // 阈值与预算
+#include "jobscheduler.h"      // 空闲任务
+#include "metricsregistry.h"   // 维护耗时统计
+#include "tracerecorder.h"     // 时间线区间
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QMutex>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+#include <atomic>
+#include <deque>
+
+namespace
+{
+    // 维护使用的连接名
+    const char* MaintenanceConnection = "wagestax_maintenance";
+
+    // 启动后第一次检查前等待的时间
+    const qint64 StartupDelayMs = 60 * 1000;
+
+    // 每次增量回收的页数，每一步都很短，便于按预算停止
+    const int IncrementalVacuumPages = 256;
+
+    // 估计整库重写（VACUUM）的速度，字节/毫秒
+    const qint64 RewriteBytesPerMs = 50 * 1024;
+
+    // ANALYZE 每个索引的采样行数上限（SQLite 3.32 起支持，旧版本忽略）
+    const int AnalysisLimit = 1000;
+
+    // 保留的维护记录数
+    const size_t ReportHistory = 5;
+
+    // 累计的改动行数，以及是否已登记维护任务
+    std::atomic<qint64> churn(0);
+    std::atomic<bool> scheduled(false);
+
+    // 最近的维护记录
+    QMutex reportMutex;
+    std::deque<DatabaseMaintenance::Report> reports;
+
+    // 读取一个整数 PRAGMA
+    qint64 pragmaValue(QSqlQuery& query, const QString& pragma)
+    {
+        if (query.exec("PRAGMA " + pragma) && query.next())
+        {
+            return query.value(0).toLongLong();
+        }
+        return -1;
+    }
+
+    // 文件状态的文本
+    QString statsText(const DatabaseMaintenance::FileStats& stats)
+    {
+        return QString("%1 bytes (wal %2), %3 pages x %4, %5 free")
+            .arg(stats.fileBytes).arg(stats.walBytes).arg(stats.pageCount).arg(stats.pageSize).arg(stats.freePages);
+    }
+}
+
+// 累计改动的行数
+void DatabaseMaintenance::recordChurn(qint64 rows)
+{
+    if (rows <= 0)
+    {
+        return;
+    }
+    const qint64 threshold = ConfigStore::instance().intValue("maintenance_churn_threshold", 1000);
+    if (churn.fetch_add(rows) + rows >= threshold)
+    {
+        requestIdleRun(0);
+    }
+}
+
+// 尚未维护的改动行数
+qint64 DatabaseMaintenance::pendingChurn()
+{
+    return churn.load();
+}
+
+// 启动时登记第一次检查
+void DatabaseMaintenance::install()
+{
+    requestIdleRun(StartupDelayMs);
+}
+
+// 登记一次空闲维护任务
+void DatabaseMaintenance::requestIdleRun(qint64 delayMs)
+{
+    if (EmployeeStore::backend() == EmployeeStore::SqliteMemory || scheduled.exchange(true))
+    {
+        return;
+    }
+
+    // 调度器只能在主线程中登记任务，改动可能来自后台线程
+    JobScheduler* scheduler = &JobScheduler::instance();
+    QMetaObject::invokeMethod(scheduler, [scheduler, delayMs]() {
+        JobScheduler::Job job;
+        job.name = "db_maintenance";
+        job.priority = JobScheduler::Low;
+        job.delayMs = delayMs;
+        job.idle = true;
+        scheduler->schedule(job, [](const JobScheduler::Context&) {
+            scheduled.store(false);
+            run(ConfigStore::instance().intValue("maintenance_budget_ms", 500));
+        });
+    }, Qt::QueuedConnection);
+}
+
+// 读取数据库文件的状态
+DatabaseMaintenance::FileStats DatabaseMaintenance::fileStats(const QSqlDatabase& db)
+{
+    FileStats stats;
+    QSqlQuery query(db);
+    stats.pageSize = pragmaValue(query, "page_size");
+    stats.pageCount = pragmaValue(query, "page_count");
+    stats.freePages = pragmaValue(query, "freelist_count");
+    query.finish();
+
+    const QString path = db.databaseName();
+    stats.fileBytes = QFileInfo(path).size();
+    stats.walBytes = QFileInfo(path + "-wal").exists() ? QFileInfo(path + "-wal").size() : 0;
+    return stats;
+}
+
+// 执行一次维护
+DatabaseMaintenance::Report DatabaseMaintenance::run(qint64 budgetMs)
+{
+    static MetricsHistogram& latency = MetricsRegistry::instance().histogram("wagestax_maintenance_ns",
+        QString(), "DatabaseMaintenance::run latency in nanoseconds");
+    ScopedLatency timer(latency);
+    TraceSpan span("DatabaseMaintenance::run", "sql");
+
+    Report report;
+    report.startedAt = QDateTime::currentDateTime();
+    report.churn = churn.load();
+    const qint64 threshold = ConfigStore::instance().intValue("maintenance_churn_threshold", 1000);
+
+    SqlManager connection(MaintenanceConnection);
+    if (EmployeeStore::backend() == EmployeeStore::SqliteMemory || !connection.open())
+    {
+        connection.close();
+        return report;
+    }
+
+    {
+        QSqlDatabase db = connection.database();
+        QSqlQuery query(db);
+        QElapsedTimer clock;
+        clock.start();
+        auto remaining = [&]() { return budgetMs - clock.elapsed(); };
+        auto step = [&](const QString& name, const QString& sql) {
+            QElapsedTimer stepClock;
+            stepClock.start();
+            const bool ok = query.exec(sql);
+            while (ok && query.next())
+            {
+            }
+            query.finish();
+            report.steps << QString("%1: %2 (%3 ms)").arg(name, ok ? QString("ok") : query.lastError().text()).arg(stepClock.elapsed());
+            return ok;
+        };
+
+        report.before = fileStats(db);
+
+        // 统计信息：PRAGMA optimize 只分析需要的表；从未分析过或改动很多时完整执行一次有采样上限的 ANALYZE
+        step("optimize", "PRAGMA optimize");
+        query.exec("SELECT 1 FROM sqlite_master WHERE name = 'sqlite_stat1'");
+        const bool analyzed = query.next();
+        query.finish();
+        if (remaining() > 0 && (!analyzed || report.churn >= threshold))
+        {
+            query.exec(QString("PRAGMA analysis_limit = %1").arg(AnalysisLimit));
+            step("analyze", "ANALYZE");
+        }
+
+        // 空闲页：已启用增量 auto_vacuum 时分小步回收；否则在预算允许时一次性转换
+        FileStats current = fileStats(db);
+        if (current.freePages > 0 && remaining() > 0)
+        {
+            if (pragmaValue(query, "auto_vacuum") == 2)
+            {
+                query.finish();
+                int rounds = 0;
+                while (current.freePages > 0 && remaining() > 0)
+                {
+                    query.exec(QString("PRAGMA incremental_vacuum(%1)").arg(IncrementalVacuumPages));
+                    while (query.next())
+                    {
+                    }
+                    query.finish();
+                    current.freePages = pragmaValue(query, "freelist_count");
+                    query.finish();
+                    ++rounds;
+                }
+                report.steps << QString("incremental_vacuum: %1 rounds, %2 free pages left").arg(rounds).arg(current.freePages);
+            }
+            else
+            {
+                query.finish();
+                const qint64 estimateMs = current.fileBytes / RewriteBytesPerMs;
+                if (estimateMs <= remaining())
+                {
+                    step("auto_vacuum", "PRAGMA auto_vacuum = INCREMENTAL");
+                    step("vacuum", "VACUUM");
+                }
+                else
+                {
+                    report.steps << QString("vacuum: skipped, estimated %1 ms exceeds the remaining budget").arg(estimateMs);
+                }
+            }
+        }
+
+        // WAL 检查点：PASSIVE 不等待读写方，不会阻塞界面线程的连接
+        if (remaining() > 0 && query.exec("PRAGMA journal_mode") && query.next()
+            && query.value(0).toString().compare("wal", Qt::CaseInsensitive) == 0)
+        {
+            query.finish();
+            step("wal_checkpoint", "PRAGMA wal_checkpoint(PASSIVE)");
+        }
+        query.finish();
+
+        report.after = fileStats(db);
+        report.elapsedMs = clock.elapsed();
+        report.budgetExhausted = remaining() <= 0;
+    }
+    connection.close();
+
+    // 本次维护覆盖了开始时累计的改动，期间新增的改动留给下一次
+    churn.fetch_sub(report.churn);
+    qDebug() << "Database maintenance finished in" << report.elapsedMs << "ms:" << report.steps;
+
+    QMutexLocker locker(&reportMutex);
+    reports.push_back(report);
+    if (reports.size() > ReportHistory)
+    {
+        reports.pop_front();
+    }
+    return report;
+}
+
+// 最近几次维护的记录
+QString DatabaseMaintenance::toText()
+{
+    QStringList lines;
+    lines << QString("pending churn: %1 rows").arg(pendingChurn());
+
+    QMutexLocker locker(&reportMutex);
+    for (auto it = reports.rbegin(); it != reports.rend(); ++it)
+    {
+        lines << QString("%1  churn %2, %3 ms%4")
+            .arg(it->startedAt.toString("yyyy-MM-dd hh:mm:ss"))
+            .arg(it->churn)
+            .arg(it->elapsedMs)
+            .arg(it->budgetExhausted ? ", budget exhausted" : "");
+        lines << "  before: " + statsText(it->before);
+        lines << "  after:  " + statsText(it->after);
+        for (const QString& step : it->steps)
+        {
+            lines << "  " + step;
+        }
+    }
+    return lines.join("\n") + "\n";
+}
@@ -0,0 +1,71 @@
+﻿#ifndef DATABASEMAINTENANCE_H
+#define DATABASEMAINTENANCE_H
+
+#include <QDateTime>
+#include <QString>
+#include <QStringList>
+
+class QSqlDatabase;
+
+// DatabaseMaintenance 类在用户空闲时维护 SQLite 数据库文件：
+//   - 统计员工更新和删除、重新核算等操作改动的行数（churn），累计超过 maintenance_churn_threshold（默认 1000 行）
+//     时登记一次空闲任务；启动后也会在空闲时检查一次，数据库从未收集过统计信息时补做 ANALYZE；
+//   - 每次维护依次执行 PRAGMA optimize、必要时 ANALYZE（限制采样行数）、增量回收空闲页、WAL 检查点，
+//     总耗时受 maintenance_budget_ms（默认 500 毫秒）限制，预算用完时剩下的步骤留到下一次；
+//   - 数据库尚未启用增量 auto_vacuum 时，只在估计的整库重写时间不超过剩余预算时一次性转换（VACUUM）；
+//   - 每次维护前后的文件大小、页数和空闲页数记录在诊断窗口中。
+// 维护在 JobScheduler 的线程池中使用独立连接执行；内存数据库没有文件，不需要维护。
+class DatabaseMaintenance
+{
+public:
+    // 数据库文件的状态
+    struct FileStats
+    {
+        qint64 fileBytes = 0;     // 数据库文件大小
+        qint64 walBytes = 0;      // WAL 文件大小
+        qint64 pageSize = 0;      // 页大小
+        qint64 pageCount = 0;     // 页数
+        qint64 freePages = 0;     // 空闲页数
+    };
+
+    // 一次维护的记录
+    struct Report
+    {
+        QDateTime startedAt;      // 开始时间
+        qint64 churn = 0;         // 本次维护时累计的改动行数
+        FileStats before;         // 维护前
+        FileStats after;          // 维护后
+        QStringList steps;        // 执行的步骤及耗时
+        qint64 elapsedMs = 0;     // 总耗时
+        bool budgetExhausted = false; // 预算是否用完
+    };
+
+    // recordChurn 函数累计改动的行数，可以在任意线程中调用
+    static void recordChurn(qint64 rows);
+
+    // 尚未维护的改动行数
+    static qint64 pendingChurn();
+
+    // install 函数在启动时调用（主线程），登记启动后的第一次空闲检查
+    static void install();
+
+    // requestIdleRun 函数登记一次空闲维护任务（已登记时跳过），可以在任意线程中调用；
+    // 清空员工等一次释放大量页面的操作直接调用它，不必等改动行数达到阈值
+    // 参数:
+    //   - delayMs: 最早执行前的延时（毫秒）
+    static void requestIdleRun(qint64 delayMs = 0);
+
+    // run 函数在当前线程中立即执行一次维护
+    // 参数:
+    //   - budgetMs: 时间预算（毫秒）
+    // 返回值：维护记录
+    static Report run(qint64 budgetMs);
+
+    // 最近几次维护的记录，用于诊断窗口
+    static QString toText();
+
+    // 读取数据库文件的状态
+    static FileStats fileStats(const QSqlDatabase& db);
+};
+
+#endif // DATABASEMAINTENANCE_H
@@ -0,0 +1,137 @@
+﻿#include "databasepreloader.h"
+#include "employeestore.h"     // 员工数据存储
+#include "employeesearchindex.h" // 前缀搜索索引
+#include "salaryrankindex.h"   // 工资顺序统计索引
+#include "sqlmanager.h"        // 统一的显示格式
+#include "startupprofiler.h"   // 启动阶段计时
+#include "tracerecorder.h"     // 时间线区间
+#include "allocationtracker.h" // 按操作统计堆分配
+#include "jobscheduler.h"      // 后台线程池
+#include <QDebug>
+
+namespace
+{
+    // 预热使用的临时连接名，与界面线程的默认连接互不干扰
+    const char* PreloaderConnection = "wagestax_preloader";
+}
+
+// DatabasePreloader 构造函数
+DatabasePreloader::DatabasePreloader(int pageSize)
+    : pageSize(pageSize)
+    , cancelRequested(false)
+{
+
+}
+
+// DatabasePreloader 析构函数，后台任务仍在运行时让它尽快结束
+DatabasePreloader::~DatabasePreloader()
+{
+    cancelRequested.store(true);
+    task.waitForFinished();
+}
+
+// 在调度器的线程池中开始预热
+void DatabasePreloader::start()
+{
+    cancelRequested.store(false);
+    task = JobScheduler::instance().run<State>("preload", JobScheduler::Normal, [this]() { return load(); });
+}
+
+// 返回预热任务
+QFuture<DatabasePreloader::State> DatabasePreloader::future() const
+{
+    return task;
+}
+
+// 取消预热并释放结果
+void DatabasePreloader::cancel()
+{
+    if (task.isCanceled() || (!task.isRunning() && !task.isFinished()))
+    {
+        return;
+    }
+
+    cancelRequested.store(true);
+    task.waitForFinished();
+
+    // QFuture 内部保存着结果，替换为空 future 后结果随之释放
+    task = QFuture<State>();
+    qDebug() << "Database preloader cancelled.";
+}
+
+// 分页读取全部员工
+bool DatabasePreloader::readAll(EmployeeStore& source, int pageSize, Rows& rows, const std::atomic<bool>* cancelled, int expected)
+{
+    rows.displays.reserve(size_t(qMax(0, expected)));
+    rows.names.reserve(rows.displays.capacity());
+    rows.salaries.reserve(rows.displays.capacity());
+    int lastId = 0;
+    for (;;)
+    {
+        if (cancelled && cancelled->load())
+        {
+            return false;
+        }
+        auto page = source.queryRecordsAfter(lastId, pageSize);
+        if (page.empty())
+        {
+            break;
+        }
+        lastId = page.back().id;
+        for (const EmployeeRecord& record : page)
+        {
+            rows.displays.push_back(std::make_pair(record.id,
+                SqlManager::formatEmployee(record.id, record.name, record.salary, record.tax)));
+            rows.names.push_back(record.name);
+            rows.salaries.push_back(std::make_pair(record.id, record.salary));
+        }
+        if (int(page.size()) < pageSize)
+        {
+            break;
+        }
+    }
+    return true;
+}
+
+// 后台线程中的预热过程
+DatabasePreloader::State DatabasePreloader::load()
+{
+    StartupPhase phase("database preload (background)");
+    TraceSpan span("DatabasePreloader::load", "worker");
+    AllocationScope allocations("preload");
+    State state;
+
+    std::unique_ptr<EmployeeStore> loader = EmployeeStore::create(PreloaderConnection);
+
+    // 打开连接并检查表结构
+    state.opened = loader->open();
+
+    // 统计员工数量，用于预留内存
+    if (state.opened && !cancelRequested.load())
+    {
+        state.employeeCount = loader->countEmployees();
+    }
+
+    // 分页读取全部员工构建索引，每页之间检查取消标志；显示文本只有第一页交给界面，
+    // 列表第一页与索引共享同一份字符串数据
+    Rows rows;
+    if (state.opened && !cancelRequested.load()
+        && readAll(*loader, pageSize, rows, &cancelRequested, state.employeeCount))
+    {
+        state.employees.assign(rows.displays.begin(), rows.displays.begin() + qMin(rows.displays.size(), size_t(FirstPageSize)));
+        state.searchIndex = std::make_shared<EmployeeSearchIndex>();
+        state.searchIndex->build(rows.displays, rows.names);
+        state.rankIndex = std::make_shared<SalaryRankIndex>();
+        state.rankIndex->build(rows.salaries);
+    }
+
+    loader->close();
+
+    if (cancelRequested.load())
+    {
+        // 取消时不保留任何数据
+        state = State();
+        state.cancelled = true;
+    }
+    return state;
+}
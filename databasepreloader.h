@@ -0,0 +1,85 @@
+﻿#ifndef DATABASEPRELOADER_H
+#define DATABASEPRELOADER_H
+
+#include <QFuture>
+#include <QString>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+class EmployeeSearchIndex;
+class EmployeeStore;
+class SalaryRankIndex;
+
+// DatabasePreloader 类在程序启动时于后台线程预热数据库：
+// 打开连接、检查表结构、统计员工数量、分页读取员工并构建搜索索引和工资顺序统计索引。
+// 交给界面的只有员工总数和列表的第一页（FirstPageSize 行），其余行在界面滚动到底部时再分页读取，
+// 员工再多，首次绘制的控件数量也不变。
+// 登录对话框等待用户输入期间这些工作已经完成，登录成功后交给 WagesTax 直接展示；
+// 登录失败时调用 cancel() 中止并释放已读取的数据。
+class DatabasePreloader
+{
+public:
+    // 预热结果
+    struct State
+    {
+        bool opened = false;      // 数据库是否成功打开
+        bool cancelled = false;   // 是否在完成前被取消
+        int employeeCount = 0;    // 员工总数
+        std::vector<std::pair<int, QString>> employees;  // 列表第一页，格式化后的前 FirstPageSize 名员工
+        std::shared_ptr<EmployeeSearchIndex> searchIndex;  // 姓名和 ID 的前缀索引
+        std::shared_ptr<SalaryRankIndex> rankIndex;        // 工资的顺序统计索引
+    };
+
+    // 分页读取的全部员工，按 ID 顺序排列，用于构建索引
+    struct Rows
+    {
+        std::vector<std::pair<int, QString>> displays;  // 格式化后的显示文本
+        std::vector<QString> names;                     // 姓名
+        std::vector<std::pair<int, double>> salaries;   // 工资
+    };
+
+    // 员工列表每页显示的行数，预热结果只包含第一页
+    static const int FirstPageSize = 200;
+
+    // readAll 函数按 ID 顺序分页读取 source 中的全部员工，预热和批量导入后的索引重建共用，在后台线程中调用
+    // 参数:
+    //   - source: 已打开的员工存储
+    //   - pageSize: 每页读取的行数
+    //   - rows: 读取结果
+    //   - cancelled: 每页之间检查的取消标志（可以为空）
+    //   - expected: 预计的员工数，用于预留内存
+    // 返回值：是否读完（被取消时返回 false）
+    static bool readAll(EmployeeStore& source, int pageSize, Rows& rows, const std::atomic<bool>* cancelled = nullptr, int expected = 0);
+
+    // 构造函数，参数 pageSize 为每次从数据库读取的行数（也是取消检查的粒度）
+    explicit DatabasePreloader(int pageSize = 2000);
+
+    // 析构函数，未完成时先取消
+    ~DatabasePreloader();
+
+    // 在调度器的线程池中开始预热，JobScheduler 必须已经创建
+    void start();
+
+    // 预热任务的 future，WagesTax 通过它获取结果
+    QFuture<State> future() const;
+
+    // 取消预热，等待后台任务结束并释放结果占用的内存
+    void cancel();
+
+private:
+    // 后台线程中执行的预热过程
+    State load();
+
+    // 每页读取的行数
+    int pageSize;
+
+    // 取消标志，后台线程在每个阶段和每页之间检查
+    std::atomic<bool> cancelRequested;
+
+    // 预热任务
+    QFuture<State> task;
+};
+
+#endif // DATABASEPRELOADER_H
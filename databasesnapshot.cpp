@@ -0,0 +1,304 @@
+﻿#include "databasesnapshot.h"
+#include "sqlmanager.h"        // 复制使用的连接
+#include "employeestore.h"     // 存储后端与数据库路径
+#include "configstore.h"       // 快照有效期与备份设置
+#include "jobscheduler.h"      // 定时备份
+#include "metricsregistry.h"   // 复制耗时统计
+#include "tracerecorder.h"     // 时间线区间
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QVariant>
+#include <QWaitCondition>
+
+namespace
+{
+    // 复制使用的连接名
+    const char* SnapshotConnection = "wagestax_snapshot";
+    const char* BackupConnection = "wagestax_backup";
+
+    // 快照文件名中时间戳之前的部分，文件名为 <数据库文件>.snapshot-<时间戳>
+    const char* SnapshotInfix = ".snapshot-";
+
+    // 保护下面的状态；复制期间从不持有，诊断窗口读取状态时不会被正在进行的复制阻塞
+    QMutex stateMutex;
+    std::shared_ptr<DatabaseSnapshot::Snapshot> current;
+    QString lastBackup;
+    QDateTime lastBackupAt;
+    QString lastError;
+
+    // 正在生成的报表快照：同一时间只有一个线程复制，其他线程等待 snapshotCreated 后共用它的结果
+    bool creating = false;
+    bool lastCreateFailed = false;
+    quint64 finishedCreates = 0;
+    QWaitCondition snapshotCreated;
+
+    // 每次 invalidate 加一；复制期间有数据提交时，复制结果不再作为当前快照
+    quint64 generation = 0;
+
+    // 生成副本的耗时直方图
+    MetricsHistogram& copyLatency(const char* kind)
+    {
+        return MetricsRegistry::instance().histogram("wagestax_snapshot_ns",
+            QString("kind=\"%1\"").arg(kind), "DatabaseSnapshot copy latency in nanoseconds");
+    }
+}
+
+// 快照析构时删除文件，此时已没有连接在读取它
+DatabaseSnapshot::Snapshot::~Snapshot()
+{
+    if (!path.isEmpty())
+    {
+        QFile::remove(path);
+    }
+}
+
+// 把当前数据库的时间点副本写到 target
+bool DatabaseSnapshot::copyTo(const QString& target, const QString& connectionName, bool requireWal, qint64& bytes, QString* error)
+{
+    if (EmployeeStore::backend() == EmployeeStore::Columnar)
+    {
+        SqlManager::reportError(error, "Database snapshot", "the columnar backend has no SQLite database");
+        return false;
+    }
+
+    // VACUUM INTO 要求目标文件不存在；先写临时文件，完成后再替换，读取方不会看到写了一半的文件
+    const QString partial = target + ".part";
+    QFile::remove(partial);
+
+    SqlManager connection(connectionName);
+    bool copied = false;
+    if (connection.open())
+    {
+        QSqlQuery query(connection.database());
+
+        // 只有 WAL 模式下复制才只是一个读事务；回滚日志模式下复制期间的写入都会被阻塞
+        const bool wal = query.exec("PRAGMA journal_mode") && query.next()
+            && query.value(0).toString().compare("wal", Qt::CaseInsensitive) == 0;
+        if (!wal && requireWal)
+        {
+            SqlManager::reportError(error, "Database snapshot", "the database is not in WAL mode, copying it would block writers");
+            connection.close();
+            return false;
+        }
+        if (!wal)
+        {
+            qDebug() << "Database snapshot: the database is not in WAL mode, writers wait until the copy finishes";
+        }
+
+        query.prepare("VACUUM INTO ?");
+        query.addBindValue(QDir::toNativeSeparators(QFileInfo(partial).absoluteFilePath()));
+        copied = query.exec();
+        if (!copied)
+        {
+            SqlManager::reportError(error, "Database snapshot", query.lastError().text());
+        }
+    }
+    else
+    {
+        SqlManager::reportError(error, "Database snapshot", "cannot open the database");
+    }
+    connection.close();
+
+    if (!copied)
+    {
+        QFile::remove(partial);
+        return false;
+    }
+    QFile::remove(target);
+    if (!QFile::rename(partial, target))
+    {
+        SqlManager::reportError(error, "Database snapshot", QString("cannot rename %1 to %2").arg(partial, target));
+        QFile::remove(partial);
+        return false;
+    }
+    bytes = QFileInfo(target).size();
+    return true;
+}
+
+// 返回当前的报表快照，必要时生成新的
+std::shared_ptr<DatabaseSnapshot::Snapshot> DatabaseSnapshot::acquire(QString* error)
+{
+    static MetricsHistogram& latency = copyLatency("report");
+    TraceSpan span("DatabaseSnapshot::acquire", "sql");
+
+    const qint64 maxAgeMs = qint64(ConfigStore::instance().intValue("snapshot_max_age_seconds", 60)) * 1000;
+    quint64 startGeneration = 0;
+    {
+        QMutexLocker locker(&stateMutex);
+        for (;;)
+        {
+            if (current && current->createdAt.msecsTo(QDateTime::currentDateTime()) <= maxAgeMs)
+            {
+                return current;
+            }
+            if (!creating)
+            {
+                break;
+            }
+
+            // 其他线程正在生成时等待它完成，同时到来的报表共用同一份，不会各自复制一次；
+            // 复制期间有数据提交时那份快照不再是当前快照，回到开头重新生成
+            const quint64 awaited = finishedCreates;
+            while (finishedCreates == awaited)
+            {
+                snapshotCreated.wait(&stateMutex);
+            }
+            if (lastCreateFailed)
+            {
+                SqlManager::reportError(error, "Database snapshot", lastError);
+                return nullptr;
+            }
+        }
+        creating = true;
+        startGeneration = generation;
+    }
+
+    // 复制在锁外进行
+    ScopedLatency timer(latency);
+    std::shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>();
+    snapshot->createdAt = QDateTime::currentDateTime();
+    const QString path = EmployeeStore::path() + SnapshotInfix + snapshot->createdAt.toString("yyyyMMddhhmmsszzz");
+    QString message;
+    const bool copied = copyTo(path, SnapshotConnection, true, snapshot->bytes, &message);
+    if (copied)
+    {
+        snapshot->path = path;
+        snapshot->elapsedMs = timer.elapsedNs() / 1000000;
+        qDebug() << "Created report snapshot" << path << "(" << snapshot->bytes << "bytes) in" << snapshot->elapsedMs << "ms";
+    }
+
+    QMutexLocker locker(&stateMutex);
+    creating = false;
+    lastCreateFailed = !copied;
+    ++finishedCreates;
+    snapshotCreated.wakeAll();
+    if (!copied)
+    {
+        lastError = message;
+        SqlManager::reportError(error, "Database snapshot", message);
+        return nullptr;
+    }
+
+    // 旧快照仍被报表持有时，等最后一个持有者释放后再删除；
+    // 复制期间有数据提交时，快照只交给本次调用，之后的报表重新生成
+    if (generation == startGeneration)
+    {
+        current = snapshot;
+    }
+    return snapshot;
+}
+
+// 数据已提交修改，当前快照不再使用
+void DatabaseSnapshot::invalidate()
+{
+    QMutexLocker locker(&stateMutex);
+    ++generation;
+    current.reset();
+}
+
+// 生成一份热备份并删除多余的旧备份
+QString DatabaseSnapshot::backup(QString* error)
+{
+    static MetricsHistogram& latency = copyLatency("backup");
+    ScopedLatency timer(latency);
+    TraceSpan span("DatabaseSnapshot::backup", "sql");
+
+    const QString directory = ConfigStore::instance().value("backup_dir", "backups");
+    const int keep = qMax(1, ConfigStore::instance().intValue("backup_keep", 7));
+    if (!QDir().mkpath(directory))
+    {
+        SqlManager::reportError(error, "Database snapshot", QString("cannot create %1").arg(directory));
+        return QString();
+    }
+
+    // 备份文件名为 <数据库文件名>-<时间戳>.db，按文件名排序即按时间排序
+    const QString prefix = QFileInfo(EmployeeStore::path()).completeBaseName() + "-";
+    const QString target = QDir(directory).filePath(prefix + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss") + ".db");
+    qint64 bytes = 0;
+    QString message;
+    if (!copyTo(target, BackupConnection, false, bytes, &message))
+    {
+        QMutexLocker locker(&stateMutex);
+        lastError = message;
+        SqlManager::reportError(error, "Database snapshot", message);
+        return QString();
+    }
+
+    QStringList backups = QDir(directory).entryList(QStringList() << prefix + "*.db", QDir::Files, QDir::Name);
+    while (backups.size() > keep)
+    {
+        QFile::remove(QDir(directory).filePath(backups.takeFirst()));
+    }
+    qDebug() << "Created backup" << target << "(" << bytes << "bytes) in" << timer.elapsedNs() / 1000000 << "ms";
+
+    QMutexLocker locker(&stateMutex);
+    lastBackup = target;
+    lastBackupAt = QDateTime::currentDateTime();
+    return target;
+}
+
+// 清理遗留的快照并登记定时备份
+void DatabaseSnapshot::install()
+{
+    const QFileInfo database(EmployeeStore::path());
+    QDir directory = database.absoluteDir();
+    for (const QString& name : directory.entryList(QStringList() << database.fileName() + SnapshotInfix + "*", QDir::Files))
+    {
+        directory.remove(name);
+    }
+
+    // 员工数据的任何修改都使当前快照失效，报表总能看到点击之前已保存的编辑；信号可能在后台线程发出，直接调用即可
+    EmployeeStoreEvents* events = EmployeeStoreEvents::instance();
+    QObject::connect(events, &EmployeeStoreEvents::employeeSaved, events, []() { invalidate(); }, Qt::DirectConnection);
+    QObject::connect(events, &EmployeeStoreEvents::employeeRemoved, events, []() { invalidate(); }, Qt::DirectConnection);
+    QObject::connect(events, &EmployeeStoreEvents::employeesReset, events, []() { invalidate(); }, Qt::DirectConnection);
+
+    const QString cron = ConfigStore::instance().value("backup_schedule", "30 2 * * *").trimmed();
+    if (cron.isEmpty() || EmployeeStore::backend() == EmployeeStore::Columnar)
+    {
+        return;
+    }
+    JobScheduler::Job job;
+    job.name = "db_backup";
+    job.priority = JobScheduler::Low;
+    job.cron = cron;
+    if (JobScheduler::instance().schedule(job, [](const JobScheduler::Context&) { backup(); }) == 0)
+    {
+        qWarning() << "Invalid backup_schedule:" << cron;
+    }
+}
+
+// 最近的快照和备份
+QString DatabaseSnapshot::toText()
+{
+    QMutexLocker locker(&stateMutex);
+    QStringList lines;
+    if (creating)
+    {
+        lines << "report snapshot: creating";
+    }
+    if (current)
+    {
+        lines << QString("report snapshot: %1, %2 bytes, created %3 in %4 ms, %5 holders")
+            .arg(current->path).arg(current->bytes)
+            .arg(current->createdAt.toString("yyyy-MM-dd hh:mm:ss")).arg(current->elapsedMs)
+            .arg(current.use_count() - 1);
+    }
+    else if (!creating)
+    {
+        lines << "report snapshot: none";
+    }
+    lines << (lastBackup.isEmpty() ? QString("last backup: none")
+        : QString("last backup: %1 at %2").arg(lastBackup, lastBackupAt.toString("yyyy-MM-dd hh:mm:ss")));
+    if (!lastError.isEmpty())
+    {
+        lines << "last error: " + lastError;
+    }
+    return lines.join("\n") + "\n";
+}
@@ -0,0 +1,71 @@
+﻿#ifndef DATABASESNAPSHOT_H
+#define DATABASESNAPSHOT_H
+
+#include <QDateTime>
+#include <QString>
+#include <memory>
+
+// DatabaseSnapshot 类为报表和备份生成数据库的时间点副本：
+//   - 副本由后台线程中的独立连接执行 VACUUM INTO 写出。WAL 模式下它只是一个读事务，
+//     副本内容是事务开始那一刻的数据，界面线程和其他连接在复制期间照常写入，不会被阻塞；
+//     文件数据库默认使用 WAL（见 SqlManager::applyPragmas），配置了其他 journal_mode 时复制期间的写入都要等待，
+//     因此不生成报表快照（报表直接读取存储），定时备份照常进行；
+//   - 报表快照：acquire 返回不超过 snapshot_max_age_seconds（默认 60 秒）的共享快照，
+//     工资核算、年度汇算、工资明细和年终奖优化都在快照上只读查询，期间的编辑不影响报表的一致性，也不被报表阻塞；
+//     本进程提交的修改（员工数据的增删改、工资核算和结账）通过 invalidate 使当前快照失效，报表不会读到点击之前的旧数据；
+//     最后一个持有者释放后删除快照文件；
+//   - 热备份：按 backup_schedule（cron 式，默认每天 02:30）写入 backup_dir（默认 backups），
+//     只保留最新的 backup_keep（默认 7）份。
+// 列式存储后端的数据不在 SQLite 中，不生成快照，报表直接读取存储本身。
+class DatabaseSnapshot
+{
+public:
+    // 一份报表快照，析构时删除文件
+    struct Snapshot
+    {
+        QString path;             // 快照文件
+        QDateTime createdAt;      // 数据所处的时间点
+        qint64 bytes = 0;         // 文件大小
+        qint64 elapsedMs = 0;     // 生成耗时
+
+        Snapshot() = default;
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+        ~Snapshot();
+    };
+
+    // acquire 函数返回当前的报表快照，快照过旧或不存在时先生成新的，可以在任意线程中调用；
+    // 已有线程在生成时等待并共用它的结果
+    // 参数:
+    //   - error: 失败时写入原因（可以为空）
+    // 返回值：快照，列式存储后端或生成失败时为空
+    static std::shared_ptr<Snapshot> acquire(QString* error = nullptr);
+
+    // invalidate 函数在数据提交修改后调用，下一次 acquire 重新生成快照；正在使用旧快照的报表不受影响，可以在任意线程中调用
+    static void invalidate();
+
+    // backup 函数立即生成一份热备份并按保留份数删除旧备份，可以在任意线程中调用
+    // 参数:
+    //   - error: 失败时写入原因（可以为空）
+    // 返回值：备份文件路径，失败时为空
+    static QString backup(QString* error = nullptr);
+
+    // install 函数在启动时调用（主线程）：删除上次异常退出遗留的快照，按配置登记定时备份
+    static void install();
+
+    // 最近的快照和备份，用于诊断窗口，不会等待正在进行的复制
+    static QString toText();
+
+private:
+    // copyTo 函数把当前数据库的时间点副本写到 target（先写临时文件，完成后改名）
+    // 参数:
+    //   - target: 目标文件，已存在时覆盖
+    //   - connectionName: 执行复制的连接名，在调用线程中打开和关闭
+    //   - requireWal: 为 true 时数据库不在 WAL 模式则不复制并返回 false
+    //   - bytes: 写入副本的大小
+    //   - error: 失败时写入原因（可以为空）
+    // 返回值：是否成功
+    static bool copyTo(const QString& target, const QString& connectionName, bool requireWal, qint64& bytes, QString* error);
+};
+
+#endif // DATABASESNAPSHOT_H
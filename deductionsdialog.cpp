@@ -0,0 +1,66 @@
+﻿#include "deductionsdialog.h"
+#include <QDialogButtonBox>
+#include <QDoubleSpinBox>
+#include <QFormLayout>
+#include <QLabel>
+
+// DeductionsDialog 构造函数，创建界面
+DeductionsDialog::DeductionsDialog(const QString& title, const EmployeeDeductions& deductions, QWidget* parent)
+    : QDialog(parent)
+    , childrenEducation(createAmount(deductions.childrenEducation))
+    , housingLoanInterest(createAmount(deductions.housingLoanInterest))
+    , rent(createAmount(deductions.rent))
+    , elderlySupport(createAmount(deductions.elderlySupport))
+    , socialInsurance(createAmount(deductions.socialInsurance))
+    , total(new QLabel(this))
+{
+    setWindowTitle(QString::fromLocal8Bit("专项扣除 - %1").arg(title));
+
+    QDialogButtonBox* buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, this);
+
+    QFormLayout* layout = new QFormLayout(this);
+    layout->addRow(QString::fromLocal8Bit("子女教育"), childrenEducation);
+    layout->addRow(QString::fromLocal8Bit("住房贷款利息"), housingLoanInterest);
+    layout->addRow(QString::fromLocal8Bit("住房租金"), rent);
+    layout->addRow(QString::fromLocal8Bit("赡养老人"), elderlySupport);
+    layout->addRow(QString::fromLocal8Bit("社会保险（个人）"), socialInsurance);
+    layout->addRow(QString::fromLocal8Bit("每月合计"), total);
+    layout->addRow(buttons);
+
+    for (QDoubleSpinBox* amount : { childrenEducation, housingLoanInterest, rent, elderlySupport, socialInsurance })
+    {
+        connect(amount, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &DeductionsDialog::updateTotal);
+    }
+    connect(buttons, &QDialogButtonBox::accepted, this, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    updateTotal();
+}
+
+// 创建金额输入框
+QDoubleSpinBox* DeductionsDialog::createAmount(double value)
+{
+    QDoubleSpinBox* amount = new QDoubleSpinBox(this);
+    amount->setRange(0, 1000000);
+    amount->setDecimals(2);
+    amount->setSuffix(QString::fromLocal8Bit(" 元"));
+    amount->setValue(value);
+    return amount;
+}
+
+// 编辑后的专项扣除
+EmployeeDeductions DeductionsDialog::deductions() const
+{
+    EmployeeDeductions result;
+    result.childrenEducation = childrenEducation->value();
+    result.housingLoanInterest = housingLoanInterest->value();
+    result.rent = rent->value();
+    result.elderlySupport = elderlySupport->value();
+    result.socialInsurance = socialInsurance->value();
+    return result;
+}
+
+// 更新合计
+void DeductionsDialog::updateTotal()
+{
+    total->setText(QString::fromLocal8Bit("%1 元").arg(deductions().total(), 0, 'f', 2));
+}
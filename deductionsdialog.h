@@ -0,0 +1,43 @@
+﻿#ifndef DEDUCTIONSDIALOG_H
+#define DEDUCTIONSDIALOG_H
+
+#include <QDialog>
+#include "employeestore.h"
+
+class QDoubleSpinBox;
+class QLabel;
+
+// DeductionsDialog 类用于编辑一名员工每月的专项扣除，确定后由调用方写回存储并重新计税
+class DeductionsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    // 构造函数
+    // 参数:
+    //   - title: 窗口标题中显示的员工信息
+    //   - deductions: 当前的专项扣除
+    DeductionsDialog(const QString& title, const EmployeeDeductions& deductions, QWidget* parent = nullptr);
+
+    // 编辑后的专项扣除
+    EmployeeDeductions deductions() const;
+
+private slots:
+    // 任一项变化时更新合计
+    void updateTotal();
+
+private:
+    // 创建一个金额输入框
+    QDoubleSpinBox* createAmount(double value);
+
+    QDoubleSpinBox* childrenEducation;
+    QDoubleSpinBox* housingLoanInterest;
+    QDoubleSpinBox* rent;
+    QDoubleSpinBox* elderlySupport;
+    QDoubleSpinBox* socialInsurance;
+
+    // 合计
+    QLabel* total;
+};
+
+#endif // DEDUCTIONSDIALOG_H
@@ -0,0 +1,117 @@
+﻿#include "diagnosticsdialog.h"
+#include "metricsregistry.h"  // 指标注册表
+#include "slowquerylog.h"     // 按语句形状汇总的 SQL 统计
+#include "allocationtracker.h" // 按操作统计的堆分配
+#include "jobscheduler.h"     // 后台任务列表
+#include "databasemaintenance.h" // 数据库维护记录
+#include "databasesnapshot.h" // 报表快照与备份
+#include <QFileDialog>
+#include <QFontDatabase>
+#include <QHBoxLayout>
+#include <QMessageBox>
+#include <QPlainTextEdit>
+#include <QScrollBar>
+#include <QPushButton>
+#include <QTimer>
+#include <QVBoxLayout>
+
+// DiagnosticsDialog 构造函数，创建界面
+DiagnosticsDialog::DiagnosticsDialog(QWidget* parent)
+    : QDialog(parent)
+    , text(new QPlainTextEdit(this))
+    , refreshTimer(new QTimer(this))
+{
+    setWindowTitle(QString::fromLocal8Bit("诊断信息"));
+    resize(720, 520);
+
+    // 指标文本使用等宽字体，便于对齐
+    text->setReadOnly(true);
+    text->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+
+    QPushButton* refreshButton = new QPushButton(QString::fromLocal8Bit("刷新"), this);
+    QPushButton* jsonButton = new QPushButton(QString::fromLocal8Bit("导出 JSON..."), this);
+    QPushButton* prometheusButton = new QPushButton(QString::fromLocal8Bit("导出 Prometheus..."), this);
+    QPushButton* closeButton = new QPushButton(QString::fromLocal8Bit("关闭"), this);
+
+    QHBoxLayout* buttons = new QHBoxLayout();
+    buttons->addWidget(refreshButton);
+    buttons->addStretch();
+    buttons->addWidget(jsonButton);
+    buttons->addWidget(prometheusButton);
+    buttons->addWidget(closeButton);
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->addWidget(text);
+    layout->addLayout(buttons);
+
+    connect(refreshButton, &QPushButton::clicked, this, &DiagnosticsDialog::refresh);
+    connect(jsonButton, &QPushButton::clicked, this, &DiagnosticsDialog::exportJson);
+    connect(prometheusButton, &QPushButton::clicked, this, &DiagnosticsDialog::exportPrometheus);
+    connect(closeButton, &QPushButton::clicked, this, &QDialog::close);
+
+    refreshTimer->setInterval(1000);
+    connect(refreshTimer, &QTimer::timeout, this, &DiagnosticsDialog::refresh);
+}
+
+// 显示时立即刷新并开始定时刷新
+void DiagnosticsDialog::showEvent(QShowEvent* event)
+{
+    refresh();
+    refreshTimer->start();
+    QDialog::showEvent(event);
+}
+
+// 隐藏时停止刷新
+void DiagnosticsDialog::hideEvent(QHideEvent* event)
+{
+    refreshTimer->stop();
+    QDialog::hideEvent(event);
+}
+
+// 重新读取指标，保持滚动位置
+void DiagnosticsDialog::refresh()
+{
+    int scroll = text->verticalScrollBar() ? text->verticalScrollBar()->value() : 0;
+    text->setPlainText(MetricsRegistry::instance().toText()
+        + "\n== SQL statements ==\n"
+        + SlowQueryLog::instance().toText()
+        + "\n== Allocations ==\n"
+        + AllocationTracker::toText()
+        + "\n== Jobs ==\n"
+        + JobScheduler::instance().toText()
+        + "\n== Database maintenance ==\n"
+        + DatabaseMaintenance::toText()
+        + "\n== Snapshots ==\n"
+        + DatabaseSnapshot::toText());
+    if (text->verticalScrollBar())
+    {
+        text->verticalScrollBar()->setValue(scroll);
+    }
+}
+
+// 导出为 JSON
+void DiagnosticsDialog::exportJson()
+{
+    exportTo("JSON (*.json)", ".json");
+}
+
+// 导出为 Prometheus 文本
+void DiagnosticsDialog::exportPrometheus()
+{
+    exportTo("Prometheus (*.prom *.txt)", ".prom");
+}
+
+// 选择文件并写出
+void DiagnosticsDialog::exportTo(const QString& filter, const QString& suffix)
+{
+    QString path = QFileDialog::getSaveFileName(this, QString::fromLocal8Bit("导出指标"), "metrics" + suffix, filter);
+    if (path.isEmpty())
+    {
+        return;
+    }
+
+    if (!MetricsRegistry::instance().dumpToFile(path))
+    {
+        QMessageBox::warning(this, QString::fromLocal8Bit("导出失败"), QString::fromLocal8Bit("无法写入文件！"));
+    }
+}
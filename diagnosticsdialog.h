@@ -0,0 +1,44 @@
+﻿#ifndef DIAGNOSTICSDIALOG_H
+#define DIAGNOSTICSDIALOG_H
+
+#include <QDialog>
+
+class QPlainTextEdit;
+class QTimer;
+
+// DiagnosticsDialog 类显示指标注册表中的全部计数器、瞬时值和延迟分布
+// 窗口可见时每秒刷新一次，并可以把指标导出为 JSON 或 Prometheus 文本文件
+class DiagnosticsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit DiagnosticsDialog(QWidget* parent = nullptr);
+
+protected:
+    // 显示时开始定时刷新，隐藏时停止，避免后台无意义地唤醒
+    void showEvent(QShowEvent* event) override;
+    void hideEvent(QHideEvent* event) override;
+
+private slots:
+    // 重新读取指标
+    void refresh();
+
+    // 导出为 JSON 文件
+    void exportJson();
+
+    // 导出为 Prometheus 文本文件
+    void exportPrometheus();
+
+private:
+    // 选择文件并写出
+    void exportTo(const QString& filter, const QString& suffix);
+
+    // 指标文本
+    QPlainTextEdit* text;
+
+    // 刷新定时器
+    QTimer* refreshTimer;
+};
+
+#endif // DIAGNOSTICSDIALOG_H
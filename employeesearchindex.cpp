@@ -0,0 +1,148 @@
+﻿#include "employeesearchindex.h"
+#include <algorithm>
+
+// 按 (key, id) 排序
+bool EmployeeSearchIndex::keyLess(const Key& left, const Key& right)
+{
+    int order = QString::compare(left.key, right.key);
+    return order < 0 || (order == 0 && left.id < right.id);
+}
+
+// 在有序数组中插入一项
+void EmployeeSearchIndex::insertKey(std::vector<Key>& keys, const Key& key)
+{
+    keys.insert(std::lower_bound(keys.begin(), keys.end(), key, keyLess), key);
+}
+
+// 从有序数组中删除一项
+void EmployeeSearchIndex::eraseKey(std::vector<Key>& keys, const Key& key)
+{
+    auto it = std::lower_bound(keys.begin(), keys.end(), key, keyLess);
+    if (it != keys.end() && it->id == key.id && it->key == key.key)
+    {
+        keys.erase(it);
+    }
+}
+
+// 姓名的索引键
+QString EmployeeSearchIndex::nameKey(const QString& name)
+{
+    return name.toCaseFolded();
+}
+
+// 全量构建
+void EmployeeSearchIndex::build(const std::vector<std::pair<int, QString>>& displays, const std::vector<QString>& names)
+{
+    clear();
+    size_t count = qMin(displays.size(), names.size());
+    entries.reserve(int(count));
+    nameKeys.reserve(count);
+    idKeys.reserve(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        int id = displays[i].first;
+        entries.insert(id, Entry{ names[i], displays[i].second });
+        nameKeys.push_back(Key{ nameKey(names[i]), id });
+        idKeys.push_back(Key{ QString::number(id), id });
+    }
+
+    std::sort(nameKeys.begin(), nameKeys.end(), keyLess);
+    std::sort(idKeys.begin(), idKeys.end(), keyLess);
+}
+
+// 添加或修改一名员工
+void EmployeeSearchIndex::upsert(int id, const QString& name, const QString& display)
+{
+    lastValid = false;
+
+    auto it = entries.find(id);
+    if (it != entries.end())
+    {
+        // 姓名变化时移动姓名键，ID 键保持不变
+        if (it->name != name)
+        {
+            eraseKey(nameKeys, Key{ nameKey(it->name), id });
+            insertKey(nameKeys, Key{ nameKey(name), id });
+        }
+        it->name = name;
+        it->display = display;
+        return;
+    }
+
+    entries.insert(id, Entry{ name, display });
+    insertKey(nameKeys, Key{ nameKey(name), id });
+    insertKey(idKeys, Key{ QString::number(id), id });
+}
+
+// 删除一名员工
+void EmployeeSearchIndex::remove(int id)
+{
+    auto it = entries.find(id);
+    if (it == entries.end())
+    {
+        return;
+    }
+
+    lastValid = false;
+    eraseKey(nameKeys, Key{ nameKey(it->name), id });
+    eraseKey(idKeys, Key{ QString::number(id), id });
+    entries.erase(it);
+}
+
+// 清空索引
+void EmployeeSearchIndex::clear()
+{
+    entries.clear();
+    nameKeys.clear();
+    idKeys.clear();
+    lastValid = false;
+}
+
+// 前缀查询
+std::vector<std::pair<int, QString>> EmployeeSearchIndex::search(const QString& text, int limit, int& total)
+{
+    // 全部是数字时按 ID 前缀查询
+    bool byId = !text.isEmpty();
+    for (QChar ch : text)
+    {
+        if (!ch.isDigit())
+        {
+            byId = false;
+            break;
+        }
+    }
+
+    QString prefix = byId ? text : nameKey(text);
+    const std::vector<Key>& keys = byId ? idKeys : nameKeys;
+
+    // 继续输入时只在上一次的结果区间内查找
+    size_t begin = 0;
+    size_t end = keys.size();
+    if (lastValid && lastById == byId && prefix.startsWith(lastPrefix))
+    {
+        begin = lastBegin;
+        end = lastEnd;
+    }
+
+    // 第一个不小于前缀的键开始，连续若干个键以前缀开头
+    auto first = std::lower_bound(keys.begin() + begin, keys.begin() + end, prefix,
+        [](const Key& key, const QString& value) { return QString::compare(key.key, value) < 0; });
+    auto last = std::partition_point(first, keys.begin() + end,
+        [&prefix](const Key& key) { return key.key.startsWith(prefix); });
+
+    lastPrefix = prefix;
+    lastById = byId;
+    lastBegin = size_t(first - keys.begin());
+    lastEnd = size_t(last - keys.begin());
+    lastValid = true;
+
+    total = int(last - first);
+    std::vector<std::pair<int, QString>> result;
+    result.reserve(size_t(qMin(total, qMax(0, limit))));
+    for (auto it = first; it != last && int(result.size()) < limit; ++it)
+    {
+        result.push_back(std::make_pair(it->id, entries.value(it->id).display));
+    }
+    return result;
+}
@@ -0,0 +1,76 @@
+﻿#ifndef EMPLOYEESEARCHINDEX_H
+#define EMPLOYEESEARCHINDEX_H
+
+#include <QHash>
+#include <QString>
+#include <utility>
+#include <vector>
+
+// EmployeeSearchIndex 类是员工姓名和 ID 的内存前缀索引，用于边输入边搜索
+// 姓名（忽略大小写）和十进制 ID 各保存一个有序数组，前缀查询只需两次二分查找；
+// 新的输入以上一次输入开头时（继续输入），只在上一次的结果区间内查找，逐字缩小范围。
+// 索引本身不加锁：在后台线程构建完成后交给界面线程，之后只在界面线程上读写。
+class EmployeeSearchIndex
+{
+public:
+    // 全量构建，names[i] 是 displays[i] 对应员工的姓名
+    void build(const std::vector<std::pair<int, QString>>& displays, const std::vector<QString>& names);
+
+    // 添加或修改一名员工
+    void upsert(int id, const QString& name, const QString& display);
+
+    // 删除一名员工
+    void remove(int id);
+
+    // 清空索引
+    void clear();
+
+    // 前缀查询：全部是数字时按 ID 前缀，否则按姓名前缀
+    // 参数:
+    //   - text: 输入的前缀
+    //   - limit: 最多返回的条数（按姓名或 ID 排序后的前 limit 条）
+    //   - total: 输出匹配的总条数
+    // 返回值：与 EmployeeStore::queryEmployees 格式相同的员工列表
+    std::vector<std::pair<int, QString>> search(const QString& text, int limit, int& total);
+
+    // 索引中的员工数量
+    int size() const { return entries.size(); }
+
+private:
+    // 有序数组中的一项
+    struct Key
+    {
+        QString key;
+        int id;
+    };
+
+    // 每名员工的姓名和显示文本
+    struct Entry
+    {
+        QString name;
+        QString display;
+    };
+
+    // 按 (key, id) 排序
+    static bool keyLess(const Key& left, const Key& right);
+
+    // 在有序数组中插入或删除一项
+    static void insertKey(std::vector<Key>& keys, const Key& key);
+    static void eraseKey(std::vector<Key>& keys, const Key& key);
+
+    // 姓名的索引键（忽略大小写）
+    static QString nameKey(const QString& name);
+
+    QHash<int, Entry> entries;
+    std::vector<Key> nameKeys;
+    std::vector<Key> idKeys;
+
+    // 上一次查询的前缀和结果区间，索引变化后失效
+    QString lastPrefix;
+    bool lastById = false;
+    bool lastValid = false;
+    size_t lastBegin = 0;
+    size_t lastEnd = 0;
+};
+
+#endif // EMPLOYEESEARCHINDEX_H
@@ -0,0 +1,255 @@
+﻿#include "employeestore.h"
+#include "sqlmanager.h"              // SQLite 后端
+#include "columnaremployeestore.h"   // 列式内存后端
+#include "taxcalccenter.h"           // 税率档位
+#include "configstore.h"             // storage_backend / storage_path
+#include <QDebug>
+#include <QRegExp>
+#include <cmath>
+
+namespace
+{
+    // 当前配置
+    EmployeeStore::Backend currentBackend = EmployeeStore::SqliteFile;
+    QString currentPath = "tax_system.db";
+
+    // SQLite 内存数据库在最后一个连接关闭时销毁，这个连接在进程运行期间一直保持打开
+    const char* MemoryAnchorConnection = "wagestax_memory_anchor";
+}
+
+// 范围是否不限
+bool EmployeeQuery::Range::isUnbounded() const
+{
+    return std::isinf(minimum) && minimum < 0 && std::isinf(maximum) && maximum > 0;
+}
+
+// 值是否在范围内
+bool EmployeeQuery::Range::contains(double value) const
+{
+    bool aboveMinimum = minimumExclusive ? value > minimum : value >= minimum;
+    bool belowMaximum = maximumExclusive ? value < maximum : value <= maximum;
+    return aboveMinimum && belowMaximum;
+}
+
+// 解析范围文本
+bool EmployeeQuery::Range::parse(const QString& text, Range& range)
+{
+    range = Range();
+    QString value = text.trimmed();
+    if (value.isEmpty())
+    {
+        return true;
+    }
+
+    bool ok = false;
+
+    // 比较运算符开头：>、>=、<、<=
+    if (value.startsWith('>') || value.startsWith('<'))
+    {
+        bool greater = value.startsWith('>');
+        bool inclusive = value.size() > 1 && value.at(1) == '=';
+        double bound = value.mid(inclusive ? 2 : 1).trimmed().toDouble(&ok);
+        if (!ok)
+        {
+            return false;
+        }
+        if (greater)
+        {
+            range.minimum = bound;
+            range.minimumExclusive = !inclusive;
+        }
+        else
+        {
+            range.maximum = bound;
+            range.maximumExclusive = !inclusive;
+        }
+        return true;
+    }
+
+    // 区间：a-b 或 a~b（从第二个字符开始找分隔符，允许负数下界）
+    int separator = value.indexOf(QRegExp("[-~]"), 1);
+    if (separator > 0)
+    {
+        bool okMaximum = false;
+        range.minimum = value.left(separator).trimmed().toDouble(&ok);
+        range.maximum = value.mid(separator + 1).trimmed().toDouble(&okMaximum);
+        return ok && okMaximum && range.minimum <= range.maximum;
+    }
+
+    // 单个数值：等于
+    range.minimum = range.maximum = value.toDouble(&ok);
+    return ok;
+}
+
+// 是否为默认条件
+bool EmployeeQuery::isDefault() const
+{
+    return sortKey == ById && !descending && salary.isUnbounded() && tax.isUnbounded();
+}
+
+// 专项扣除合计
+double EmployeeDeductions::total() const
+{
+    return childrenEducation + housingLoanInterest + rent + elderlySupport + socialInsurance;
+}
+
+static_assert(PayrollSummary::BracketCount == TaxCalcCenter::BracketCount + 1, "summary brackets must match the tax table");
+
+// 计入或移出一名员工
+void PayrollSummary::add(double salary, double deduction, double tax, int sign)
+{
+    Bracket& bracket = brackets[TaxCalcCenter::bracketOf(salary - deduction)];
+    bracket.headcount += sign;
+    bracket.totalSalary += sign * salary;
+    bracket.totalTax += sign * tax;
+}
+
+// 总人数
+qint64 PayrollSummary::headcount() const
+{
+    qint64 total = 0;
+    for (const Bracket& bracket : brackets)
+    {
+        total += bracket.headcount;
+    }
+    return total;
+}
+
+// 工资总额
+double PayrollSummary::totalSalary() const
+{
+    double total = 0;
+    for (const Bracket& bracket : brackets)
+    {
+        total += bracket.totalSalary;
+    }
+    return total;
+}
+
+// 税额总额
+double PayrollSummary::totalTax() const
+{
+    double total = 0;
+    for (const Bracket& bracket : brackets)
+    {
+        total += bracket.totalTax;
+    }
+    return total;
+}
+
+// 平均实际税率
+double PayrollSummary::effectiveRate() const
+{
+    double salary = totalSalary();
+    return salary > 0 ? totalTax() / salary : 0;
+}
+
+// 全局事件实例
+EmployeeStoreEvents* EmployeeStoreEvents::instance()
+{
+    static EmployeeStoreEvents events;
+    return &events;
+}
+
+// 按当前配置创建存储对象
+std::unique_ptr<EmployeeStore> EmployeeStore::create(const QString& connectionName)
+{
+    if (currentBackend == Columnar)
+    {
+        return std::unique_ptr<EmployeeStore>(new ColumnarEmployeeStore());
+    }
+    return std::unique_ptr<EmployeeStore>(new SqlManager(connectionName));
+}
+
+// 选择后端和路径
+void EmployeeStore::configure(Backend backend, const QString& path)
+{
+    currentBackend = backend;
+    if (!path.isEmpty())
+    {
+        currentPath = path;
+    }
+
+    // 内存数据库由调用线程（主线程）上的常驻连接保持存活
+    if (backend == SqliteMemory && !QSqlDatabase::contains(MemoryAnchorConnection))
+    {
+        SqlManager anchor(MemoryAnchorConnection);
+        anchor.createSql();
+    }
+}
+
+// 从配置和命令行读取后端设置
+void EmployeeStore::loadConfiguration(const QStringList& arguments)
+{
+    QString name = ConfigStore::instance().value("storage_backend");
+    QString path = ConfigStore::instance().value("storage_path");
+
+    // 命令行参数优先于配置文件
+    int backendIndex = arguments.indexOf("--storage");
+    if (backendIndex >= 0 && backendIndex + 1 < arguments.size())
+    {
+        name = arguments.at(backendIndex + 1);
+    }
+    int pathIndex = arguments.indexOf("--storage-path");
+    if (pathIndex >= 0 && pathIndex + 1 < arguments.size())
+    {
+        path = arguments.at(pathIndex + 1);
+    }
+
+    Backend backend = SqliteFile;
+    if (!name.isEmpty() && !parseBackend(name, backend))
+    {
+        qWarning() << "Unknown storage backend" << name << "- using sqlite.";
+    }
+    configure(backend, path);
+    qDebug() << "Employee store:" << backendName() << (backend == SqliteFile ? currentPath : QString());
+}
+
+// 按名称解析后端
+bool EmployeeStore::parseBackend(const QString& name, Backend& backend)
+{
+    QString key = name.trimmed().toLower();
+    if (key == "sqlite" || key == "file")
+    {
+        backend = SqliteFile;
+    }
+    else if (key == "memory" || key == ":memory:")
+    {
+        backend = SqliteMemory;
+    }
+    else if (key == "columnar")
+    {
+        backend = Columnar;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+// 当前后端
+EmployeeStore::Backend EmployeeStore::backend()
+{
+    return currentBackend;
+}
+
+// 当前后端名称
+QString EmployeeStore::backendName()
+{
+    switch (currentBackend)
+    {
+    case SqliteMemory:
+        return "memory";
+    case Columnar:
+        return "columnar";
+    default:
+        return "sqlite";
+    }
+}
+
+// 当前数据库文件
+QString EmployeeStore::path()
+{
+    return currentPath;
+}
@@ -0,0 +1,226 @@
+﻿#ifndef EMPLOYEESTORE_H
+#define EMPLOYEESTORE_H
+
+#include <QObject>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+#include <limits>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// EmployeeDeductions 结构体是一名员工每月的专项扣除（元），计税时与起征点一起从工资中扣除
+struct EmployeeDeductions
+{
+    double childrenEducation = 0;    // 子女教育
+    double housingLoanInterest = 0;  // 住房贷款利息
+    double rent = 0;                 // 住房租金
+    double elderlySupport = 0;       // 赡养老人
+    double socialInsurance = 0;      // 个人缴纳的社会保险
+
+    // 扣除合计
+    double total() const;
+};
+
+// EmployeeRecord 结构体是一名员工的完整数据
+struct EmployeeRecord
+{
+    int id = 0;
+    QString name;
+    double salary = 0;
+    double tax = 0;
+    double deduction = 0;  // 专项扣除合计，分页读取时已与员工数据关联好，批量计税不需要逐行回查
+    double socialInsurance = 0;  // 合计中手工填写的个人社会保险，按城市规则计算缴费时要从合计中去掉
+};
+
+// EmployeeQuery 结构体描述一次排序和范围查询，由存储后端编译为带索引的 SQL 或列扫描
+struct EmployeeQuery
+{
+    // 排序字段，相同值之间再按 ID 排序，结果顺序稳定
+    enum SortKey
+    {
+        ById,
+        ByName,
+        BySalary,
+        ByTax
+    };
+
+    // 数值范围，默认不限；Exclusive 为 true 时不包含端点
+    struct Range
+    {
+        double minimum = -std::numeric_limits<double>::infinity();
+        double maximum = std::numeric_limits<double>::infinity();
+        bool minimumExclusive = false;
+        bool maximumExclusive = false;
+
+        // 是否不限
+        bool isUnbounded() const;
+
+        // 值是否在范围内
+        bool contains(double value) const;
+
+        // 解析范围文本："8000-12000"、"8000~12000"、">0"、">=100"、"<5000"、"<=5000"、"8000"（等于）
+        // 空文本表示不限；格式错误时返回 false
+        static bool parse(const QString& text, Range& range);
+    };
+
+    SortKey sortKey = ById;
+    bool descending = false;
+    Range salary;
+    Range tax;
+
+    // 最多返回的行数
+    int limit = 1000;
+
+    // 是否为默认条件（按 ID 升序、不限范围），此时界面按原方式显示全部员工
+    bool isDefault() const;
+};
+
+// PayrollSummary 结构体是全体员工的工资汇总，按税率档位分组
+// 存储后端在每次增删改时增量维护，读取汇总不需要扫描员工表
+struct PayrollSummary
+{
+    // 档位数量：0 档为未达起征点，1 ~ 9 档对应税率表各档（见 TaxCalcCenter::bracketOf）
+    static const int BracketCount = 10;
+
+    // 一个档位的人数、工资总额和税额总额
+    struct Bracket
+    {
+        qint64 headcount = 0;
+        double totalSalary = 0;
+        double totalTax = 0;
+    };
+
+    Bracket brackets[BracketCount];
+
+    // 计入（sign 为 1）或移出（sign 为 -1）一名员工，档位按扣除专项扣除后的工资划分，与税额一致
+    void add(double salary, double deduction, double tax, int sign);
+
+    // 全体合计
+    qint64 headcount() const;
+    double totalSalary() const;
+    double totalTax() const;
+
+    // 平均实际税率（税额总额 / 工资总额）
+    double effectiveRate() const;
+};
+
+// EmployeeStoreEvents 类在员工数据变化时发出信号，搜索索引等内存结构据此保持同步
+// 所有存储后端共用一个全局实例；信号可能在后台线程发出，接收方在界面线程时使用排队连接
+class EmployeeStoreEvents : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 全局实例
+    static EmployeeStoreEvents* instance();
+
+signals:
+    // 添加或修改了一名员工，salary 为新的工资，display 为格式化后的显示文本
+    void employeeSaved(int id, const QString& name, double salary, const QString& display);
+
+    // 删除了一名员工
+    void employeeRemoved(int id);
+
+    // 批量导入或清空后数据整体发生变化，接收方应当重新加载
+    void employeesReset();
+};
+
+// EmployeeStore 类是员工数据存储的抽象接口，界面、预加载器和基准测试都只依赖这个接口
+// 可选的后端：
+//   - SqliteFile：磁盘上的 SQLite 数据库文件（默认 tax_system.db）
+//   - SqliteMemory：SQLite 内存数据库，同一进程内的所有连接共享同一份数据，进程退出即丢失
+//   - Columnar：不经过 SQL 的纯内存列式存储，工资和税额各占一列连续数组，适合大规模模拟
+// 后端和路径由 config.txt 中的 storage_backend / storage_path 或命令行 --storage / --storage-path 选择
+class EmployeeStore
+{
+public:
+    // 存储后端
+    enum Backend
+    {
+        SqliteFile,
+        SqliteMemory,
+        Columnar
+    };
+
+    virtual ~EmployeeStore() = default;
+
+    // open 函数打开存储（必要时创建表结构），成功返回 true
+    virtual bool open() = 0;
+
+    // close 函数关闭存储，后台线程使用完临时连接后应调用它
+    virtual void close() = 0;
+
+    // addEmployee 函数添加一名员工，税额自动计算，成功返回 true
+    virtual bool addEmployee(const QString& name, double salary) = 0;
+
+    // addEmployees 函数批量添加员工，返回成功写入的条数
+    virtual int addEmployees(const std::vector<std::pair<QString, double>>& employees) = 0;
+
+    // updateEmployee 函数修改员工姓名和工资，并重新计算税额；员工不存在或写入失败（例如数据库忙）时返回 false
+    virtual bool updateEmployee(int id, const QString& name, double salary) = 0;
+
+    // deductions 函数返回员工的专项扣除，没有设置时各项为 0
+    virtual EmployeeDeductions deductions(int id) = 0;
+
+    // setDeductions 函数设置员工的专项扣除并重新计算税额，员工不存在时返回 false
+    virtual bool setDeductions(int id, const EmployeeDeductions& deductions) = 0;
+
+    // deleteEmployee 函数删除指定员工（连同专项扣除），员工不存在或写入失败时返回 false
+    virtual bool deleteEmployee(int id) = 0;
+
+    // clear 函数删除全部员工，之后新员工的 ID 从 1 开始
+    virtual void clear() = 0;
+
+    // queryEmployees 函数返回全部员工（ID 和格式化后的显示文本）
+    virtual std::vector<std::pair<int, QString>> queryEmployees() = 0;
+
+    // queryEmployeeByIdOrName 函数按 ID（-1 表示不限）和姓名（空表示不限）查询
+    virtual std::vector<std::pair<int, QString>> queryEmployeeByIdOrName(int id, const QString& name) = 0;
+
+    // queryEmployeeByIdOrName 函数重载，按 ID 查询员工的 ID、姓名和工资
+    virtual std::vector<std::tuple<int, QString, double>> queryEmployeeByIdOrName(int id) = 0;
+
+    // queryEmployeesAfter 函数按 ID 顺序分页查询，lastId 为上一页最后一名员工的 ID
+    virtual std::vector<std::pair<int, QString>> queryEmployeesAfter(int lastId, int limit) = 0;
+
+    // queryEmployees 函数重载，按排序和范围条件查询，最多返回 query.limit 行
+    virtual std::vector<std::pair<int, QString>> queryEmployees(const EmployeeQuery& query) = 0;
+
+    // countEmployees 函数重载，返回满足范围条件的员工总数（忽略排序和行数限制）
+    virtual int countEmployees(const EmployeeQuery& query) = 0;
+
+    // queryRecordsAfter 函数与 queryEmployeesAfter 相同，但返回未格式化的完整数据
+    virtual std::vector<EmployeeRecord> queryRecordsAfter(int lastId, int limit) = 0;
+
+    // countEmployees 函数返回员工总数，失败时返回 -1
+    virtual int countEmployees() = 0;
+
+    // payrollSummary 函数返回增量维护的工资汇总，耗时与员工数量无关
+    virtual PayrollSummary payrollSummary() = 0;
+
+    // create 函数按当前配置创建存储对象
+    // 参数:
+    //   - connectionName: SQLite 后端使用的连接名（线程规则见 SqlManager 构造函数）
+    static std::unique_ptr<EmployeeStore> create(const QString& connectionName = QLatin1String(QSqlDatabase::defaultConnection));
+
+    // configure 函数选择后端和路径（路径只对 SqliteFile 有效，为空时使用 tax_system.db）
+    // 需要在创建任何存储对象之前调用
+    static void configure(Backend backend, const QString& path = QString());
+
+    // loadConfiguration 函数从 ConfigStore 读取后端设置，命令行参数优先
+    // 需要在 ConfigStore::load 之后调用
+    static void loadConfiguration(const QStringList& arguments);
+
+    // 按名称（sqlite / memory / columnar）解析后端，无法识别时返回 false
+    static bool parseBackend(const QString& name, Backend& backend);
+
+    // 当前后端、后端名称和数据库文件
+    static Backend backend();
+    static QString backendName();
+    static QString path();
+};
+
+#endif // EMPLOYEESTORE_H
@@ -0,0 +1,61 @@
+﻿#include "instrumentedapplication.h"
+#include "metricsregistry.h"  // 指标注册表
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QThread>
+
+namespace
+{
+    // 当前线程的事件分发嵌套深度
+    thread_local int dispatchDepth = 0;
+
+    // 离开作用域时恢复嵌套深度（事件处理抛出异常时也能恢复）
+    struct DepthGuard
+    {
+        DepthGuard() { ++dispatchDepth; }
+        ~DepthGuard() { --dispatchDepth; }
+    };
+}
+
+// InstrumentedApplication 构造函数
+InstrumentedApplication::InstrumentedApplication(int& argc, char** argv)
+    : QApplication(argc, argv)
+{
+
+}
+
+// 事件分发并计时
+bool InstrumentedApplication::notify(QObject* receiver, QEvent* event)
+{
+    // 只统计界面线程的最外层事件
+    if (dispatchDepth > 0 || QThread::currentThread() != thread())
+    {
+        return QApplication::notify(receiver, event);
+    }
+
+    static MetricsHistogram& allEvents = MetricsRegistry::instance().histogram(
+        "wagestax_event_dispatch_ns", "kind=\"all\"", "GUI thread top-level event dispatch latency in nanoseconds");
+    static MetricsHistogram& queuedSlots = MetricsRegistry::instance().histogram(
+        "wagestax_event_dispatch_ns", "kind=\"queued_slot\"");
+    static MetricsHistogram& inputEvents = MetricsRegistry::instance().histogram(
+        "wagestax_event_dispatch_ns", "kind=\"input\"");
+
+    QEvent::Type type = event->type();
+    DepthGuard guard;
+    QElapsedTimer timer;
+    timer.start();
+
+    bool handled = QApplication::notify(receiver, event);
+
+    quint64 elapsed = quint64(timer.nsecsElapsed());
+    allEvents.record(elapsed);
+    if (type == QEvent::MetaCall)
+    {
+        queuedSlots.record(elapsed);
+    }
+    else if (type == QEvent::MouseButtonRelease || type == QEvent::KeyPress || type == QEvent::KeyRelease)
+    {
+        inputEvents.record(elapsed);
+    }
+    return handled;
+}
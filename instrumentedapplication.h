@@ -0,0 +1,18 @@
+﻿#ifndef INSTRUMENTEDAPPLICATION_H
+#define INSTRUMENTEDAPPLICATION_H
+
+#include <QApplication>
+
+// InstrumentedApplication 类在 QApplication 的事件分发入口处计时
+// 界面线程每个顶层事件（包括排队调用的槽函数和触发 clicked 等槽函数的输入事件）的处理耗时
+// 都会记录到指标直方图中，用于发现阻塞界面的慢槽函数
+class InstrumentedApplication : public QApplication
+{
+public:
+    InstrumentedApplication(int& argc, char** argv);
+
+    // 事件分发，嵌套分发（例如在槽函数里弹出模态对话框）只计最外层一次
+    bool notify(QObject* receiver, QEvent* event) override;
+};
+
+#endif // INSTRUMENTEDAPPLICATION_H
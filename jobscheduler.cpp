@@ -0,0 +1,530 @@
+﻿#include "jobscheduler.h"
+#include "configstore.h"      // 线程数与空闲判定时长
+#include "metricsregistry.h"  // 任务耗时统计
+#include "tracerecorder.h"    // 时间线区间
+#include <QCoreApplication>
+#include <QDebug>
+#include <QEvent>
+#include <QMutex>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QSet>
+#include <QStringList>
+#include <QThread>
+#include <bitset>
+#include <limits>
+#include <vector>
+
+namespace
+{
+    // 包装一个函数的线程池任务
+    class FunctionRunnable : public QRunnable
+    {
+    public:
+        explicit FunctionRunnable(std::function<void()> function) : function(std::move(function)) {}
+        void run() override { function(); }
+
+    private:
+        std::function<void()> function;
+    };
+
+    // 解析后的 cron 表达式，每个字段是允许取值的位集合
+    struct CronSpec
+    {
+        std::bitset<60> minutes;
+        std::bitset<24> hours;
+        std::bitset<32> days;       // 1 ~ 31
+        std::bitset<13> months;     // 1 ~ 12
+        std::bitset<7> weekdays;    // 0 ~ 6，0 为星期日
+        bool anyDay = false;
+        bool anyWeekday = false;
+
+        // 日期是否满足日和星期两个字段
+        bool matchesDate(const QDate& date) const
+        {
+            const bool day = days.test(size_t(date.day()));
+            const bool weekday = weekdays.test(size_t(date.dayOfWeek() % 7));
+            if (anyDay || anyWeekday)
+            {
+                return day && weekday;
+            }
+            return day || weekday;
+        }
+    };
+
+    // 解析一个字段，例如 "*"、"5"、"1-5"、"0,30"、"*/15"、"8-18/2"
+    template <size_t N>
+    bool parseField(const QString& text, int low, int high, std::bitset<N>& bits, bool* any = nullptr)
+    {
+        for (const QString& part : text.split(','))
+        {
+            QString range = part;
+            int step = 1;
+            int slash = part.indexOf('/');
+            if (slash >= 0)
+            {
+                bool ok = false;
+                step = part.mid(slash + 1).toInt(&ok);
+                if (!ok || step <= 0)
+                {
+                    return false;
+                }
+                range = part.left(slash);
+            }
+
+            int first = low;
+            int last = high;
+            if (range == "*")
+            {
+                if (any && step == 1)
+                {
+                    *any = true;
+                }
+            }
+            else
+            {
+                bool ok = false;
+                int dash = range.indexOf('-');
+                first = (dash >= 0 ? range.left(dash) : range).toInt(&ok);
+                if (!ok)
+                {
+                    return false;
+                }
+                last = first;
+                if (dash >= 0)
+                {
+                    last = range.mid(dash + 1).toInt(&ok);
+                    if (!ok)
+                    {
+                        return false;
+                    }
+                }
+                else if (slash >= 0)
+                {
+                    last = high;
+                }
+            }
+            if (first < low || last > high || first > last)
+            {
+                return false;
+            }
+            for (int value = first; value <= last; value += step)
+            {
+                bits.set(size_t(value));
+            }
+        }
+        return true;
+    }
+
+    // 解析完整的 cron 表达式
+    bool parseCron(const QString& cron, CronSpec& spec)
+    {
+        QStringList fields = cron.simplified().split(' ');
+        if (fields.size() != 5)
+        {
+            return false;
+        }
+        std::bitset<8> weekdays;
+        if (!parseField(fields[0], 0, 59, spec.minutes)
+            || !parseField(fields[1], 0, 23, spec.hours)
+            || !parseField(fields[2], 1, 31, spec.days, &spec.anyDay)
+            || !parseField(fields[3], 1, 12, spec.months)
+            || !parseField(fields[4], 0, 7, weekdays, &spec.anyWeekday))
+        {
+            return false;
+        }
+        for (size_t day = 0; day < 7; ++day)
+        {
+            spec.weekdays[day] = weekdays[day];
+        }
+        spec.weekdays[0] = spec.weekdays[0] || weekdays[7];
+        return true;
+    }
+
+    // 按任务名区分的耗时直方图
+    MetricsHistogram& jobLatency(const QString& name)
+    {
+        return MetricsRegistry::instance().histogram("wagestax_job_ns",
+            QString("job=\"%1\"").arg(name), "JobScheduler job latency in nanoseconds");
+    }
+
+    // 时间线区间名称：TraceRecorder 只保存指针，导出时才读取，名称必须在整个进程生命周期内有效。
+    // 每个任务名只保存一份，集合只增不减，QByteArray 的数据在集合扩容时不会移动
+    const char* spanNameOf(const QString& name)
+    {
+        static QMutex mutex;
+        static QSet<QByteArray> names;
+        const QByteArray spanName = ("JobScheduler::" + name).toUtf8();
+        QMutexLocker locker(&mutex);
+        return names.insert(spanName)->constData();
+    }
+}
+
+// 全局实例
+JobScheduler& JobScheduler::instance()
+{
+    static JobScheduler scheduler;
+    return scheduler;
+}
+
+// JobScheduler 构造函数
+JobScheduler::JobScheduler()
+    : lastActivityMs(0)
+    , idleAfterMs(qint64(ConfigStore::instance().intValue("idle_after_seconds", 60)) * 1000)
+{
+    clock.start();
+    pool.setMaxThreadCount(ConfigStore::instance().intValue("scheduler_threads", qMax(2, QThread::idealThreadCount() / 2)));
+
+    timer.setSingleShot(true);
+    timer.setTimerType(Qt::CoarseTimer);
+    connect(&timer, &QTimer::timeout, this, &JobScheduler::dispatch);
+
+    if (QCoreApplication::instance())
+    {
+        QCoreApplication::instance()->installEventFilter(this);
+        connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, &JobScheduler::shutdown);
+    }
+}
+
+// 设置工作线程数上限
+void JobScheduler::setMaxThreads(int count)
+{
+    pool.setMaxThreadCount(qMax(1, count));
+}
+
+// 记录用户输入的时间，不拦截任何事件
+bool JobScheduler::eventFilter(QObject* watched, QEvent* event)
+{
+    switch (event->type())
+    {
+    case QEvent::KeyPress:
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseMove:
+    case QEvent::Wheel:
+    case QEvent::TouchBegin:
+        lastActivityMs.store(clock.elapsed(), std::memory_order_relaxed);
+        break;
+    default:
+        break;
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+// 用户是否空闲
+bool JobScheduler::isIdle() const
+{
+    return clock.elapsed() - lastActivityMs.load(std::memory_order_relaxed) >= idleAfterMs;
+}
+
+// 把任务交给线程池
+void JobScheduler::submit(const QString& name, Priority priority, std::function<void()> work, std::function<void(qint64)> done)
+{
+    MetricsHistogram& latency = jobLatency(name);
+    const char* spanName = spanNameOf(name);
+    pool.start(new FunctionRunnable([&latency, spanName, work, done]() {
+        qint64 elapsedNs = 0;
+        {
+            ScopedLatency timer(latency);
+            TraceSpan span(spanName, "worker");
+
+            // 异常不能越过线程池的线程函数；定时任务失败后照常计算下一次到期时间
+            try
+            {
+                work();
+            }
+            catch (const std::exception& e)
+            {
+                qWarning() << "Job" << spanName << "failed:" << e.what();
+            }
+            catch (...)
+            {
+                qWarning() << "Job" << spanName << "failed with an unknown exception";
+            }
+            elapsedNs = timer.elapsedNs();
+        }
+        if (done)
+        {
+            done(elapsedNs / 1000000);
+        }
+    }), int(priority));
+}
+
+// 在线程池中并行执行分块计算
+void JobScheduler::parallelFor(const QString& name, int count, const std::function<void(int)>& body)
+{
+    if (count <= 0)
+    {
+        return;
+    }
+
+    const char* spanName = spanNameOf(name);
+    std::atomic<int> next(0);
+    QSemaphore finished;
+
+    // 每个线程循环领取下一个下标，直到全部领完
+    auto drain = [&]() {
+        TraceSpan span(spanName, "worker");
+        for (int index = next.fetch_add(1); index < count; index = next.fetch_add(1))
+        {
+            try
+            {
+                body(index);
+            }
+            catch (const std::exception& e)
+            {
+                qWarning() << "Job" << spanName << "failed:" << e.what();
+            }
+            catch (...)
+            {
+                qWarning() << "Job" << spanName << "failed with an unknown exception";
+            }
+        }
+    };
+
+    // 调用线程本身也参与计算，辅助任务最多比线程数上限少一个；
+    // 辅助任务由本函数持有，返回前要么已经执行完毕，要么从队列中撤回
+    const int helperCount = qMin(count - 1, pool.maxThreadCount() - 1);
+    std::vector<std::unique_ptr<QRunnable>> helpers;
+    for (int i = 0; i < helperCount; ++i)
+    {
+        helpers.emplace_back(new FunctionRunnable([&drain, &finished]() {
+            drain();
+            finished.release();
+        }));
+        helpers.back()->setAutoDelete(false);
+        pool.start(helpers.back().get(), int(High));
+    }
+
+    drain();
+
+    // 线程池已满时辅助任务可能还在排队，此时下标已经领完，直接撤回即可
+    int started = 0;
+    for (const std::unique_ptr<QRunnable>& helper : helpers)
+    {
+        if (!pool.tryTake(helper.get()))
+        {
+            ++started;
+        }
+    }
+    finished.acquire(started);
+}
+
+// 登记定时任务
+int JobScheduler::schedule(const Job& job, Work work)
+{
+    Entry entry;
+    entry.job = job;
+    entry.work = work;
+    entry.cancelled = std::make_shared<std::atomic<bool>>(false);
+    if (!computeDue(entry, true))
+    {
+        qWarning() << "Job" << job.name << "has an invalid schedule:" << job.cron;
+        return 0;
+    }
+
+    const int id = nextId++;
+    entries.insert(id, entry);
+    arm();
+    return id;
+}
+
+// 取消定时任务
+void JobScheduler::cancel(int id)
+{
+    auto it = entries.find(id);
+    if (it == entries.end())
+    {
+        return;
+    }
+    it->cancelled->store(true);
+    if (!it->running)
+    {
+        entries.erase(it);
+    }
+    arm();
+}
+
+// 计算下一次到期时间
+bool JobScheduler::computeDue(Entry& entry, bool first)
+{
+    const qint64 now = clock.elapsed();
+    if (!entry.job.cron.isEmpty())
+    {
+        const QDateTime current = QDateTime::currentDateTime();
+        QDateTime next;
+        if (!nextCronTime(entry.job.cron, current, next))
+        {
+            return false;
+        }
+        entry.dueAt = now + current.msecsTo(next);
+        return true;
+    }
+    if (first)
+    {
+        entry.dueAt = now + qMax<qint64>(0, entry.job.delayMs);
+        return true;
+    }
+    if (entry.job.intervalMs > 0)
+    {
+        entry.dueAt = now + entry.job.intervalMs;
+        return true;
+    }
+    return false;
+}
+
+// 执行所有到期的任务
+void JobScheduler::dispatch()
+{
+    const qint64 now = clock.elapsed();
+    const bool idle = isIdle();
+    for (auto it = entries.begin(); it != entries.end(); ++it)
+    {
+        Entry& entry = it.value();
+        if (entry.running || entry.dueAt > now || (entry.job.idle && !idle))
+        {
+            continue;
+        }
+
+        entry.running = true;
+        const int id = it.key();
+        const Work work = entry.work;
+        const Context context(entry.cancelled);
+        submit(entry.job.name, entry.job.priority,
+            [work, context]() {
+                if (!context.isCancelled())
+                {
+                    work(context);
+                }
+            },
+            [this, id](qint64 elapsedMs) {
+                QMetaObject::invokeMethod(this, [this, id, elapsedMs]() { onFinished(id, elapsedMs); }, Qt::QueuedConnection);
+            });
+    }
+    arm();
+}
+
+// 定时任务执行结束
+void JobScheduler::onFinished(int id, qint64 elapsedMs)
+{
+    auto it = entries.find(id);
+    if (it == entries.end())
+    {
+        return;
+    }
+
+    Entry& entry = it.value();
+    entry.running = false;
+    entry.lastElapsedMs = elapsedMs;
+    ++entry.runs;
+    const QString name = entry.job.name;
+    if (entry.cancelled->load() || !computeDue(entry, false))
+    {
+        entries.erase(it);
+    }
+    emit jobFinished(id, name, elapsedMs);
+    arm();
+}
+
+// 按最早的到期时间设置定时器
+void JobScheduler::arm()
+{
+    const qint64 now = clock.elapsed();
+    const qint64 idleAt = lastActivityMs.load(std::memory_order_relaxed) + idleAfterMs;
+    qint64 wake = -1;
+    for (const Entry& entry : entries)
+    {
+        if (entry.running)
+        {
+            continue;
+        }
+        // 空闲任务到期后还要等到用户空闲；用户一直在操作时，每个空闲判定周期最多检查一次
+        const qint64 due = entry.job.idle ? qMax(entry.dueAt, idleAt) : entry.dueAt;
+        wake = wake < 0 ? due : qMin(wake, due);
+    }
+
+    if (wake < 0)
+    {
+        timer.stop();
+        return;
+    }
+    timer.start(int(qBound<qint64>(0, wake - now, std::numeric_limits<int>::max())));
+}
+
+// 取消全部定时任务并等待线程池中的任务结束
+void JobScheduler::shutdown()
+{
+    timer.stop();
+    for (Entry& entry : entries)
+    {
+        entry.cancelled->store(true);
+    }
+    entries.clear();
+    pool.waitForDone();
+}
+
+// 任务列表
+QString JobScheduler::toText() const
+{
+    const qint64 now = clock.elapsed();
+    QStringList lines;
+    lines << QString("threads: %1 active / %2 max, user %3")
+        .arg(pool.activeThreadCount()).arg(pool.maxThreadCount()).arg(isIdle() ? "idle" : "active");
+    for (auto it = entries.constBegin(); it != entries.constEnd(); ++it)
+    {
+        const Entry& entry = it.value();
+        QString schedule = !entry.job.cron.isEmpty() ? "cron " + entry.job.cron
+            : entry.job.intervalMs > 0 ? QString("every %1 s").arg(entry.job.intervalMs / 1000.0)
+            : QString("once");
+        lines << QString("#%1 %2  [%3%4]  %5  runs: %6  last: %7 ms")
+            .arg(it.key())
+            .arg(entry.job.name)
+            .arg(schedule)
+            .arg(entry.job.idle ? ", idle" : "")
+            .arg(entry.running ? QString("running") : QString("due in %1 s").arg(qMax<qint64>(0, entry.dueAt - now) / 1000.0, 0, 'f', 1))
+            .arg(entry.runs)
+            .arg(entry.lastElapsedMs);
+    }
+    return lines.join("\n") + "\n";
+}
+
+// 计算 cron 表达式的下一次触发时间
+bool JobScheduler::nextCronTime(const QString& cron, const QDateTime& after, QDateTime& next)
+{
+    CronSpec spec;
+    if (!parseCron(cron, spec))
+    {
+        return false;
+    }
+
+    // 从下一分钟开始，不满足的字段整段跳过（月、日、小时），最多查找一年
+    QDateTime candidate(after.date(), QTime(after.time().hour(), after.time().minute()));
+    candidate = candidate.addSecs(60);
+    const QDateTime limit = after.addDays(366);
+    while (candidate <= limit)
+    {
+        const QDate date = candidate.date();
+        const QTime time = candidate.time();
+        if (!spec.months.test(size_t(date.month())))
+        {
+            candidate = QDateTime(QDate(date.year(), date.month(), 1).addMonths(1), QTime(0, 0));
+        }
+        else if (!spec.matchesDate(date))
+        {
+            candidate = QDateTime(date.addDays(1), QTime(0, 0));
+        }
+        else if (!spec.hours.test(size_t(time.hour())))
+        {
+            candidate = QDateTime(date, QTime(time.hour(), 0)).addSecs(3600);
+        }
+        else if (!spec.minutes.test(size_t(time.minute())))
+        {
+            candidate = candidate.addSecs(60);
+        }
+        else
+        {
+            next = candidate;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,182 @@
+﻿#ifndef JOBSCHEDULER_H
+#define JOBSCHEDULER_H
+
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QFutureInterface>
+#include <QHash>
+#include <QObject>
+#include <QThreadPool>
+#include <QTimer>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+
+// JobScheduler 类是程序中后台任务的统一入口：
+//   - 工作线程数有上限（配置项 scheduler_threads），任务按优先级排队，空闲的线程一段时间后自动退出；
+//   - run 立即提交一次性任务并返回 QFuture，可以直接交给 QFutureWatcher（核算、汇算、重算等）；
+//   - parallelFor 把一个任务内部的分块计算分给同一个线程池，总并发不会超过 scheduler_threads；
+//   - schedule 登记延时、周期（intervalMs）或 cron 式（"分 时 日 月 周"）任务，
+//     可以要求只在用户空闲时执行（超过 idle_after_seconds 秒没有键盘鼠标输入），用 cancel 取消；
+//   - 只有一个单次定时器，总是设在最早的到期时间上；没有待执行的任务时定时器停止，进程不会被唤醒。
+// 同一个周期任务不会重叠执行，下一次到期时间在本次执行结束后计算。
+// schedule、cancel 和 shutdown 只能在主线程中调用，run 可以在任意线程中调用。
+class JobScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 优先级，排队时高优先级的任务先执行
+    enum Priority
+    {
+        Low = 0,
+        Normal = 1,
+        High = 2
+    };
+
+    // 定时任务的设置
+    struct Job
+    {
+        QString name;                 // 名称，用于日志和指标
+        Priority priority = Normal;   // 优先级
+        qint64 delayMs = 0;           // 第一次执行前的延时（周期任务和一次性任务）
+        qint64 intervalMs = 0;        // 大于 0 时为周期任务
+        QString cron;                 // 非空时为 cron 式任务，忽略 delayMs 和 intervalMs
+        bool idle = false;            // 只在用户空闲时执行
+    };
+
+    // 传给任务的上下文，长时间运行的任务应定期检查是否已被取消
+    class Context
+    {
+    public:
+        explicit Context(std::shared_ptr<std::atomic<bool>> cancelled) : cancelled(cancelled) {}
+        bool isCancelled() const { return cancelled->load(); }
+
+    private:
+        std::shared_ptr<std::atomic<bool>> cancelled;
+    };
+
+    using Work = std::function<void(const Context&)>;
+
+    // 全局实例，第一次调用必须在主线程中，且 QCoreApplication 已经创建
+    static JobScheduler& instance();
+
+    // 设置工作线程数上限
+    void setMaxThreads(int count);
+
+    // schedule 函数登记定时任务，返回任务 ID；cron 表达式无效时返回 0
+    int schedule(const Job& job, Work work);
+
+    // cancel 函数取消定时任务：尚未执行的不再执行，正在执行的通过 Context::isCancelled 得知
+    void cancel(int id);
+
+    // run 函数立即提交一次性任务，返回其结果的 QFuture；任务总会执行完毕，调用方可以安全地等待。
+    // 任务抛出异常时记录日志并以默认构造的结果结束，QFutureWatcher::finished 照常发出
+    template <typename T>
+    QFuture<T> run(const QString& name, Priority priority, std::function<T()> work)
+    {
+        QFutureInterface<T> promise;
+        promise.reportStarted();
+        QFuture<T> future = promise.future();
+        submit(name, priority, [promise, work, name]() mutable {
+            T result = T();
+            try
+            {
+                result = work();
+            }
+            catch (const std::exception& e)
+            {
+                qWarning() << "Job" << name << "failed:" << e.what();
+            }
+            catch (...)
+            {
+                qWarning() << "Job" << name << "failed with an unknown exception";
+            }
+            promise.reportResult(result);
+            promise.reportFinished();
+        });
+        return future;
+    }
+
+    // parallelFor 函数在调度器的线程池中并行执行 body(0) ~ body(count - 1)，全部执行完毕后返回。
+    // 调用线程也领取下标执行，在任务内部调用时即使线程池已满也不会死锁；body 抛出的异常记录日志后忽略
+    void parallelFor(const QString& name, int count, const std::function<void(int)>& body);
+
+    // 用户是否处于空闲状态
+    bool isIdle() const;
+
+    // shutdown 函数取消全部定时任务并等待正在执行和排队的任务结束，程序退出前调用
+    void shutdown();
+
+    // 任务列表的文本，用于诊断窗口
+    QString toText() const;
+
+    // nextCronTime 函数计算 cron 表达式在 after 之后的下一次触发时间（精确到分钟），表达式无效或一年内不会触发时返回 false
+    // 支持 *、数字、a-b、a,b 和 */n 或 a-b/n，星期中 0 和 7 都表示星期日；日和星期都有限制时满足其一即可
+    static bool nextCronTime(const QString& cron, const QDateTime& after, QDateTime& next);
+
+signals:
+    // 定时任务执行完毕
+    void jobFinished(int id, const QString& name, qint64 elapsedMs);
+
+protected:
+    // 记录用户输入的时间
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
+private slots:
+    // 执行所有到期的定时任务，然后重新设置定时器
+    void dispatch();
+
+private:
+    // 一个定时任务
+    struct Entry
+    {
+        Job job;
+        Work work;
+        std::shared_ptr<std::atomic<bool>> cancelled;
+        qint64 dueAt = 0;         // 到期时间（单调时钟，毫秒）
+        bool running = false;     // 正在执行
+        int runs = 0;             // 已执行次数
+        qint64 lastElapsedMs = -1; // 上次耗时
+    };
+
+    JobScheduler();
+
+    // 把任务交给线程池，执行结束后在线程池线程中调用 done
+    void submit(const QString& name, Priority priority, std::function<void()> work, std::function<void(qint64)> done = nullptr);
+
+    // 定时任务执行结束（主线程）
+    void onFinished(int id, qint64 elapsedMs);
+
+    // 计算定时任务的下一次到期时间，返回 false 表示不再执行
+    bool computeDue(Entry& entry, bool first);
+
+    // 按最早的到期时间设置定时器，没有待执行的任务时停止定时器
+    void arm();
+
+    // 工作线程池
+    QThreadPool pool;
+
+    // 唯一的定时器
+    QTimer timer;
+
+    // 单调时钟
+    QElapsedTimer clock;
+
+    // 定时任务
+    QHash<int, Entry> entries;
+
+    // 下一个任务 ID
+    int nextId = 1;
+
+    // 最近一次用户输入的时间（单调时钟，毫秒）
+    std::atomic<qint64> lastActivityMs;
+
+    // 判定为空闲所需的无输入时长
+    qint64 idleAfterMs;
+};
+
+#endif // JOBSCHEDULER_H
@@ -1,5 +1,7 @@
 ﻿#include "logindialog.h"
 #include "ui_logindialog.h"
+#include "configstore.h"  // 登录账号与日志设置
+#include "jobscheduler.h"  // 后台验证
 #include <QMessageBox>
 #include <QDebug>
 #include <QFile>
@@ -22,6 +24,9 @@ LoginDialog::LoginDialog(QWidget* parent) :
         // 设置密码输入框为密码模式，输入内容将会被隐藏
         ui->passwordLineEdit->setEchoMode(QLineEdit::EchoMode::PasswordEchoOnEdit);
         qDebug() << "Password input set to echo mode.";
+
+        connect(&verifyWatcher, &QFutureWatcher<CredentialStore::Verification>::finished,
+            this, &LoginDialog::onVerificationFinished);
     }
     catch (const std::exception& e)
     {
@@ -37,6 +42,7 @@ LoginDialog::~LoginDialog()
     try
     {
         qDebug() << "Destroying LoginDialog...";
+        verifyWatcher.waitForFinished();
         delete ui;  // 删除UI对象
         qDebug() << "UI object deleted successfully.";
     }
@@ -65,56 +71,43 @@ void LoginDialog::on_cancel_clicked()
     }
 }
 
-// 登录按钮点击事件，进行用户名和密码验证
+// 登录按钮点击事件，在后台验证用户名和密码
 void LoginDialog::on_login_clicked()
 {
     try
     {
         qDebug() << "Login button clicked, starting login process.";
 
+        // 上一次验证尚未完成
+        if (verifyWatcher.isRunning())
+        {
+            return;
+        }
+
         // 获取用户输入的用户名和密码
         QString username = ui->usernameLineEdit->text();
         QString password = ui->passwordLineEdit->text();
 
-        // 打印调试信息
+        // 打印调试信息（不输出密码）
         qDebug() << "Username entered: " << username;
-        qDebug() << "Password entered: " << password;
-
-        // 假设从配置文件中读取到的正确用户名和密码
-        QString username_config = "admin";  // 配置文件中的用户名（示例）
-        QString password_config = "admin";  // 配置文件中的密码（示例）
-
-        qDebug() << "Configured username: " << username_config;
-        qDebug() << "Configured password: " << password_config;
-
-        // 比较用户输入的用户名和密码与配置文件中的信息
-        if (username == username_config && password == password_config)
-        {
-            qDebug() << "Login successful!";
-            hide();  // 隐藏登录窗口
-            succeed = true;
-
-            // 登录成功，关闭登录窗口并返回成功
-            accept();  // 调用QDialog的accept()函数，关闭对话框并返回成功标志
-        }
-        else
-        {
-            qDebug() << "Login failed, incorrect username or password.";
-            // 登录失败，弹出警告框提示用户
-            QMessageBox::warning(this,
-                QString::fromLocal8Bit("登录失败"),
-                QString::fromLocal8Bit("用户名或密码错误，请重新输入！"));
 
-            // 清空密码框和用户名框
-            ui->passwordLineEdit->clear();
-            ui->usernameLineEdit->clear();
-
-            // 将焦点重新设置到用户名框，方便用户重新输入
-            ui->usernameLineEdit->setFocus();
-
-            // 重新执行登录对话框，直到用户输入正确的用户名和密码
-            exec();
-        }
+        // 验证期间禁用登录按钮，对话框仍然可以移动和重绘
+        pendingUsername = username;
+        ui->login->setEnabled(false);
+        verifyWatcher.setFuture(JobScheduler::instance().run<CredentialStore::Verification>("login", JobScheduler::High, [username, password]() {
+            CredentialStore::Verification verification;
+            CredentialStore store("wagestax_login_worker");
+            if (!store.open())
+            {
+                verification.error = QString::fromLocal8Bit("无法打开数据库");
+            }
+            else
+            {
+                verification = store.verify(username, password);
+            }
+            store.close();
+            return verification;
+        }));
     }
     catch (const std::exception& e)
     {
@@ -128,44 +121,51 @@ void LoginDialog::on_login_clicked()
     }
 }
 
-// 模拟从文件中读取配置数据的函数
-QString LoginDialog::loadConfigData(const QString& key)
+// 后台验证完成
+void LoginDialog::onVerificationFinished()
 {
-    try
-    {
-        qDebug() << "Loading configuration data for key: " << key;
+    ui->login->setEnabled(true);
+    CredentialStore::Verification verification = verifyWatcher.result();
+    writeLoginLog(pendingUsername, verification.accepted);
+    qDebug() << "Credential verification took" << verification.elapsedMs << "ms" << (verification.cached ? "(cached)" : "");
 
-        QFile configFile("config.txt");  // 假设配置文件名为 config.txt
-        if (!configFile.open(QIODevice::ReadOnly | QIODevice::Text))
-        {
-            throw std::runtime_error("Failed to open config file.");
-        }
-
-        QTextStream in(&configFile);
-        QString value;
-        while (!in.atEnd())
-        {
-            QString line = in.readLine();
-            if (line.startsWith(key))
-            {
-                value = line.split("=").last().trimmed();
-                break;
-            }
-        }
-
-        configFile.close();
-        return value;
-    }
-    catch (const std::exception& e)
+    if (verification.accepted)
     {
-        qCritical() << "Error loading config data: " << e.what();
-        return QString();
+        qDebug() << "Login successful!";
+        hide();  // 隐藏登录窗口
+        succeed = true;
+        username = pendingUsername;
+        sessionToken = verification.token;
+
+        // 登录成功，关闭登录窗口并返回成功
+        accept();  // 调用QDialog的accept()函数，关闭对话框并返回成功标志
+        return;
     }
-    catch (...)
+
+    if (!verification.error.isEmpty())
     {
-        qCritical() << "Unknown error occurred while loading configuration data.";
-        return QString();
+        QMessageBox::critical(this, QString::fromLocal8Bit("登录失败"), verification.error);
+        return;
     }
+
+    qDebug() << "Login failed, incorrect username or password.";
+    // 登录失败，弹出警告框提示用户
+    QMessageBox::warning(this,
+        QString::fromLocal8Bit("登录失败"),
+        QString::fromLocal8Bit("用户名或密码错误，请重新输入！"));
+
+    // 清空密码框和用户名框
+    ui->passwordLineEdit->clear();
+    ui->usernameLineEdit->clear();
+
+    // 将焦点重新设置到用户名框，方便用户重新输入
+    ui->usernameLineEdit->setFocus();
+}
+
+// 读取配置数据：配置文件在启动时已由 ConfigStore 解析为哈希表，这里只是一次查找
+QString LoginDialog::loadConfigData(const QString& key)
+{
+    return ConfigStore::instance().value(key);
 }
 
 // 模拟将用户登录记录写入日志文件
@@ -174,7 +174,7 @@ void LoginDialog::writeLoginLog(const QString& username, bool success)
     try
     {
         qDebug() << "Writing login attempt to log file.";
-        QFile logFile("login_log.txt");
+        QFile logFile(ConfigStore::instance().value("login_log_file", "login_log.txt"));
         if (!logFile.open(QIODevice::Append | QIODevice::Text))
         {
             throw std::runtime_error("Failed to open log file for writing.");
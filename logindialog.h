@@ -3,6 +3,8 @@
 
 // 引入 Qt 的 QDialog 类, 用于构建登录对话框
 #include <QDialog>
+#include <QFutureWatcher>
+#include "credentialstore.h"
 
 // 预声明 Ui 命名空间下的 LoginDialog 类
 namespace Ui {
@@ -25,10 +27,14 @@ public:
     // 成功登录
     bool succeed = false;
 
+    // 登录成功的账号和会话令牌，主窗口修改密码时用令牌确认会话仍然有效，见 CredentialStore::validateToken
+    QString username;
+    QString sessionToken;
+
    
-    // 读取配置文件中的数据，返回指定键对应的值
+    // 读取配置文件中的数据，返回指定键对应的值（由 ConfigStore 提供，不再逐行扫描文件）
    // 参数: key - 配置项的键
-   // 返回值: 配置项对应的值（QString类型）
+   // 返回值: 配置项对应的值（QString类型），不存在时为空
     QString loadConfigData(const QString& key);
 
     // 将登录日志写入日志文件
@@ -57,7 +63,16 @@ private slots:
     // 点击登录按钮时的槽函数
     void on_login_clicked();
 
+    // 后台验证完成
+    void onVerificationFinished();
+
 private:
+    // 正在验证的用户名
+    QString pendingUsername;
+
+    // 后台验证任务：派生密码哈希有意放慢，在线程池中进行，对话框保持响应
+    QFutureWatcher<CredentialStore::Verification> verifyWatcher;
+
     // Ui 指针，用于管理和操作界面控件
     Ui::LoginDialog* ui;
 };
@@ -1,6 +1,35 @@
 ﻿#include "wagestax.h"
 // 引入登录对话框和数据库管理类
 #include "logindialog.h"
+// 税务计算服务（无界面模式）
+#include "taxserver.h"
+// 启动阶段计时
+#include "startupprofiler.h"
+// 登录期间预热数据库
+#include "databasepreloader.h"
+// 事件分发计时与指标导出
+#include "instrumentedapplication.h"
+#include "metricsregistry.h"
+// 时间线记录
+#include "tracerecorder.h"
+// 慢查询日志
+#include "slowquerylog.h"
+// 堆分配统计
+#include "allocationtracker.h"
+// 场景基准测试
+#include "scenariobenchmark.h"
+// 员工数据存储后端
+#include "employeestore.h"
+// 税率表热加载
+#include "taxschedule.h"
+// 配置
+#include "configstore.h"
+// 后台任务调度
+#include "jobscheduler.h"
+// 数据库维护
+#include "databasemaintenance.h"
+// 报表快照与热备份
+#include "databasesnapshot.h"
 #include <QApplication>
 #include <QMessageBox>
 #include <QFile>
@@ -9,13 +38,12 @@
 #include <exception>
 #include <stdexcept>
 #include <QDateTime>
-#include <QTimer>
 #include <QThread>
 
 // 日志记录函数
 void logError(const QString& errorMessage)
 {
-    QFile logFile("application_log.txt");  // 日志文件
+    QFile logFile(ConfigStore::instance().value("log_file", "application_log.txt"));  // 日志文件，可在配置中用 log_file 指定
     if (logFile.open(QIODevice::Append | QIODevice::Text))
     {
         QTextStream out(&logFile);
@@ -156,6 +184,7 @@ bool initializeApp()
 {
     try
     {
+        StartupPhase phase("printSystemInfo");
         printSystemInfo();
         return true;
     }
@@ -166,42 +195,162 @@ bool initializeApp()
     }
 }
 
-// 设置定时器任务模拟
-void setupTimers()
+// 创建后台任务调度器：线程数和空闲判定时长来自配置，没有登记任务时不设任何定时器
+void setupScheduler()
 {
-    QTimer* timer = new QTimer();
-    QObject::connect(timer, &QTimer::timeout, []() {
-        qDebug() << "定时任务已触发";
+    JobScheduler& scheduler = JobScheduler::instance();
+    QObject::connect(&scheduler, &JobScheduler::jobFinished, [](int id, const QString& name, qint64 elapsedMs) {
+        qDebug() << "Job" << id << name << "finished in" << elapsedMs << "ms";
         });
-    timer->start(5000);  // 每5秒触发一次
+
+    // 数据库维护：启动后空闲时检查一次，之后按改动行数登记
+    DatabaseMaintenance::install();
+
+    // 定时热备份
+    DatabaseSnapshot::install();
 }
 
 int main(int argc, char* argv[])
 {
-    QApplication a(argc, argv);
+    // 启动计时从进程入口开始
+    StartupProfiler::start();
+
+    // 服务模式和压测客户端不需要图形界面，在创建 QApplication 之前分流
+    if (TaxServer::isServiceInvocation(argc, argv))
+    {
+        QCoreApplication app(argc, argv);
+        return TaxServer::runFromCommandLine(app.arguments());
+    }
+
+    // 基准测试不需要真实的显示设备，使用 offscreen 平台渲染窗口
+    bool benchmark = ScenarioBenchmark::isRequested(argc, argv);
+    if (benchmark)
+    {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    int appPhase = StartupProfiler::begin("QApplication");
+    InstrumentedApplication a(argc, argv);
+    StartupProfiler::end(appPhase);
+    StartupProfiler::configure(a.arguments());
+
+    // 配置文件只在这里读取一次，之后的查找都在内存中的哈希表里进行
+    {
+        StartupPhase phase("ConfigStore");
+        ConfigStore::instance().load();
+    }
+
+    // 存储后端：config.txt 中的 storage_backend / storage_path，命令行 --storage / --storage-path 优先
+    EmployeeStore::loadConfiguration(a.arguments());
+
+    if (benchmark)
+    {
+        return ScenarioBenchmark::run(a.arguments());
+    }
+
+    // 税率表：读取 tax_schedule.json（不存在时使用内置税率表），文件变化后自动重新加载
+    TaxScheduleWatcher scheduleWatcher;
+    scheduleWatcher.start();
+
+    // --metrics-dump <文件>：退出时把指标写入文件（.json 为 JSON，否则为 Prometheus 文本）
+    int dumpIndex = a.arguments().indexOf("--metrics-dump");
+    if (dumpIndex >= 0 && dumpIndex + 1 < a.arguments().size())
+    {
+        QString dumpPath = a.arguments().at(dumpIndex + 1);
+        QObject::connect(&a, &QCoreApplication::aboutToQuit, [dumpPath]() {
+            if (!MetricsRegistry::instance().dumpToFile(dumpPath))
+            {
+                logError("无法写入指标文件：" + dumpPath);
+            }
+            });
+    }
+
+    // --slow-query-ms <毫秒>：慢查询阈值，超过阈值的语句连同执行计划写入 slow_query_log.txt
+    // 命令行未指定时使用配置中的 slow_query_ms，配置文件修改后随之更新
+    int slowIndex = a.arguments().indexOf("--slow-query-ms");
+    if (slowIndex >= 0 && slowIndex + 1 < a.arguments().size())
+    {
+        SlowQueryLog::instance().setThresholdMs(a.arguments().at(slowIndex + 1).toDouble());
+    }
+    else
+    {
+        auto applySlowQueryThreshold = []() {
+            const double thresholdMs = ConfigStore::instance().doubleValue("slow_query_ms", -1);
+            if (thresholdMs >= 0)
+            {
+                SlowQueryLog::instance().setThresholdMs(thresholdMs);
+            }
+        };
+        applySlowQueryThreshold();
+        QObject::connect(&ConfigStore::instance(), &ConfigStore::changed, [applySlowQueryThreshold](const QStringList& keys) {
+            if (keys.contains("slow_query_ms"))
+            {
+                applySlowQueryThreshold();
+            }
+            });
+    }
+
+    // 配置文件变化后自动重新读取
+    ConfigStore::instance().watch();
+
+    // --alloc-tracking：按操作范围统计堆分配，结果在诊断窗口中查看
+    AllocationTracker::setEnabled(a.arguments().contains("--alloc-tracking"));
+
+    // --trace <文件>：从启动开始记录时间线，退出时写出 trace-event JSON
+    int traceIndex = a.arguments().indexOf("--trace");
+    if (traceIndex >= 0 && traceIndex + 1 < a.arguments().size())
+    {
+        QString tracePath = a.arguments().at(traceIndex + 1);
+        TraceRecorder::start();
+        QObject::connect(&a, &QCoreApplication::aboutToQuit, [tracePath]() {
+            TraceRecorder::stop();
+            if (!TraceRecorder::saveToFile(tracePath))
+            {
+                logError("无法写入时间线文件：" + tracePath);
+            }
+            });
+    }
 
     try
     {
         // 模拟应用程序初始化
-        if (!initializeApp())
+        int initPhase = StartupProfiler::begin("initializeApp");
+        bool initialized = initializeApp();
+        StartupProfiler::end(initPhase);
+        if (!initialized)
         {
             return -1;  // 如果初始化失败，退出程序
         }
 
-        // 设置定时器
-        setupTimers();
+        // 后台任务调度器
+        int schedulerPhase = StartupProfiler::begin("setupScheduler");
+        setupScheduler();
+        StartupProfiler::end(schedulerPhase);
+
+        // 在用户输入登录信息的同时，后台打开数据库并读取员工列表
+        DatabasePreloader preloader;
+        preloader.start();
 
         // 登录对话框对象，用于管理登录界面的显示和交互
+        int loginPhase = StartupProfiler::begin("LoginDialog");
         LoginDialog login_dlg;
+        StartupProfiler::end(loginPhase);
 
-        // 弹出登录对话框，执行登录逻辑
+        // 弹出登录对话框，执行登录逻辑（等待用户输入，不计入冷启动时间）
+        int execPhase = StartupProfiler::begin("LoginDialog::exec", true);
         login_dlg.exec();
+        StartupProfiler::end(execPhase);
 
         if (login_dlg.succeed)
         {
             try
             {
-                WagesTax w;
+                int windowPhase = StartupProfiler::begin("WagesTax");
+                WagesTax w(nullptr, &preloader);
+                w.setSession(login_dlg.username, login_dlg.sessionToken);
+                StartupProfiler::end(windowPhase);
+
+                StartupProfiler::watchFirstPaint(&w);
                 w.show();
 
                 // 模拟更多业务逻辑
@@ -228,6 +377,9 @@ int main(int argc, char* argv[])
         }
         else
         {
+            // 登录失败时不再需要预热结果，中止并释放
+            preloader.cancel();
+
             // 如果登录失败，输出失败信息并记录日志
             QString loginFailMsg = "用户登录失败：用户名或密码错误";
             logError(loginFailMsg);
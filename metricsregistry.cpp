@@ -0,0 +1,321 @@
+﻿#include "metricsregistry.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QtAlgorithms>
+
+// MetricsCounter 构造函数，清零所有分片
+MetricsCounter::MetricsCounter()
+{
+    for (Stripe& stripe : stripes)
+    {
+        stripe.value.store(0, std::memory_order_relaxed);
+    }
+}
+
+// 各分片之和
+quint64 MetricsCounter::value() const
+{
+    quint64 result = 0;
+    for (const Stripe& stripe : stripes)
+    {
+        result += stripe.value.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+// 每个线程第一次使用时轮流分配一个分片
+int MetricsCounter::stripeIndex()
+{
+    static std::atomic<int> nextStripe(0);
+    thread_local int index = nextStripe.fetch_add(1, std::memory_order_relaxed) % StripeCount;
+    return index;
+}
+
+// MetricsHistogram 构造函数，清零所有桶
+MetricsHistogram::MetricsHistogram()
+    : total(0)
+    , sum(0)
+    , maximum(0)
+{
+    for (std::atomic<quint64>& bucket : buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+// 计算值所在的桶：小于 16 的值各占一个桶，之后每个 2 的幂区间分为 8 个子桶
+int MetricsHistogram::bucketIndex(quint64 value)
+{
+    const quint64 linearLimit = quint64(1) << (SubBucketBits + 1);
+    if (value < linearLimit)
+    {
+        return int(value);
+    }
+
+    int exponent = 63 - int(qCountLeadingZeroBits(value));
+    int subBucket = int((value >> (exponent - SubBucketBits)) & ((1 << SubBucketBits) - 1));
+    return int(linearLimit) + (exponent - SubBucketBits - 1) * (1 << SubBucketBits) + subBucket;
+}
+
+// 桶的上界
+quint64 MetricsHistogram::bucketUpperBound(int index)
+{
+    const int linearLimit = 1 << (SubBucketBits + 1);
+    if (index < linearLimit)
+    {
+        return quint64(index);
+    }
+
+    int exponent = (index - linearLimit) / (1 << SubBucketBits) + SubBucketBits + 1;
+    int subBucket = (index - linearLimit) % (1 << SubBucketBits);
+    int shift = exponent - SubBucketBits;
+    quint64 lower = quint64((1 << SubBucketBits) + subBucket) << shift;
+    return lower + ((quint64(1) << shift) - 1);
+}
+
+// 估算分位数
+quint64 MetricsHistogram::percentile(double quantile) const
+{
+    quint64 totalCount = count();
+    if (totalCount == 0)
+    {
+        return 0;
+    }
+
+    quint64 target = quint64(quantile * double(totalCount));
+    if (target >= totalCount)
+    {
+        target = totalCount - 1;
+    }
+
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount; ++i)
+    {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen > target)
+        {
+            // 上界不超过实际记录到的最大值
+            return qMin(bucketUpperBound(i), maxValue());
+        }
+    }
+    return maxValue();
+}
+
+// 全局实例
+MetricsRegistry& MetricsRegistry::instance()
+{
+    static MetricsRegistry registry;
+    return registry;
+}
+
+// 取得或创建条目
+MetricsRegistry::Entry& MetricsRegistry::entry(const QString& name, const QString& labels, const QString& help)
+{
+    QString key = labels.isEmpty() ? name : name + "{" + labels + "}";
+    Entry& item = entries[key];
+    if (item.name.isEmpty())
+    {
+        item.name = name;
+        item.labels = labels;
+    }
+    if (item.help.isEmpty())
+    {
+        item.help = help;
+    }
+    return item;
+}
+
+// 获取计数器
+MetricsCounter& MetricsRegistry::counter(const QString& name, const QString& labels, const QString& help)
+{
+    QMutexLocker locker(&mutex);
+    Entry& item = entry(name, labels, help);
+    if (!item.counter)
+    {
+        item.counter.reset(new MetricsCounter());
+    }
+    return *item.counter;
+}
+
+// 获取瞬时值
+MetricsGauge& MetricsRegistry::gauge(const QString& name, const QString& labels, const QString& help)
+{
+    QMutexLocker locker(&mutex);
+    Entry& item = entry(name, labels, help);
+    if (!item.gauge)
+    {
+        item.gauge.reset(new MetricsGauge());
+    }
+    return *item.gauge;
+}
+
+// 获取直方图
+MetricsHistogram& MetricsRegistry::histogram(const QString& name, const QString& labels, const QString& help)
+{
+    QMutexLocker locker(&mutex);
+    Entry& item = entry(name, labels, help);
+    if (!item.histogram)
+    {
+        item.histogram.reset(new MetricsHistogram());
+    }
+    return *item.histogram;
+}
+
+// 导出为 JSON
+QByteArray MetricsRegistry::toJson() const
+{
+    QMutexLocker locker(&mutex);
+    QJsonArray metrics;
+    for (const auto& pair : entries)
+    {
+        const Entry& item = pair.second;
+        QJsonObject object;
+        object["name"] = item.name;
+        object["labels"] = item.labels;
+
+        if (item.counter)
+        {
+            object["type"] = "counter";
+            object["value"] = double(item.counter->value());
+        }
+        else if (item.gauge)
+        {
+            object["type"] = "gauge";
+            object["value"] = double(item.gauge->value());
+        }
+        else if (item.histogram)
+        {
+            object["type"] = "histogram";
+            object["count"] = double(item.histogram->count());
+            object["sum"] = double(item.histogram->sumValue());
+            object["max"] = double(item.histogram->maxValue());
+            object["p50"] = double(item.histogram->percentile(0.50));
+            object["p90"] = double(item.histogram->percentile(0.90));
+            object["p99"] = double(item.histogram->percentile(0.99));
+            object["p999"] = double(item.histogram->percentile(0.999));
+        }
+        metrics.append(object);
+    }
+
+    QJsonObject root;
+    root["metrics"] = metrics;
+    return QJsonDocument(root).toJson();
+}
+
+// 导出为 Prometheus 文本格式
+QByteArray MetricsRegistry::toPrometheus() const
+{
+    QMutexLocker locker(&mutex);
+    QString text;
+    QTextStream out(&text);
+
+    // 为带标签的样本拼接标签
+    auto series = [](const QString& name, const QString& labels, const QString& extra) {
+        QStringList parts;
+        if (!labels.isEmpty())
+        {
+            parts << labels;
+        }
+        if (!extra.isEmpty())
+        {
+            parts << extra;
+        }
+        return parts.isEmpty() ? name : name + "{" + parts.join(",") + "}";
+    };
+
+    QString lastName;
+    for (const auto& pair : entries)
+    {
+        const Entry& item = pair.second;
+
+        // 同名指标只输出一次 HELP/TYPE
+        if (item.name != lastName)
+        {
+            lastName = item.name;
+            if (!item.help.isEmpty())
+            {
+                out << "# HELP " << item.name << " " << item.help << "\n";
+            }
+            out << "# TYPE " << item.name << " "
+                << (item.counter ? "counter" : item.gauge ? "gauge" : "summary") << "\n";
+        }
+
+        if (item.counter)
+        {
+            out << series(item.name, item.labels, QString()) << " " << item.counter->value() << "\n";
+        }
+        else if (item.gauge)
+        {
+            out << series(item.name, item.labels, QString()) << " " << item.gauge->value() << "\n";
+        }
+        else if (item.histogram)
+        {
+            const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+            for (double quantile : quantiles)
+            {
+                out << series(item.name, item.labels, QString("quantile=\"%1\"").arg(quantile))
+                    << " " << item.histogram->percentile(quantile) << "\n";
+            }
+            out << series(item.name + "_sum", item.labels, QString()) << " " << item.histogram->sumValue() << "\n";
+            out << series(item.name + "_count", item.labels, QString()) << " " << item.histogram->count() << "\n";
+        }
+    }
+
+    out.flush();
+    return text.toUtf8();
+}
+
+// 导出为表格文本
+QString MetricsRegistry::toText() const
+{
+    QMutexLocker locker(&mutex);
+    QString text;
+    QTextStream out(&text);
+
+    for (const auto& pair : entries)
+    {
+        const Entry& item = pair.second;
+        QString title = item.labels.isEmpty() ? item.name : item.name + " {" + item.labels + "}";
+
+        if (item.counter)
+        {
+            out << title << "\n    " << item.counter->value() << "\n";
+        }
+        else if (item.gauge)
+        {
+            out << title << "\n    " << item.gauge->value() << "\n";
+        }
+        else if (item.histogram)
+        {
+            const MetricsHistogram& histogram = *item.histogram;
+            quint64 count = histogram.count();
+            out << title << "\n    "
+                << QString("count %1  mean %2  p50 %3  p90 %4  p99 %5  max %6")
+                .arg(count)
+                .arg(count ? double(histogram.sumValue()) / count : 0.0, 0, 'f', 0)
+                .arg(histogram.percentile(0.50))
+                .arg(histogram.percentile(0.90))
+                .arg(histogram.percentile(0.99))
+                .arg(histogram.maxValue())
+                << "\n";
+        }
+    }
+
+    out.flush();
+    return text;
+}
+
+// 写入文件
+bool MetricsRegistry::dumpToFile(const QString& path) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        return false;
+    }
+    file.write(path.endsWith(".json", Qt::CaseInsensitive) ? toJson() : toPrometheus());
+    return true;
+}
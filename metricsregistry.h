@@ -0,0 +1,190 @@
+﻿#ifndef METRICSREGISTRY_H
+#define METRICSREGISTRY_H
+
+#include <QMutex>
+#include <QString>
+#include <QElapsedTimer>
+#include <atomic>
+#include <map>
+#include <memory>
+
+// MetricsCounter 类是只增不减的计数器
+// 计数分散在多条缓存行上，不同线程各自累加，读取时再求和，避免多线程争用同一条缓存行
+class MetricsCounter
+{
+public:
+    MetricsCounter();
+
+    // 累加（默认加 1）
+    void add(quint64 delta = 1)
+    {
+        stripes[stripeIndex()].value.fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    // 当前计数
+    quint64 value() const;
+
+    // 分片数量
+    static const int StripeCount = 8;
+
+    // 当前线程使用的分片序号
+    static int stripeIndex();
+
+private:
+    // 独占一条缓存行的计数分片
+    struct alignas(64) Stripe
+    {
+        std::atomic<quint64> value;
+    };
+    Stripe stripes[StripeCount];
+};
+
+// MetricsGauge 类是可以任意设置的瞬时值，例如当前列表行数
+class MetricsGauge
+{
+public:
+    MetricsGauge() : current(0) {}
+
+    void set(qint64 value) { current.store(value, std::memory_order_relaxed); }
+    void add(qint64 delta) { current.fetch_add(delta, std::memory_order_relaxed); }
+    qint64 value() const { return current.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<qint64> current;
+};
+
+// MetricsHistogram 类是 HDR 风格的对数-线性直方图
+// 每个 2 的幂区间再细分为 8 个子桶，相对误差不超过 12.5%，记录只是一次数组下标计算加一次原子加法
+// 用于记录纳秒级耗时，也可以记录批量大小、行数等非负整数
+class MetricsHistogram
+{
+public:
+    MetricsHistogram();
+
+    // 记录一个值
+    void record(quint64 value)
+    {
+        buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(value, std::memory_order_relaxed);
+
+        quint64 previous = maximum.load(std::memory_order_relaxed);
+        while (value > previous && !maximum.compare_exchange_weak(previous, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    // 记录次数
+    quint64 count() const { return total.load(std::memory_order_relaxed); }
+
+    // 所有记录值之和
+    quint64 sumValue() const { return sum.load(std::memory_order_relaxed); }
+
+    // 最大记录值
+    quint64 maxValue() const { return maximum.load(std::memory_order_relaxed); }
+
+    // 估算分位数（quantile 取 0~1），返回所在桶的上界
+    quint64 percentile(double quantile) const;
+
+    // 子桶位数：每个 2 的幂区间分为 2^SubBucketBits 个子桶
+    static const int SubBucketBits = 3;
+
+    // 桶数量：覆盖 0 ~ 2^63
+    static const int BucketCount = (1 << (SubBucketBits + 1)) + (64 - SubBucketBits - 1) * (1 << SubBucketBits);
+
+    // 计算值所在的桶
+    static int bucketIndex(quint64 value);
+
+    // 桶的上界（包含）
+    static quint64 bucketUpperBound(int index);
+
+private:
+    std::atomic<quint64> buckets[BucketCount];
+    std::atomic<quint64> total;
+    std::atomic<quint64> sum;
+    std::atomic<quint64> maximum;
+};
+
+// MetricsRegistry 类按名称管理全部指标，并负责导出
+// 指标按“名称 + 标签”区分，例如 名称 wagestax_sql_statement_ns，标签 statement="insert"
+// 查找指标需要加锁，调用处应当用函数内静态引用缓存结果，热路径上只剩原子操作
+class MetricsRegistry
+{
+public:
+    // 全局实例
+    static MetricsRegistry& instance();
+
+    // 获取（不存在时创建）指标，返回的引用在程序运行期间一直有效
+    MetricsCounter& counter(const QString& name, const QString& labels = QString(), const QString& help = QString());
+    MetricsGauge& gauge(const QString& name, const QString& labels = QString(), const QString& help = QString());
+    MetricsHistogram& histogram(const QString& name, const QString& labels = QString(), const QString& help = QString());
+
+    // 导出为 JSON 文本
+    QByteArray toJson() const;
+
+    // 导出为 Prometheus 文本格式（直方图以 summary 形式给出分位数）
+    QByteArray toPrometheus() const;
+
+    // 导出为便于阅读的表格文本，用于诊断窗口
+    QString toText() const;
+
+    // 写入文件，扩展名为 .json 时使用 JSON，否则使用 Prometheus 文本格式
+    bool dumpToFile(const QString& path) const;
+
+private:
+    MetricsRegistry() = default;
+
+    // 指标的描述信息
+    struct Entry
+    {
+        QString name;
+        QString labels;
+        QString help;
+        std::unique_ptr<MetricsCounter> counter;
+        std::unique_ptr<MetricsGauge> gauge;
+        std::unique_ptr<MetricsHistogram> histogram;
+    };
+
+    // 取得或创建条目
+    Entry& entry(const QString& name, const QString& labels, const QString& help);
+
+    mutable QMutex mutex;
+
+    // 按“名称{标签}”排序保存，导出时同名指标相邻
+    std::map<QString, Entry> entries;
+};
+
+// ScopedLatency 类以 RAII 方式把作用域耗时（纳秒）记录到直方图
+class ScopedLatency
+{
+public:
+    explicit ScopedLatency(MetricsHistogram& histogram)
+        : histogram(histogram)
+    {
+        timer.start();
+    }
+
+    ~ScopedLatency()
+    {
+        finish();
+    }
+
+    // 提前结束计时（之后的代码不计入，析构时不再重复记录）
+    void finish()
+    {
+        if (timer.isValid())
+        {
+            histogram.record(quint64(timer.nsecsElapsed()));
+            timer.invalidate();
+        }
+    }
+
+    // 已经过的纳秒数
+    qint64 elapsedNs() const { return timer.nsecsElapsed(); }
+
+private:
+    MetricsHistogram& histogram;
+    QElapsedTimer timer;
+};
+
+#endif // METRICSREGISTRY_H
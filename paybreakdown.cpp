@@ -0,0 +1,255 @@
+﻿#include "paybreakdown.h"
+#include "taxcalccenter.h"     // 税率表
+#include "metricsregistry.h"   // 计算耗时统计
+#include "tracerecorder.h"     // 时间线区间
+#include "slowquerylog.h"      // 慢查询日志与执行计划
+#include "databasemaintenance.h" // 改动行数统计
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+
+namespace
+{
+    // 每页读取的员工数，也是每次融合计算的长度
+    const int PageSize = 4096;
+}
+
+// 调整所有列的长度
+void PayBreakdown::Columns::resize(size_t count)
+{
+    for (std::vector<double>* column : { &pension, &medical, &unemployment, &housingFund,
+        &employeeContribution, &employerContribution, &tax, &net })
+    {
+        column->resize(count);
+    }
+}
+
+// PayBreakdown 构造函数
+PayBreakdown::PayBreakdown(const QString& connectionName)
+    : connection(connectionName)
+{
+
+}
+
+// 打开数据库，employee_pay_breakdown 表由 SqlManager 与 employees 一起创建
+bool PayBreakdown::open()
+{
+    return connection.open();
+}
+
+// 关闭数据库
+void PayBreakdown::close()
+{
+    connection.close();
+}
+
+// 缴费和计税的融合计算
+// 基数的上下限用条件表达式求 min/max，税额与 calculateTaxBatch 一样取各档“所得额 × 税率 - 速算扣除数”的最大值，
+// 循环体内没有分支，编译器可以对整个循环自动向量化
+void PayBreakdown::computeBatch(const CityContribution& city, const double* salaries, const double* deductions, int count, Columns& out)
+{
+    static MetricsCounter& calls = MetricsRegistry::instance().counter(
+        "wagestax_tax_calculations_total", "mode=\"gross_to_net\"");
+    calls.add(quint64(count));
+
+    // 当前税率表，整批使用同一份
+    const TaxSchedule& table = TaxCalcCenter::schedule();
+
+    const double socialEmployeeRate = city.pensionEmployee + city.medicalEmployee + city.unemploymentEmployee;
+    const double socialEmployerRate = city.pensionEmployer + city.medicalEmployer + city.unemploymentEmployer;
+
+    double* pension = out.pension.data();
+    double* medical = out.medical.data();
+    double* unemployment = out.unemployment.data();
+    double* housingFund = out.housingFund.data();
+    double* employeeContribution = out.employeeContribution.data();
+    double* employerContribution = out.employerContribution.data();
+    double* taxes = out.tax.data();
+    double* net = out.net.data();
+
+    for (int i = 0; i < count; ++i)
+    {
+        const double salary = salaries[i];
+
+        // 缴费基数
+        double socialBase = salary < city.socialBaseFloor ? city.socialBaseFloor : salary;
+        socialBase = socialBase > city.socialBaseCeiling ? city.socialBaseCeiling : socialBase;
+        double housingBase = salary < city.housingBaseFloor ? city.housingBaseFloor : salary;
+        housingBase = housingBase > city.housingBaseCeiling ? city.housingBaseCeiling : housingBase;
+
+        // 个人和单位缴费
+        pension[i] = socialBase * city.pensionEmployee;
+        medical[i] = socialBase * city.medicalEmployee;
+        unemployment[i] = socialBase * city.unemploymentEmployee;
+        housingFund[i] = housingBase * city.housingEmployee;
+        const double contribution = socialBase * socialEmployeeRate + housingFund[i];
+        employeeContribution[i] = contribution;
+        employerContribution[i] = socialBase * socialEmployerRate + housingBase * city.housingEmployer;
+
+        // 扣除个人缴费、专项扣除和起征点后计税
+        const double taxableIncome = salary - contribution - deductions[i] - table.threshold;
+        double tax = 0;
+        for (int k = 0; k < TaxCalcCenter::BracketCount; ++k)
+        {
+            double candidate = taxableIncome * table.rate[k] - table.quickDeduction[k];
+            tax = candidate > tax ? candidate : tax;
+        }
+        taxes[i] = tax;
+        net[i] = salary - contribution - tax;
+    }
+}
+
+// 重新计算全部员工的明细
+PayBreakdown::Summary PayBreakdown::recompute(EmployeeStore& source, const CityContribution& city, QString* error)
+{
+    static MetricsHistogram& latency = MetricsRegistry::instance().histogram("wagestax_breakdown_ns",
+        QString(), "PayBreakdown::recompute latency in nanoseconds");
+    ScopedLatency timer(latency);
+    TraceSpan span("PayBreakdown::recompute", "sql");
+
+    Summary summary;
+    summary.headcount = -1;
+
+    // 读取：与工资核算相同，不持有写锁；来源是 SQLite 连接时在一个读事务中分页读取，各页来自同一时刻的数据
+    std::vector<int> ids;
+    std::vector<double> salaries;
+    std::vector<double> deductions;
+    {
+        TraceSpan readSpan("PayBreakdown::read", "sql");
+        SqlManager* sqlSource = dynamic_cast<SqlManager*>(&source);
+        const bool reading = sqlSource && sqlSource->database().transaction();
+        int lastId = 0;
+        for (;;)
+        {
+            std::vector<EmployeeRecord> page = source.queryRecordsAfter(lastId, PageSize);
+            if (page.empty())
+            {
+                break;
+            }
+            lastId = page.back().id;
+
+            // 个人社保由城市规则算出，专项扣除中手工填写的社会保险不再重复扣除
+            for (const EmployeeRecord& record : page)
+            {
+                ids.push_back(record.id);
+                salaries.push_back(record.salary);
+                deductions.push_back(record.deduction - record.socialInsurance);
+            }
+
+            if (int(page.size()) < PageSize)
+            {
+                break;
+            }
+        }
+        if (reading)
+        {
+            sqlSource->database().commit();
+        }
+    }
+
+    // 计算：一次融合计算全部员工
+    const int count = int(ids.size());
+    Columns columns;
+    columns.resize(ids.size());
+    {
+        TraceSpan computeSpan("PayBreakdown::compute", "worker");
+        computeBatch(city, salaries.data(), deductions.data(), count, columns);
+    }
+
+    // 写入：写锁只在替换 employee_pay_breakdown 的内容期间持有
+    TraceSpan writeSpan("PayBreakdown::write", "sql");
+    QSqlDatabase db = connection.database();
+    QSqlQuery query(db);
+    if (!query.exec("BEGIN IMMEDIATE"))
+    {
+        SqlManager::reportError(error, "Pay breakdown", query.lastError().text());
+        return summary;
+    }
+    if (!query.exec("DELETE FROM employee_pay_breakdown"))
+    {
+        SqlManager::reportError(error, "Pay breakdown", query.lastError().text());
+        query.exec("ROLLBACK");
+        return summary;
+    }
+    DatabaseMaintenance::recordChurn(query.numRowsAffected());
+
+    const QString now = QDateTime::currentDateTime().toString(Qt::ISODate);
+    QSqlQuery insert(db);
+    insert.prepare("INSERT INTO employee_pay_breakdown (employee_id, city, gross, pension, medical, unemployment, "
+        "housing_fund, employee_contribution, employer_contribution, deduction, tax, net, computed_at) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+
+    Summary totals;
+    for (int i = 0; i < count; ++i)
+    {
+        insert.bindValue(0, ids[i]);
+        insert.bindValue(1, city.city);
+        insert.bindValue(2, salaries[i]);
+        insert.bindValue(3, columns.pension[i]);
+        insert.bindValue(4, columns.medical[i]);
+        insert.bindValue(5, columns.unemployment[i]);
+        insert.bindValue(6, columns.housingFund[i]);
+        insert.bindValue(7, columns.employeeContribution[i]);
+        insert.bindValue(8, columns.employerContribution[i]);
+        insert.bindValue(9, deductions[i]);
+        insert.bindValue(10, columns.tax[i]);
+        insert.bindValue(11, columns.net[i]);
+        insert.bindValue(12, now);
+        if (!insert.exec())
+        {
+            SqlManager::reportError(error, "Pay breakdown", insert.lastError().text());
+            insert.finish();
+            query.exec("ROLLBACK");
+            return summary;
+        }
+
+        ++totals.headcount;
+        totals.totalGross += salaries[i];
+        totals.totalEmployeeContribution += columns.employeeContribution[i];
+        totals.totalEmployerContribution += columns.employerContribution[i];
+        totals.totalTax += columns.tax[i];
+        totals.totalNet += columns.net[i];
+    }
+    insert.finish();
+
+    if (!query.exec("COMMIT"))
+    {
+        SqlManager::reportError(error, "Pay breakdown", query.lastError().text());
+        query.exec("ROLLBACK");
+        return summary;
+    }
+
+    totals.elapsedMs = timer.elapsedNs() / 1000000;
+    qDebug() << "Pay breakdown for" << city.city << "finished:" << totals.headcount << "employees in" << totals.elapsedMs << "ms";
+    return totals;
+}
+
+// 读取一名员工的明细
+bool PayBreakdown::breakdown(int employeeId, Entry& entry)
+{
+    QSqlQuery query(connection.database());
+    QueryProbe probe(query, connection.database());
+    query.prepare("SELECT city, gross, pension, medical, unemployment, housing_fund, employee_contribution, "
+        "employer_contribution, deduction, tax, net, computed_at FROM employee_pay_breakdown WHERE employee_id = ?");
+    query.addBindValue(employeeId);
+    if (!query.exec() || !query.next())
+    {
+        return false;
+    }
+
+    entry.employeeId = employeeId;
+    entry.city = query.value(0).toString();
+    entry.gross = query.value(1).toDouble();
+    entry.pension = query.value(2).toDouble();
+    entry.medical = query.value(3).toDouble();
+    entry.unemployment = query.value(4).toDouble();
+    entry.housingFund = query.value(5).toDouble();
+    entry.employeeContribution = query.value(6).toDouble();
+    entry.employerContribution = query.value(7).toDouble();
+    entry.deduction = query.value(8).toDouble();
+    entry.tax = query.value(9).toDouble();
+    entry.net = query.value(10).toDouble();
+    entry.computedAt = QDateTime::fromString(query.value(11).toString(), Qt::ISODate);
+    return true;
+}
@@ -0,0 +1,102 @@
+﻿#ifndef PAYBREAKDOWN_H
+#define PAYBREAKDOWN_H
+
+#include <QDateTime>
+#include <QString>
+#include <vector>
+#include "contributiontable.h"
+#include "sqlmanager.h"
+
+// PayBreakdown 类计算并保存每名员工从应发工资到实发工资的明细：
+// 个人缴纳的养老、医疗、失业保险和住房公积金，单位缴费，个人所得税，实发工资。
+// 计算由 computeBatch 在一次循环中完成：每个工资只读取一次，先按城市规则求缴费基数和各项缴费，
+// 紧接着在同一次迭代里扣除个人缴费和专项扣除后按税率表计税，输出按列（每项一个数组）写出。
+// 结果保存在与 employees 同库的 employee_pay_breakdown 表中，每名员工一行，删除员工时由触发器一并删除。
+// 个人社保按城市规则计算，员工专项扣除中手工填写的“社会保险”一项在这里不参与扣除，避免重复扣除。
+class PayBreakdown
+{
+public:
+    // computeBatch 的输出，每项一个与输入工资对齐的数组
+    struct Columns
+    {
+        std::vector<double> pension;               // 个人养老保险
+        std::vector<double> medical;               // 个人医疗保险
+        std::vector<double> unemployment;          // 个人失业保险
+        std::vector<double> housingFund;           // 个人住房公积金
+        std::vector<double> employeeContribution;  // 个人缴费合计
+        std::vector<double> employerContribution;  // 单位缴费合计
+        std::vector<double> tax;                   // 个人所得税
+        std::vector<double> net;                   // 实发工资
+
+        // 调整所有列的长度
+        void resize(size_t count);
+    };
+
+    // 一名员工的明细
+    struct Entry
+    {
+        int employeeId = 0;
+        QString city;
+        double gross = 0;
+        double pension = 0;
+        double medical = 0;
+        double unemployment = 0;
+        double housingFund = 0;
+        double employeeContribution = 0;
+        double employerContribution = 0;
+        double deduction = 0;
+        double tax = 0;
+        double net = 0;
+        QDateTime computedAt;
+    };
+
+    // 一次计算的合计
+    struct Summary
+    {
+        int headcount = 0;
+        double totalGross = 0;
+        double totalEmployeeContribution = 0;
+        double totalEmployerContribution = 0;
+        double totalTax = 0;
+        double totalNet = 0;
+        qint64 elapsedMs = 0;
+    };
+
+    // 构造函数
+    // 参数:
+    //   - connectionName: 使用的数据库连接名（线程规则见 SqlManager 构造函数）
+    explicit PayBreakdown(const QString& connectionName = "wagestax_breakdown");
+
+    // 打开数据库，返回是否成功
+    bool open();
+
+    // 关闭并移除数据库连接
+    void close();
+
+    // recompute 函数按城市规则重新计算全部员工的明细：不加写锁读取员工并计算，
+    // 只在最后一个较短的写事务中替换 employee_pay_breakdown 的内容
+    // 参数:
+    //   - source: 员工数据来源
+    //   - city: 缴费规则
+    //   - error: 失败时写入原因（可以为空）
+    // 返回值：合计，失败时 headcount 为 -1
+    Summary recompute(EmployeeStore& source, const CityContribution& city, QString* error = nullptr);
+
+    // breakdown 函数读取一名员工已保存的明细，不存在时返回 false
+    bool breakdown(int employeeId, Entry& entry);
+
+    // computeBatch 函数对 count 个工资执行缴费和计税的融合计算，结果写入 out 的前 count 个元素
+    // 参数:
+    //   - city: 缴费规则
+    //   - salaries: 应发工资数组
+    //   - deductions: 专项扣除合计数组（不含社会保险，个人缴费由城市规则算出）
+    //   - count: 数组元素个数
+    //   - out: 输出列，长度不小于 count
+    static void computeBatch(const CityContribution& city, const double* salaries, const double* deductions, int count, Columns& out);
+
+private:
+    // 数据库连接，路径和内存数据库的选择与员工数据一致
+    SqlManager connection;
+};
+
+#endif // PAYBREAKDOWN_H
@@ -0,0 +1,187 @@
+﻿#include "paybreakdowndialog.h"
+#include "employeestore.h"  // 员工数据来源
+#include "jobscheduler.h"   // 后台任务
+#include "sqlmanager.h"     // 在快照上读取
+#include "databasesnapshot.h" // 报表快照
+#include <QComboBox>
+#include <QFontDatabase>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMessageBox>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <memory>
+
+namespace
+{
+    // 后台重算使用的连接名，与界面线程的连接互不干扰
+    const char* WorkerBreakdownConnection = "wagestax_breakdown_worker";
+    const char* WorkerSourceConnection = "wagestax_breakdown_source";
+}
+
+// PayBreakdownDialog 构造函数，创建界面并加载城市规则
+PayBreakdownDialog::PayBreakdownDialog(QWidget* parent)
+    : QDialog(parent)
+    , cityBox(new QComboBox(this))
+    , recomputeButton(new QPushButton(QString::fromLocal8Bit("重新计算"), this))
+    , employeeInput(new QLineEdit(this))
+    , text(new QPlainTextEdit(this))
+{
+    setWindowTitle(QString::fromLocal8Bit("工资明细（社保、公积金、个税）"));
+    resize(640, 420);
+
+    // 规则文件不存在或格式错误时使用内置规则
+    QString error;
+    if (!table.load(ContributionTable::defaultPath(), &error))
+    {
+        text->setPlainText(QString::fromLocal8Bit("未能加载 %1（%2），使用内置规则。")
+            .arg(ContributionTable::defaultPath(), error));
+    }
+    for (const CityContribution& city : table.cities())
+    {
+        cityBox->addItem(city.city);
+    }
+
+    employeeInput->setPlaceholderText(QString::fromLocal8Bit("员工ID"));
+    employeeInput->setMaximumWidth(100);
+    text->setReadOnly(true);
+    text->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+
+    QPushButton* showButton = new QPushButton(QString::fromLocal8Bit("查看"), this);
+    QPushButton* closeButton = new QPushButton(QString::fromLocal8Bit("关闭"), this);
+
+    QHBoxLayout* row = new QHBoxLayout();
+    row->addWidget(new QLabel(QString::fromLocal8Bit("城市"), this));
+    row->addWidget(cityBox);
+    row->addWidget(recomputeButton);
+    row->addStretch();
+    row->addWidget(new QLabel(QString::fromLocal8Bit("员工"), this));
+    row->addWidget(employeeInput);
+    row->addWidget(showButton);
+    row->addWidget(closeButton);
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->addLayout(row);
+    layout->addWidget(text);
+
+    connect(recomputeButton, &QPushButton::clicked, this, &PayBreakdownDialog::recompute);
+    connect(showButton, &QPushButton::clicked, this, &PayBreakdownDialog::showEmployee);
+    connect(employeeInput, &QLineEdit::returnPressed, this, &PayBreakdownDialog::showEmployee);
+    connect(closeButton, &QPushButton::clicked, this, &QDialog::close);
+    connect(&watcher, &QFutureWatcher<Outcome>::finished, this, &PayBreakdownDialog::onRecomputeFinished);
+
+    breakdown.open();
+}
+
+// PayBreakdownDialog 析构函数
+PayBreakdownDialog::~PayBreakdownDialog()
+{
+    watcher.waitForFinished();
+    breakdown.close();
+}
+
+// 槽函数：在后台重算
+void PayBreakdownDialog::recompute()
+{
+    const CityContribution* city = table.find(cityBox->currentText());
+    if (!city)
+    {
+        return;
+    }
+
+    recomputeButton->setEnabled(false);
+    text->setPlainText(QString::fromLocal8Bit("正在按 %1 的规则计算 ...").arg(city->city));
+
+    // 规则按值捕获，后台计算期间重新加载规则不影响本次计算
+    CityContribution rules = *city;
+    watcher.setFuture(JobScheduler::instance().run<Outcome>("pay_breakdown", JobScheduler::Normal, [rules]() {
+        Outcome outcome;
+        PayBreakdown worker(WorkerBreakdownConnection);
+
+        // 员工数据从时间点快照读取，计算期间的编辑不受影响；无法生成快照时直接读取存储
+        std::shared_ptr<DatabaseSnapshot::Snapshot> snapshot = DatabaseSnapshot::acquire();
+        std::unique_ptr<EmployeeStore> source = snapshot
+            ? std::unique_ptr<EmployeeStore>(new SqlManager(WorkerSourceConnection, snapshot->path))
+            : EmployeeStore::create(WorkerSourceConnection);
+        if (!worker.open() || !source->open())
+        {
+            outcome.error = QString::fromLocal8Bit("无法打开数据库");
+            outcome.summary.headcount = -1;
+        }
+        else
+        {
+            outcome.summary = worker.recompute(*source, rules, &outcome.error);
+        }
+        source->close();
+        worker.close();
+        return outcome;
+    }));
+}
+
+// 槽函数：后台重算完成
+void PayBreakdownDialog::onRecomputeFinished()
+{
+    recomputeButton->setEnabled(true);
+    Outcome outcome = watcher.result();
+    const PayBreakdown::Summary& summary = outcome.summary;
+    if (summary.headcount < 0)
+    {
+        text->clear();
+        QMessageBox::warning(this, QString::fromLocal8Bit("计算失败"), outcome.error);
+        return;
+    }
+
+    text->setPlainText(QString::fromLocal8Bit(
+        "%1 名员工，耗时 %2 ms\n"
+        "应发合计      %3\n"
+        "个人缴费合计  %4\n"
+        "单位缴费合计  %5\n"
+        "个税合计      %6\n"
+        "实发合计      %7")
+        .arg(summary.headcount)
+        .arg(summary.elapsedMs)
+        .arg(summary.totalGross, 0, 'f', 2)
+        .arg(summary.totalEmployeeContribution, 0, 'f', 2)
+        .arg(summary.totalEmployerContribution, 0, 'f', 2)
+        .arg(summary.totalTax, 0, 'f', 2)
+        .arg(summary.totalNet, 0, 'f', 2));
+}
+
+// 槽函数：显示一名员工的明细
+void PayBreakdownDialog::showEmployee()
+{
+    bool ok = false;
+    int id = employeeInput->text().trimmed().toInt(&ok);
+    PayBreakdown::Entry entry;
+    if (!ok || !breakdown.breakdown(id, entry))
+    {
+        text->setPlainText(QString::fromLocal8Bit("没有该员工的明细，请先重新计算。"));
+        return;
+    }
+
+    text->setPlainText(QString::fromLocal8Bit(
+        "员工 %1（%2，计算于 %3）\n"
+        "应发工资      %4\n"
+        "养老保险      %5\n"
+        "医疗保险      %6\n"
+        "失业保险      %7\n"
+        "住房公积金    %8\n"
+        "专项扣除      %9\n"
+        "个人所得税    %10\n"
+        "实发工资      %11\n"
+        "单位缴费      %12")
+        .arg(entry.employeeId)
+        .arg(entry.city)
+        .arg(entry.computedAt.toString("yyyy-MM-dd hh:mm"))
+        .arg(entry.gross, 0, 'f', 2)
+        .arg(entry.pension, 0, 'f', 2)
+        .arg(entry.medical, 0, 'f', 2)
+        .arg(entry.unemployment, 0, 'f', 2)
+        .arg(entry.housingFund, 0, 'f', 2)
+        .arg(entry.deduction, 0, 'f', 2)
+        .arg(entry.tax, 0, 'f', 2)
+        .arg(entry.net, 0, 'f', 2)
+        .arg(entry.employerContribution, 0, 'f', 2));
+}
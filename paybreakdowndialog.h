@@ -0,0 +1,67 @@
+﻿#ifndef PAYBREAKDOWNDIALOG_H
+#define PAYBREAKDOWNDIALOG_H
+
+#include <QDialog>
+#include <QFutureWatcher>
+#include "contributiontable.h"
+#include "paybreakdown.h"
+
+class QComboBox;
+class QLineEdit;
+class QPlainTextEdit;
+class QPushButton;
+
+// PayBreakdownDialog 类是工资明细窗口：
+// 选择城市后在后台按该城市的社保公积金规则重算全部员工的应发到实发明细，显示合计；
+// 输入员工 ID 可以查看该员工的逐项明细。城市规则在打开窗口时从 city_contributions.json 加载。
+class PayBreakdownDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit PayBreakdownDialog(QWidget* parent = nullptr);
+
+    // 析构函数，等待正在进行的计算结束后关闭连接
+    ~PayBreakdownDialog();
+
+private slots:
+    // 在后台重算
+    void recompute();
+
+    // 后台重算完成
+    void onRecomputeFinished();
+
+    // 显示一名员工的明细
+    void showEmployee();
+
+private:
+    // 后台重算的结果
+    struct Outcome
+    {
+        PayBreakdown::Summary summary;
+        QString error;
+    };
+
+    // 城市规则
+    ContributionTable table;
+
+    // 界面线程使用的明细读取连接
+    PayBreakdown breakdown;
+
+    // 城市选择
+    QComboBox* cityBox;
+
+    // 重算按钮，计算进行期间禁用
+    QPushButton* recomputeButton;
+
+    // 员工 ID 输入框
+    QLineEdit* employeeInput;
+
+    // 合计和明细
+    QPlainTextEdit* text;
+
+    // 后台重算任务
+    QFutureWatcher<Outcome> watcher;
+};
+
+#endif // PAYBREAKDOWNDIALOG_H
@@ -0,0 +1,66 @@
+﻿#include "payrolldashboard.h"
+#include "taxcalccenter.h"  // 各档税率，用作柱状图标签
+#include <QPainter>
+
+// PayrollDashboard 构造函数
+PayrollDashboard::PayrollDashboard(QWidget* parent)
+    : QWidget(parent)
+{
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+}
+
+// 设置汇总数据并重绘
+void PayrollDashboard::setSummary(const PayrollSummary& value)
+{
+    summary = value;
+    update();
+}
+
+// 建议大小
+QSize PayrollDashboard::sizeHint() const
+{
+    return QSize(600, fontMetrics().height() * 3 + 60);
+}
+
+// 绘制合计文字和柱状图
+void PayrollDashboard::paintEvent(QPaintEvent*)
+{
+    QPainter painter(this);
+    const int lineHeight = fontMetrics().height();
+
+    // 第一行：合计
+    painter.drawText(QRect(0, 0, width(), lineHeight), Qt::AlignLeft | Qt::AlignVCenter,
+        QString::fromLocal8Bit("人数 %1    工资总额 %2    税额总额 %3    平均税率 %4%")
+        .arg(summary.headcount())
+        .arg(summary.totalSalary(), 0, 'f', 2)
+        .arg(summary.totalTax(), 0, 'f', 2)
+        .arg(summary.effectiveRate() * 100, 0, 'f', 2));
+
+    // 柱状图：每个档位一根柱子，高度按人数最多的档位缩放，柱顶标注人数，柱底标注税率
+    qint64 maximum = 1;
+    for (const PayrollSummary::Bracket& bracket : summary.brackets)
+    {
+        maximum = qMax(maximum, bracket.headcount);
+    }
+
+    const int chartTop = lineHeight + 4 + lineHeight;
+    const int chartBottom = height() - lineHeight - 2;
+    const int slot = width() / PayrollSummary::BracketCount;
+    const int barWidth = qMax(4, slot * 3 / 5);
+
+    for (int k = 0; k < PayrollSummary::BracketCount; ++k)
+    {
+        const PayrollSummary::Bracket& bracket = summary.brackets[k];
+        int left = k * slot + (slot - barWidth) / 2;
+        int barHeight = int(double(chartBottom - chartTop) * bracket.headcount / maximum);
+
+        painter.fillRect(QRect(left, chartBottom - barHeight, barWidth, barHeight), palette().highlight());
+        painter.drawText(QRect(k * slot, chartBottom - barHeight - lineHeight, slot, lineHeight),
+            Qt::AlignCenter, QString::number(bracket.headcount));
+
+        QString label = k == 0
+            ? QString::fromLocal8Bit("免税")
+            : QString("%1%").arg(TaxCalcCenter::BracketRate[k - 1] * 100);
+        painter.drawText(QRect(k * slot, chartBottom + 2, slot, lineHeight), Qt::AlignCenter, label);
+    }
+}
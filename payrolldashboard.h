@@ -0,0 +1,31 @@
+﻿#ifndef PAYROLLDASHBOARD_H
+#define PAYROLLDASHBOARD_H
+
+#include <QWidget>
+#include "employeestore.h"
+
+// PayrollDashboard 类在主窗口中显示工资汇总：总人数、工资总额、税额总额、平均实际税率，
+// 以及各税率档位的人数分布柱状图。数据来自存储后端增量维护的汇总，刷新只需读取十个档位。
+class PayrollDashboard : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit PayrollDashboard(QWidget* parent = nullptr);
+
+    // 设置汇总数据并重绘
+    void setSummary(const PayrollSummary& summary);
+
+    // 建议大小：一行合计文字加一排柱状图
+    QSize sizeHint() const override;
+
+protected:
+    // 绘制合计文字和柱状图
+    void paintEvent(QPaintEvent* event) override;
+
+private:
+    // 当前显示的汇总
+    PayrollSummary summary;
+};
+
+#endif // PAYROLLDASHBOARD_H
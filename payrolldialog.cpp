@@ -0,0 +1,395 @@
+﻿#include "payrolldialog.h"
+#include "employeestore.h"  // 员工数据来源
+#include "sqlmanager.h"     // 统一的显示格式
+#include "jobscheduler.h"   // 后台任务
+#include "databasesnapshot.h" // 报表快照
+#include <QFontDatabase>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMessageBox>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <algorithm>
+#include <memory>
+
+namespace
+{
+    // 明细最多显示的行数
+    const int DetailLimit = 200;
+
+    // 后台核算使用的连接名，与界面线程的连接互不干扰
+    const char* WorkerLedgerConnection = "wagestax_payroll_worker";
+    const char* WorkerSourceConnection = "wagestax_payroll_source";
+    const char* WorkerSettlementConnection = "wagestax_settlement_worker";
+    const char* WorkerSettlementSourceConnection = "wagestax_settlement_source";
+    const char* WorkerBonusConnection = "wagestax_bonus_source";
+}
+
+// PayrollDialog 构造函数，创建界面
+PayrollDialog::PayrollDialog(QWidget* parent)
+    : QDialog(parent)
+    , periodInput(new QLineEdit(PayrollLedger::currentPeriod(), this))
+    , employeeInput(new QLineEdit(this))
+    , runButton(new QPushButton(QString::fromLocal8Bit("执行核算"), this))
+    , settleButton(new QPushButton(QString::fromLocal8Bit("年度汇算"), this))
+    , bonusButton(new QPushButton(QString::fromLocal8Bit("年终奖优化"), this))
+    , runsText(new QPlainTextEdit(this))
+    , detailText(new QPlainTextEdit(this))
+{
+    setWindowTitle(QString::fromLocal8Bit("工资核算"));
+    resize(720, 560);
+
+    periodInput->setPlaceholderText("YYYY-MM");
+    periodInput->setMaximumWidth(100);
+    employeeInput->setPlaceholderText(QString::fromLocal8Bit("员工ID"));
+    employeeInput->setMaximumWidth(100);
+    runsText->setReadOnly(true);
+    runsText->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    detailText->setReadOnly(true);
+    detailText->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+
+    QPushButton* closePeriodButton = new QPushButton(QString::fromLocal8Bit("结账"), this);
+    QPushButton* resultsButton = new QPushButton(QString::fromLocal8Bit("查看明细"), this);
+    QPushButton* historyButton = new QPushButton(QString::fromLocal8Bit("查询历史"), this);
+    QPushButton* closeButton = new QPushButton(QString::fromLocal8Bit("关闭"), this);
+
+    QHBoxLayout* periodRow = new QHBoxLayout();
+    periodRow->addWidget(new QLabel(QString::fromLocal8Bit("期间"), this));
+    periodRow->addWidget(periodInput);
+    periodRow->addWidget(runButton);
+    periodRow->addWidget(closePeriodButton);
+    periodRow->addWidget(resultsButton);
+    periodRow->addWidget(settleButton);
+    periodRow->addStretch();
+
+    QHBoxLayout* historyRow = new QHBoxLayout();
+    historyRow->addWidget(new QLabel(QString::fromLocal8Bit("员工"), this));
+    historyRow->addWidget(employeeInput);
+    historyRow->addWidget(historyButton);
+    historyRow->addStretch();
+    historyRow->addWidget(bonusButton);
+    historyRow->addWidget(closeButton);
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->addLayout(periodRow);
+    layout->addWidget(runsText, 1);
+    layout->addLayout(historyRow);
+    layout->addWidget(detailText, 2);
+
+    connect(runButton, &QPushButton::clicked, this, &PayrollDialog::runPayroll);
+    connect(settleButton, &QPushButton::clicked, this, &PayrollDialog::runSettlement);
+    connect(bonusButton, &QPushButton::clicked, this, &PayrollDialog::runBonusOptimizer);
+    connect(closePeriodButton, &QPushButton::clicked, this, &PayrollDialog::closePeriod);
+    connect(resultsButton, &QPushButton::clicked, this, &PayrollDialog::showPeriodResults);
+    connect(historyButton, &QPushButton::clicked, this, &PayrollDialog::showEmployeeHistory);
+    connect(employeeInput, &QLineEdit::returnPressed, this, &PayrollDialog::showEmployeeHistory);
+    connect(closeButton, &QPushButton::clicked, this, &QDialog::close);
+    connect(&runWatcher, &QFutureWatcher<RunOutcome>::finished, this, &PayrollDialog::onRunFinished);
+    connect(&settlementWatcher, &QFutureWatcher<SettlementOutcome>::finished, this, &PayrollDialog::onSettlementFinished);
+    connect(&bonusWatcher, &QFutureWatcher<BonusOutcome>::finished, this, &PayrollDialog::onBonusOptimizerFinished);
+
+    if (!ledger.open())
+    {
+        runsText->setPlainText(QString::fromLocal8Bit("无法打开数据库！"));
+    }
+}
+
+// PayrollDialog 析构函数
+PayrollDialog::~PayrollDialog()
+{
+    runWatcher.waitForFinished();
+    settlementWatcher.waitForFinished();
+    bonusWatcher.waitForFinished();
+    ledger.close();
+}
+
+// 显示时刷新期间列表
+void PayrollDialog::showEvent(QShowEvent* event)
+{
+    refreshRuns();
+    QDialog::showEvent(event);
+}
+
+// 槽函数：在后台执行核算
+void PayrollDialog::runPayroll()
+{
+    const QString period = periodInput->text().trimmed();
+    if (!PayrollLedger::isValidPeriod(period))
+    {
+        QMessageBox::warning(this, QString::fromLocal8Bit("输入错误"), QString::fromLocal8Bit("期间格式应为 YYYY-MM！"));
+        return;
+    }
+
+    runButton->setEnabled(false);
+    detailText->setPlainText(QString::fromLocal8Bit("正在核算 %1 ...").arg(period));
+
+    // 数据库连接只能在创建它的线程中使用，后台任务打开并关闭自己的连接
+    runWatcher.setFuture(JobScheduler::instance().run<RunOutcome>("payroll", JobScheduler::Normal, [period]() {
+        RunOutcome outcome;
+        PayrollLedger worker(WorkerLedgerConnection);
+
+        // 员工数据从时间点快照读取，核算期间的编辑不受影响；无法生成快照时直接读取存储
+        std::shared_ptr<DatabaseSnapshot::Snapshot> snapshot = DatabaseSnapshot::acquire();
+        std::unique_ptr<EmployeeStore> source = snapshot
+            ? std::unique_ptr<EmployeeStore>(new SqlManager(WorkerSourceConnection, snapshot->path))
+            : EmployeeStore::create(WorkerSourceConnection);
+        if (!worker.open() || !source->open())
+        {
+            outcome.error = QString::fromLocal8Bit("无法打开数据库");
+        }
+        else
+        {
+            outcome.run = worker.runPayroll(period, *source, &outcome.error);
+        }
+        source->close();
+        worker.close();
+        return outcome;
+    }));
+}
+
+// 槽函数：后台核算完成
+void PayrollDialog::onRunFinished()
+{
+    runButton->setEnabled(true);
+    RunOutcome outcome = runWatcher.result();
+    if (outcome.run.id == 0)
+    {
+        detailText->clear();
+        QMessageBox::warning(this, QString::fromLocal8Bit("核算失败"), outcome.error);
+        return;
+    }
+
+    detailText->setPlainText(QString::fromLocal8Bit("%1 核算完成：%2 人，工资合计 %3，税额合计 %4")
+        .arg(outcome.run.period)
+        .arg(outcome.run.headcount)
+        .arg(outcome.run.totalSalary, 0, 'f', 2)
+        .arg(outcome.run.totalTax, 0, 'f', 2));
+    refreshRuns();
+}
+
+// 槽函数：在后台对期间所在年度执行年度汇算
+void PayrollDialog::runSettlement()
+{
+    const QString period = periodInput->text().trimmed();
+    if (!PayrollLedger::isValidPeriod(period))
+    {
+        QMessageBox::warning(this, QString::fromLocal8Bit("输入错误"), QString::fromLocal8Bit("期间格式应为 YYYY-MM！"));
+        return;
+    }
+
+    const int year = period.left(4).toInt();
+    settleButton->setEnabled(false);
+    detailText->setPlainText(QString::fromLocal8Bit("正在进行 %1 年度汇算 ...").arg(year));
+
+    settlementWatcher.setFuture(JobScheduler::instance().run<SettlementOutcome>("settlement", JobScheduler::Normal, [year]() {
+        SettlementOutcome outcome;
+        AnnualSettlement worker(WorkerSettlementConnection);
+
+        // 核算记录从时间点快照读取；无法生成快照时（例如列式后端）直接读取结果所在的数据库
+        std::shared_ptr<DatabaseSnapshot::Snapshot> snapshot = DatabaseSnapshot::acquire();
+        SqlManager source(WorkerSettlementSourceConnection, snapshot ? snapshot->path : QString());
+        if (!worker.open() || !source.open())
+        {
+            outcome.error = QString::fromLocal8Bit("无法打开数据库");
+        }
+        else
+        {
+            outcome.summary = worker.settle(year, source, &outcome.error);
+            if (outcome.summary.year != 0)
+            {
+                outcome.largest = worker.results(year, DetailLimit);
+            }
+        }
+        source.close();
+        worker.close();
+        return outcome;
+    }));
+}
+
+// 槽函数：后台汇算完成，显示合计和应补/应退金额最大的员工
+void PayrollDialog::onSettlementFinished()
+{
+    settleButton->setEnabled(true);
+    SettlementOutcome outcome = settlementWatcher.result();
+    const AnnualSettlement::Summary& summary = outcome.summary;
+    if (summary.year == 0)
+    {
+        detailText->clear();
+        QMessageBox::warning(this, QString::fromLocal8Bit("汇算失败"), outcome.error);
+        return;
+    }
+
+    QStringList lines;
+    lines << QString::fromLocal8Bit("%1 年度汇算完成：%2 期（未结账 %3 期），%4 人，耗时 %5 ms")
+        .arg(summary.year).arg(summary.periods).arg(summary.openPeriods).arg(summary.headcount).arg(summary.elapsedMs);
+    lines << QString::fromLocal8Bit("收入合计 %1  已预扣 %2  应纳税额 %3  应补 %4  应退 %5")
+        .arg(summary.totalIncome, 0, 'f', 2)
+        .arg(summary.totalWithheld, 0, 'f', 2)
+        .arg(summary.totalLiability, 0, 'f', 2)
+        .arg(summary.totalDue, 0, 'f', 2)
+        .arg(summary.totalRefund, 0, 'f', 2);
+    lines << QString::fromLocal8Bit("应补或应退金额最大的 %1 名员工：").arg(outcome.largest.size());
+    for (const AnnualSettlement::Entry& entry : outcome.largest)
+    {
+        lines << QString::fromLocal8Bit("ID: %1  姓名: %2  期数: %3  收入: %4  已预扣: %5  应纳: %6  %7: %8")
+            .arg(entry.employeeId)
+            .arg(entry.name)
+            .arg(entry.months)
+            .arg(entry.income, 0, 'f', 2)
+            .arg(entry.withheld, 0, 'f', 2)
+            .arg(entry.liability, 0, 'f', 2)
+            .arg(entry.balance() >= 0 ? QString::fromLocal8Bit("应补") : QString::fromLocal8Bit("应退"))
+            .arg(qAbs(entry.balance()), 0, 'f', 2);
+    }
+    detailText->setPlainText(lines.join("\n"));
+}
+
+// 槽函数：在后台为全公司计算年终奖与工资的最优拆分
+void PayrollDialog::runBonusOptimizer()
+{
+    bonusButton->setEnabled(false);
+    detailText->setPlainText(QString::fromLocal8Bit("正在计算年终奖最优拆分 ..."));
+
+    bonusWatcher.setFuture(JobScheduler::instance().run<BonusOutcome>("bonus_optimizer", JobScheduler::Normal, []() {
+        BonusOutcome outcome;
+
+        // 在时间点快照上只读计算，计算期间的编辑不受影响；无法生成快照时直接读取存储
+        std::shared_ptr<DatabaseSnapshot::Snapshot> snapshot = DatabaseSnapshot::acquire();
+        std::unique_ptr<EmployeeStore> source = snapshot
+            ? std::unique_ptr<EmployeeStore>(new SqlManager(WorkerBonusConnection, snapshot->path))
+            : EmployeeStore::create(WorkerBonusConnection);
+        outcome.dataAsOf = snapshot ? snapshot->createdAt : QDateTime::currentDateTime();
+        if (!source->open())
+        {
+            outcome.error = QString::fromLocal8Bit("无法打开数据库");
+        }
+        else
+        {
+            std::vector<BonusOptimizer::Plan> plans;
+            outcome.summary = BonusOptimizer::run(*source, plans, &outcome.error);
+
+            // 只把节税最多的若干名员工带回界面线程
+            const size_t shown = std::min(plans.size(), size_t(DetailLimit));
+            std::partial_sort(plans.begin(), plans.begin() + shown, plans.end(),
+                [](const BonusOptimizer::Plan& a, const BonusOptimizer::Plan& b) { return a.saving() > b.saving(); });
+            plans.resize(shown);
+            outcome.largest.swap(plans);
+        }
+        source->close();
+        return outcome;
+    }));
+}
+
+// 槽函数：后台拆分优化完成，显示合计和节税金额最大的员工
+void PayrollDialog::onBonusOptimizerFinished()
+{
+    bonusButton->setEnabled(true);
+    BonusOutcome outcome = bonusWatcher.result();
+    const BonusOptimizer::Summary& summary = outcome.summary;
+    if (summary.headcount < 0)
+    {
+        detailText->clear();
+        QMessageBox::warning(this, QString::fromLocal8Bit("计算失败"), outcome.error);
+        return;
+    }
+
+    QStringList lines;
+    lines << QString::fromLocal8Bit("年终奖最优拆分（年薪按当前月薪 × 12，数据截至 %4）：%1 人，其中 %2 人可以节税，耗时 %3 ms")
+        .arg(summary.headcount).arg(summary.improved).arg(summary.elapsedMs)
+        .arg(outcome.dataAsOf.toString("yyyy-MM-dd hh:mm:ss"));
+    lines << QString::fromLocal8Bit("年薪合计 %1  年终奖合计 %2  全部按工资计税 %3  最优拆分计税 %4  节税 %5")
+        .arg(summary.totalPackage, 0, 'f', 2)
+        .arg(summary.totalBonus, 0, 'f', 2)
+        .arg(summary.totalBaselineTax, 0, 'f', 2)
+        .arg(summary.totalOptimizedTax, 0, 'f', 2)
+        .arg(summary.totalBaselineTax - summary.totalOptimizedTax, 0, 'f', 2);
+    lines << QString::fromLocal8Bit("节税金额最大的 %1 名员工：").arg(outcome.largest.size());
+    for (const BonusOptimizer::Plan& plan : outcome.largest)
+    {
+        lines << QString::fromLocal8Bit("ID: %1  姓名: %2  年薪: %3  年终奖: %4  工资: %5  税额: %6（奖金 %7）  节税: %8")
+            .arg(plan.employeeId)
+            .arg(plan.name)
+            .arg(plan.package, 0, 'f', 2)
+            .arg(plan.bonus, 0, 'f', 2)
+            .arg(plan.salary(), 0, 'f', 2)
+            .arg(plan.totalTax(), 0, 'f', 2)
+            .arg(plan.bonusTax, 0, 'f', 2)
+            .arg(plan.saving(), 0, 'f', 2);
+    }
+    detailText->setPlainText(lines.join("\n"));
+}
+
+// 槽函数：结账
+void PayrollDialog::closePeriod()
+{
+    const QString period = periodInput->text().trimmed();
+    if (QMessageBox::question(this, QString::fromLocal8Bit("结账"),
+            QString::fromLocal8Bit("结账后期间 %1 不能再重新核算，是否继续？").arg(period)) != QMessageBox::Yes)
+    {
+        return;
+    }
+
+    QString error;
+    if (!ledger.closePeriod(period, &error))
+    {
+        QMessageBox::warning(this, QString::fromLocal8Bit("结账失败"), error);
+        return;
+    }
+    refreshRuns();
+}
+
+// 槽函数：刷新期间列表
+void PayrollDialog::refreshRuns()
+{
+    QStringList lines;
+    lines << QString::fromLocal8Bit("期间      状态    人数        工资合计          税额合计          核算时间");
+    for (const PayrollLedger::Run& run : ledger.runs())
+    {
+        lines << QString("%1   %2  %3  %4  %5  %6")
+            .arg(run.period)
+            .arg(run.closed ? QString::fromLocal8Bit("已结账") : QString::fromLocal8Bit("未结账"))
+            .arg(run.headcount, 10)
+            .arg(run.totalSalary, 16, 'f', 2)
+            .arg(run.totalTax, 16, 'f', 2)
+            .arg(run.createdAt.toString("yyyy-MM-dd hh:mm"));
+    }
+    runsText->setPlainText(lines.join("\n"));
+}
+
+// 槽函数：显示期间明细
+void PayrollDialog::showPeriodResults()
+{
+    const QString period = periodInput->text().trimmed();
+    std::vector<PayrollLedger::Entry> entries = ledger.periodResults(period, DetailLimit);
+
+    QStringList lines;
+    lines << QString::fromLocal8Bit("%1 明细（按员工ID，最多显示 %2 行）").arg(period).arg(DetailLimit);
+    for (const PayrollLedger::Entry& entry : entries)
+    {
+        lines << SqlManager::formatEmployee(entry.employeeId, entry.name, entry.salary, entry.tax);
+    }
+    detailText->setPlainText(lines.join("\n"));
+}
+
+// 槽函数：显示员工历史
+void PayrollDialog::showEmployeeHistory()
+{
+    bool ok = false;
+    int id = employeeInput->text().trimmed().toInt(&ok);
+    if (!ok)
+    {
+        detailText->setPlainText(QString::fromLocal8Bit("请输入员工ID"));
+        return;
+    }
+
+    std::vector<PayrollLedger::Entry> entries = ledger.employeeHistory(id);
+    QStringList lines;
+    lines << QString::fromLocal8Bit("员工 %1 共 %2 期核算记录").arg(id).arg(entries.size());
+    for (const PayrollLedger::Entry& entry : entries)
+    {
+        lines << entry.period + "   " + SqlManager::formatEmployee(entry.employeeId, entry.name, entry.salary, entry.tax);
+    }
+    detailText->setPlainText(lines.join("\n"));
+}
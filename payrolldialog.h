@@ -0,0 +1,122 @@
+﻿#ifndef PAYROLLDIALOG_H
+#define PAYROLLDIALOG_H
+
+#include <QDialog>
+#include <QFutureWatcher>
+#include "payrollledger.h"
+#include "annualsettlement.h"
+#include "bonusoptimizer.h"
+
+class QLineEdit;
+class QPlainTextEdit;
+class QPushButton;
+
+// PayrollDialog 类是工资核算窗口：
+// 对输入的期间执行核算或结账，对期间所在年度执行年度汇算，列出全部期间的合计，
+// 并可以查看某一期间的明细或某名员工的历史，或为全公司计算年终奖与工资的最优拆分。
+// 核算、汇算和拆分优化在线程池中使用独立的数据库连接执行，进行期间窗口保持响应。
+class PayrollDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit PayrollDialog(QWidget* parent = nullptr);
+
+    // 析构函数，等待正在进行的核算结束后关闭连接
+    ~PayrollDialog();
+
+protected:
+    // 显示时刷新期间列表
+    void showEvent(QShowEvent* event) override;
+
+private slots:
+    // 在后台执行核算
+    void runPayroll();
+
+    // 后台核算完成
+    void onRunFinished();
+
+    // 在后台执行年度汇算
+    void runSettlement();
+
+    // 后台汇算完成
+    void onSettlementFinished();
+
+    // 在后台计算年终奖的最优拆分
+    void runBonusOptimizer();
+
+    // 后台拆分优化完成
+    void onBonusOptimizerFinished();
+
+    // 结账
+    void closePeriod();
+
+    // 刷新期间列表
+    void refreshRuns();
+
+    // 显示期间明细
+    void showPeriodResults();
+
+    // 显示员工历史
+    void showEmployeeHistory();
+
+private:
+    // 后台核算的结果
+    struct RunOutcome
+    {
+        PayrollLedger::Run run;
+        QString error;
+    };
+
+    // 后台汇算的结果
+    struct SettlementOutcome
+    {
+        AnnualSettlement::Summary summary;
+        std::vector<AnnualSettlement::Entry> largest;  // 应补或应退金额最大的员工
+        QString error;
+    };
+
+    // 后台拆分优化的结果
+    struct BonusOutcome
+    {
+        BonusOptimizer::Summary summary;
+        std::vector<BonusOptimizer::Plan> largest;  // 节税金额最大的员工
+        QDateTime dataAsOf;                         // 所用数据的时间点
+        QString error;
+    };
+
+    // 界面线程使用的核算账本
+    PayrollLedger ledger;
+
+    // 期间输入框
+    QLineEdit* periodInput;
+
+    // 员工 ID 输入框
+    QLineEdit* employeeInput;
+
+    // 执行核算按钮，核算进行期间禁用
+    QPushButton* runButton;
+
+    // 年度汇算按钮，汇算进行期间禁用
+    QPushButton* settleButton;
+
+    // 年终奖优化按钮，计算进行期间禁用
+    QPushButton* bonusButton;
+
+    // 期间列表
+    QPlainTextEdit* runsText;
+
+    // 明细或历史
+    QPlainTextEdit* detailText;
+
+    // 后台核算任务
+    QFutureWatcher<RunOutcome> runWatcher;
+
+    // 后台汇算任务
+    QFutureWatcher<SettlementOutcome> settlementWatcher;
+
+    // 后台拆分优化任务
+    QFutureWatcher<BonusOutcome> bonusWatcher;
+};
+
+#endif // PAYROLLDIALOG_H
@@ -0,0 +1,440 @@
+﻿#include "payrollledger.h"
+#include "taxcalccenter.h"     // 批量计税
+#include "metricsregistry.h"   // 核算耗时统计
+#include "tracerecorder.h"     // 时间线区间
+#include "slowquerylog.h"      // 慢查询日志与执行计划
+#include "databasemaintenance.h" // 改动行数统计
+#include "databasesnapshot.h"  // 提交后使报表快照失效
+#include <QDate>
+#include <QDebug>
+#include <QRegularExpression>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+
+namespace
+{
+    // 每页读取的员工数，也是每次批量计税的长度
+    const int SnapshotPageSize = 4096;
+
+    // 按操作区分的耗时直方图
+    MetricsHistogram& payrollLatency(const char* operation)
+    {
+        return MetricsRegistry::instance().histogram("wagestax_payroll_ns",
+            QString("operation=\"%1\"").arg(operation), "PayrollLedger operation latency in nanoseconds");
+    }
+
+    // 从查询的当前行读取核算概要，列顺序与 RunColumns 一致
+    const char* RunColumns = "id, period, status, created_at, closed_at, headcount, total_salary, total_tax";
+
+    PayrollLedger::Run readRun(const QSqlQuery& query)
+    {
+        PayrollLedger::Run run;
+        run.id = query.value(0).toInt();
+        run.period = query.value(1).toString();
+        run.closed = query.value(2).toString() == "closed";
+        run.createdAt = QDateTime::fromString(query.value(3).toString(), Qt::ISODate);
+        run.closedAt = QDateTime::fromString(query.value(4).toString(), Qt::ISODate);
+        run.headcount = query.value(5).toInt();
+        run.totalSalary = query.value(6).toDouble();
+        run.totalTax = query.value(7).toDouble();
+        return run;
+    }
+}
+
+// PayrollLedger 构造函数
+PayrollLedger::PayrollLedger(const QString& connectionName)
+    : connection(connectionName)
+{
+
+}
+
+// 打开数据库并创建核算表
+bool PayrollLedger::open()
+{
+    if (!connection.open())
+    {
+        return false;
+    }
+
+    QSqlQuery query(connection.database());
+    if (!query.exec("CREATE TABLE IF NOT EXISTS payroll_run ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+        "period TEXT NOT NULL UNIQUE, "          // 期间 YYYY-MM，唯一索引用于按期间查找
+        "partition_table TEXT NOT NULL, "        // 结果所在的年度分区表
+        "status TEXT NOT NULL DEFAULT 'open', "  // open 或 closed
+        "created_at TEXT NOT NULL, "
+        "closed_at TEXT, "
+        "headcount INTEGER NOT NULL DEFAULT 0, "
+        "total_salary REAL NOT NULL DEFAULT 0, "
+        "total_tax REAL NOT NULL DEFAULT 0)"))
+    {
+        qDebug() << "Failed to create payroll_run:" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+// 关闭数据库
+void PayrollLedger::close()
+{
+    connection.close();
+}
+
+// 检查期间格式
+bool PayrollLedger::isValidPeriod(const QString& period)
+{
+    static const QRegularExpression pattern("^\\d{4}-(0[1-9]|1[0-2])$");
+    return pattern.match(period).hasMatch();
+}
+
+// 年度分区表名，期间已经校验过格式，年份只包含数字，可以直接拼接到 SQL 中
+QString PayrollLedger::partitionFor(const QString& period)
+{
+    return "payroll_results_" + period.left(4);
+}
+
+// 当前月份
+QString PayrollLedger::currentPeriod()
+{
+    return QDate::currentDate().toString("yyyy-MM");
+}
+
+// 已创建的年度分区
+QStringList PayrollLedger::partitions()
+{
+    QStringList tables;
+    QSqlQuery query(connection.database());
+    if (query.exec("SELECT DISTINCT partition_table FROM payroll_run ORDER BY partition_table"))
+    {
+        while (query.next())
+        {
+            tables << query.value(0).toString();
+        }
+    }
+    return tables;
+}
+
+// 创建年度分区表
+bool PayrollLedger::createPartition(const QString& table)
+{
+    // WITHOUT ROWID 表直接按主键 (run_id, employee_id) 组织，同一期间的行在磁盘上相邻
+    QSqlQuery query(connection.database());
+    if (!query.exec(QString("CREATE TABLE IF NOT EXISTS %1 ("
+            "run_id INTEGER NOT NULL, "
+            "employee_id INTEGER NOT NULL, "
+            "name TEXT NOT NULL, "
+            "salary REAL NOT NULL, "
+            "tax REAL NOT NULL, "
+            "deduction REAL NOT NULL DEFAULT 0, "
+            "PRIMARY KEY (run_id, employee_id)) WITHOUT ROWID").arg(table))
+        || !query.exec(QString("CREATE INDEX IF NOT EXISTS idx_%1_employee ON %1 (employee_id, run_id)").arg(table)))
+    {
+        qDebug() << "Failed to create payroll partition" << table << ":" << query.lastError().text();
+        return false;
+    }
+
+    // 加入专项扣除之前创建的分区没有 deduction 列，补上该列；列已存在时语句失败，可以忽略
+    query.exec(QString("ALTER TABLE %1 ADD COLUMN deduction REAL NOT NULL DEFAULT 0").arg(table));
+    return true;
+}
+
+// 执行工资核算
+PayrollLedger::Run PayrollLedger::runPayroll(const QString& period, EmployeeStore& source, QString* error)
+{
+    static MetricsHistogram& latency = payrollLatency("run");
+    ScopedLatency timer(latency);
+    TraceSpan span("PayrollLedger::runPayroll", "sql");
+
+    Run run;
+    if (!isValidPeriod(period))
+    {
+        SqlManager::reportError(error, "Payroll", QString::fromLocal8Bit("期间格式应为 YYYY-MM"));
+        return run;
+    }
+
+    // 分区表在写事务之外创建：共享缓存的内存数据库中，修改表结构会锁住其他连接对 sqlite_master 的读取
+    const QString table = partitionFor(period);
+    if (!createPartition(table))
+    {
+        SqlManager::reportError(error, "Payroll", QString::fromLocal8Bit("无法创建结果表 %1").arg(table));
+        return run;
+    }
+
+    // 读取和计算：不持有写锁，核算期间界面和其他连接照常提交修改。
+    // 来源是 SQLite 连接时在一个读事务中分页读取，WAL 模式下各页来自同一时刻的数据，也不阻塞写入；
+    // 来源是报表快照时数据本来就不会变化
+    std::vector<int> ids;
+    std::vector<QString> names;
+    std::vector<double> salaries;
+    std::vector<double> deductions;
+    std::vector<double> taxes;
+    {
+        TraceSpan readSpan("PayrollLedger::read", "sql");
+        SqlManager* sqlSource = dynamic_cast<SqlManager*>(&source);
+        const bool reading = sqlSource && sqlSource->database().transaction();
+
+        int lastId = 0;
+        for (;;)
+        {
+            std::vector<EmployeeRecord> page = source.queryRecordsAfter(lastId, SnapshotPageSize);
+            if (page.empty())
+            {
+                break;
+            }
+            lastId = page.back().id;
+
+            // 每页排成工资和扣除两列后批量计税，专项扣除合计已随记录一并读出
+            const size_t offset = ids.size();
+            ids.resize(offset + page.size());
+            names.resize(offset + page.size());
+            salaries.resize(offset + page.size());
+            deductions.resize(offset + page.size());
+            taxes.resize(offset + page.size());
+            for (size_t i = 0; i < page.size(); ++i)
+            {
+                ids[offset + i] = page[i].id;
+                names[offset + i] = page[i].name;
+                salaries[offset + i] = page[i].salary;
+                deductions[offset + i] = page[i].deduction;
+            }
+            TaxCalcCenter::calculateTaxBatch(salaries.data() + offset, deductions.data() + offset, taxes.data() + offset, int(page.size()));
+
+            if (int(page.size()) < SnapshotPageSize)
+            {
+                break;
+            }
+        }
+        if (reading)
+        {
+            sqlSource->database().commit();
+        }
+    }
+
+    // 写入：写锁只在替换结果和更新合计期间持有
+    TraceSpan writeSpan("PayrollLedger::write", "sql");
+    QSqlDatabase db = connection.database();
+    QSqlQuery query(db);
+    if (!query.exec("BEGIN IMMEDIATE"))
+    {
+        SqlManager::reportError(error, "Payroll", QString::fromLocal8Bit("无法开始事务：%1").arg(query.lastError().text()));
+        return run;
+    }
+
+    // 事务中任何一步失败都回滚
+    auto fail = [&](const QString& message) {
+        query.finish();
+        query.exec("ROLLBACK");
+        SqlManager::reportError(error, "Payroll", message);
+        return Run();
+    };
+
+    // 查找已有的核算：已结账的拒绝，未结账的删除旧结果后重新核算（主键前缀范围删除）
+    const QString now = QDateTime::currentDateTime().toString(Qt::ISODate);
+    query.prepare("SELECT id, status FROM payroll_run WHERE period = ?");
+    query.addBindValue(period);
+    if (!query.exec())
+    {
+        return fail(query.lastError().text());
+    }
+    if (query.next())
+    {
+        run.id = query.value(0).toInt();
+        if (query.value(1).toString() == "closed")
+        {
+            return fail(QString::fromLocal8Bit("期间 %1 已结账，不能重新核算").arg(period));
+        }
+        query.finish();
+
+        query.prepare(QString("DELETE FROM %1 WHERE run_id = ?").arg(table));
+        query.addBindValue(run.id);
+        if (!query.exec())
+        {
+            return fail(query.lastError().text());
+        }
+        DatabaseMaintenance::recordChurn(query.numRowsAffected());
+    }
+    else
+    {
+        query.finish();
+        query.prepare("INSERT INTO payroll_run (period, partition_table, created_at) VALUES (?, ?, ?)");
+        query.addBindValue(period);
+        query.addBindValue(table);
+        query.addBindValue(now);
+        if (!query.exec())
+        {
+            return fail(query.lastError().text());
+        }
+        run.id = query.lastInsertId().toInt();
+    }
+
+    // 插入语句只准备一次
+    QSqlQuery insert(db);
+    insert.prepare(QString("INSERT INTO %1 (run_id, employee_id, name, salary, tax, deduction) VALUES (?, ?, ?, ?, ?, ?)").arg(table));
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+        insert.bindValue(0, run.id);
+        insert.bindValue(1, ids[i]);
+        insert.bindValue(2, names[i]);
+        insert.bindValue(3, salaries[i]);
+        insert.bindValue(4, taxes[i]);
+        insert.bindValue(5, deductions[i]);
+        if (!insert.exec())
+        {
+            insert.finish();
+            return fail(insert.lastError().text());
+        }
+        ++run.headcount;
+        run.totalSalary += salaries[i];
+        run.totalTax += taxes[i];
+    }
+    insert.finish();
+
+    query.prepare("UPDATE payroll_run SET created_at = ?, headcount = ?, total_salary = ?, total_tax = ? WHERE id = ?");
+    query.addBindValue(now);
+    query.addBindValue(run.headcount);
+    query.addBindValue(run.totalSalary);
+    query.addBindValue(run.totalTax);
+    query.addBindValue(run.id);
+    if (!query.exec())
+    {
+        return fail(query.lastError().text());
+    }
+    if (!query.exec("COMMIT"))
+    {
+        return fail(QString::fromLocal8Bit("无法提交核算：%1").arg(query.lastError().text()));
+    }
+    DatabaseSnapshot::invalidate();
+
+    run.period = period;
+    run.createdAt = QDateTime::fromString(now, Qt::ISODate);
+    qDebug() << "Payroll run" << period << "finished:" << run.headcount << "employees in"
+        << timer.elapsedNs() / 1000000 << "ms";
+    return run;
+}
+
+// 结账
+bool PayrollLedger::closePeriod(const QString& period, QString* error)
+{
+    static MetricsHistogram& latency = payrollLatency("close");
+    ScopedLatency timer(latency);
+    TraceSpan span("PayrollLedger::closePeriod", "sql");
+    QSqlQuery query(connection.database());
+    QueryProbe probe(query, connection.database());
+    query.prepare("UPDATE payroll_run SET status = 'closed', closed_at = ? WHERE period = ? AND status = 'open'");
+    query.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
+    query.addBindValue(period);
+    if (!query.exec())
+    {
+        SqlManager::reportError(error, "Payroll", query.lastError().text());
+        return false;
+    }
+    if (query.numRowsAffected() == 0)
+    {
+        SqlManager::reportError(error, "Payroll", QString::fromLocal8Bit("期间 %1 尚未核算或已经结账").arg(period));
+        return false;
+    }
+    DatabaseSnapshot::invalidate();
+    return true;
+}
+
+// 全部核算概要
+std::vector<PayrollLedger::Run> PayrollLedger::runs()
+{
+    std::vector<Run> result;
+    QSqlQuery query(connection.database());
+    if (!query.exec(QString("SELECT %1 FROM payroll_run ORDER BY period DESC").arg(RunColumns)))
+    {
+        qDebug() << "Payroll run query failed:" << query.lastError().text();
+        return result;
+    }
+    while (query.next())
+    {
+        result.push_back(readRun(query));
+    }
+    return result;
+}
+
+// 某一期间的明细
+std::vector<PayrollLedger::Entry> PayrollLedger::periodResults(const QString& period, int limit)
+{
+    static MetricsHistogram& latency = payrollLatency("period_results");
+    ScopedLatency timer(latency);
+    TraceSpan span("PayrollLedger::periodResults", "sql");
+    std::vector<Entry> result;
+    if (!isValidPeriod(period))
+    {
+        return result;
+    }
+
+    QSqlQuery query(connection.database());
+    QueryProbe probe(query, connection.database());
+    query.prepare(QString("SELECT p.employee_id, p.name, p.salary, p.tax FROM %1 p "
+        "JOIN payroll_run r ON r.id = p.run_id WHERE r.period = ? ORDER BY p.employee_id LIMIT ?")
+        .arg(partitionFor(period)));
+    query.addBindValue(period);
+    query.addBindValue(limit);
+    if (!query.exec())
+    {
+        qDebug() << "Payroll period query failed:" << query.lastError().text();
+        return result;
+    }
+    while (query.next())
+    {
+        Entry entry;
+        entry.period = period;
+        entry.employeeId = query.value(0).toInt();
+        entry.name = query.value(1).toString();
+        entry.salary = query.value(2).toDouble();
+        entry.tax = query.value(3).toDouble();
+        result.push_back(entry);
+    }
+    probe.setRows(int(result.size()));
+    return result;
+}
+
+// 某名员工的历史
+std::vector<PayrollLedger::Entry> PayrollLedger::employeeHistory(int employeeId)
+{
+    static MetricsHistogram& latency = payrollLatency("employee_history");
+    ScopedLatency timer(latency);
+    TraceSpan span("PayrollLedger::employeeHistory", "sql");
+    std::vector<Entry> result;
+
+    // 每个年度分区一个子查询，各自走 (employee_id, run_id) 索引
+    QStringList parts;
+    for (const QString& table : partitions())
+    {
+        parts << QString("SELECT r.period, p.name, p.salary, p.tax FROM %1 p "
+            "JOIN payroll_run r ON r.id = p.run_id WHERE p.employee_id = ?").arg(table);
+    }
+    if (parts.isEmpty())
+    {
+        return result;
+    }
+
+    QSqlQuery query(connection.database());
+    QueryProbe probe(query, connection.database());
+    query.prepare(parts.join(" UNION ALL ") + " ORDER BY 1");
+    for (int i = 0; i < parts.size(); ++i)
+    {
+        query.addBindValue(employeeId);
+    }
+    if (!query.exec())
+    {
+        qDebug() << "Payroll history query failed:" << query.lastError().text();
+        return result;
+    }
+    while (query.next())
+    {
+        Entry entry;
+        entry.period = query.value(0).toString();
+        entry.employeeId = employeeId;
+        entry.name = query.value(1).toString();
+        entry.salary = query.value(2).toDouble();
+        entry.tax = query.value(3).toDouble();
+        result.push_back(entry);
+    }
+    probe.setRows(int(result.size()));
+    return result;
+}
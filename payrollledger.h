@@ -0,0 +1,102 @@
+﻿#ifndef PAYROLLLEDGER_H
+#define PAYROLLLEDGER_H
+
+#include <QDateTime>
+#include <QString>
+#include <QStringList>
+#include <vector>
+#include "sqlmanager.h"
+
+// PayrollLedger 类管理按月的工资核算（payroll run）及其结果
+// 每个期间（YYYY-MM）在 payroll_run 表中占一行，记录状态（open/closed）和人数、工资、税额合计；
+// 每名员工的核算结果写入按年分区的结果表 payroll_results_YYYY，主键为 (run_id, employee_id)，
+// 另有 (employee_id, run_id) 索引：
+//   - 查询某一期间的明细沿主键前缀扫描，只读该期间的行；
+//   - 查询某名员工的历史只在每个年度分区上做一次索引查找，与员工总数和期间数量无关；
+//   - 新的期间只向当年分区追加行，结账只修改 payroll_run 中的一行，不复制任何结果数据。
+// 核算结果保存在员工数据所在的 SQLite 数据库中；列存储后端没有数据库文件，结果写入配置的数据库文件路径。
+class PayrollLedger
+{
+public:
+    // 一次工资核算的概要
+    struct Run
+    {
+        int id = 0;               // 核算 ID，0 表示不存在
+        QString period;           // 期间，格式 YYYY-MM
+        bool closed = false;      // 是否已结账
+        QDateTime createdAt;      // 核算时间
+        QDateTime closedAt;       // 结账时间
+        int headcount = 0;        // 人数
+        double totalSalary = 0;   // 工资合计
+        double totalTax = 0;      // 税额合计
+    };
+
+    // 一名员工在某一期间的核算结果
+    struct Entry
+    {
+        QString period;           // 期间
+        int employeeId = 0;       // 员工 ID
+        QString name;             // 核算时的姓名
+        double salary = 0;        // 核算时的工资
+        double tax = 0;           // 核算时的税额
+    };
+
+    // 构造函数
+    // 参数:
+    //   - connectionName: 使用的数据库连接名（线程规则见 SqlManager 构造函数）
+    explicit PayrollLedger(const QString& connectionName = "wagestax_payroll");
+
+    // 打开数据库并创建 payroll_run 表（已存在时跳过），返回是否成功
+    bool open();
+
+    // 关闭并移除数据库连接
+    void close();
+
+    // runPayroll 函数对一个期间执行工资核算：
+    // 先不加写锁按 ID 分页读取员工（来源是 SQLite 连接时在一个读事务中读取），每页用 calculateTaxBatch 按工资和专项扣除批量计税，
+    // 然后只在一个较短的写事务中替换当年分区中该期间的结果并写入合计，核算期间界面的编辑不会被阻塞。
+    // 期间尚未结账时重新核算会替换该期间的结果；已结账的期间拒绝重新核算。
+    // 参数:
+    //   - period: 期间，格式 YYYY-MM
+    //   - source: 员工数据来源
+    //   - error: 失败时写入原因（可以为空）
+    // 返回值：核算概要，失败时 id 为 0
+    Run runPayroll(const QString& period, EmployeeStore& source, QString* error = nullptr);
+
+    // closePeriod 函数把期间标记为已结账，只修改 payroll_run 中的一行
+    // 返回值：是否成功（期间不存在或已经结账时返回 false）
+    bool closePeriod(const QString& period, QString* error = nullptr);
+
+    // runs 函数返回全部核算概要，按期间从新到旧排列
+    std::vector<Run> runs();
+
+    // periodResults 函数按员工 ID 顺序返回某一期间的明细
+    // 参数:
+    //   - period: 期间
+    //   - limit: 最多返回的条数
+    std::vector<Entry> periodResults(const QString& period, int limit);
+
+    // employeeHistory 函数返回某名员工在各期间的核算结果，按期间从早到晚排列
+    std::vector<Entry> employeeHistory(int employeeId);
+
+    // isValidPeriod 函数检查期间格式是否为 YYYY-MM
+    static bool isValidPeriod(const QString& period);
+
+    // partitionFor 函数返回期间所在的年度分区表名，例如 2024-03 对应 payroll_results_2024
+    static QString partitionFor(const QString& period);
+
+    // currentPeriod 函数返回当前月份对应的期间
+    static QString currentPeriod();
+
+private:
+    // 已创建的年度分区表名（按名称排序）
+    QStringList partitions();
+
+    // 创建年度分区表及其员工索引（已存在时跳过）
+    bool createPartition(const QString& table);
+
+    // 数据库连接，路径和内存数据库的选择与员工数据一致
+    SqlManager connection;
+};
+
+#endif // PAYROLLLEDGER_H
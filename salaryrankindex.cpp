@@ -0,0 +1,150 @@
+﻿#include "salaryrankindex.h"
+#include <algorithm>
+#include <cmath>
+
+// SalaryRankIndex 构造函数，分配全部桶（约 4 MB）
+SalaryRankIndex::SalaryRankIndex()
+    : tree(size_t(BucketCount) + 1, 0)
+{
+
+}
+
+// 工资所在的桶
+int SalaryRankIndex::bucketOf(double salary)
+{
+    if (!(salary > 0))
+    {
+        return 0;
+    }
+    return salary >= BucketCount - 1 ? BucketCount - 1 : int(salary);
+}
+
+// 第 bucket 个桶的人数加 delta
+void SalaryRankIndex::add(int bucket, int delta)
+{
+    for (int i = bucket + 1; i <= BucketCount; i += i & -i)
+    {
+        tree[size_t(i)] += delta;
+    }
+}
+
+// 前 bucket 个桶的人数之和
+int SalaryRankIndex::prefix(int bucket) const
+{
+    int sum = 0;
+    for (int i = bucket; i > 0; i -= i & -i)
+    {
+        sum += tree[size_t(i)];
+    }
+    return sum;
+}
+
+// 第 k 小的工资所在的桶：自顶向下在树状数组上做二分
+int SalaryRankIndex::kth(int k) const
+{
+    int position = 0;
+    for (int step = BucketCount; step > 0; step >>= 1)
+    {
+        int next = position + step;
+        if (next <= BucketCount && tree[size_t(next)] < k)
+        {
+            position = next;
+            k -= tree[size_t(next)];
+        }
+    }
+    // position 是人数之和小于 k 的最长前缀，第 k 小落在下一个桶
+    return position;
+}
+
+// 全量构建：先统计各桶人数，再线性时间建树
+void SalaryRankIndex::build(const std::vector<std::pair<int, double>>& values)
+{
+    std::fill(tree.begin(), tree.end(), 0);
+    salaries.clear();
+    salaries.reserve(int(values.size()));
+
+    for (const auto& value : values)
+    {
+        salaries.insert(value.first, value.second);
+    }
+    for (auto it = salaries.cbegin(); it != salaries.cend(); ++it)
+    {
+        ++tree[size_t(bucketOf(it.value())) + 1];
+    }
+    total = salaries.size();
+
+    for (int i = 1; i <= BucketCount; ++i)
+    {
+        int parent = i + (i & -i);
+        if (parent <= BucketCount)
+        {
+            tree[size_t(parent)] += tree[size_t(i)];
+        }
+    }
+}
+
+// 添加或修改一名员工的工资
+void SalaryRankIndex::upsert(int id, double salary)
+{
+    auto it = salaries.find(id);
+    if (it != salaries.end())
+    {
+        add(bucketOf(it.value()), -1);
+        it.value() = salary;
+    }
+    else
+    {
+        salaries.insert(id, salary);
+        ++total;
+    }
+    add(bucketOf(salary), 1);
+}
+
+// 删除一名员工
+void SalaryRankIndex::remove(int id)
+{
+    auto it = salaries.find(id);
+    if (it == salaries.end())
+    {
+        return;
+    }
+    add(bucketOf(it.value()), -1);
+    salaries.erase(it);
+    --total;
+}
+
+// 分位数：取第 ceil(quantile × 人数) 小的工资
+double SalaryRankIndex::percentile(double quantile) const
+{
+    if (total == 0)
+    {
+        return 0;
+    }
+    int k = int(std::ceil(quantile * total));
+    k = k < 1 ? 1 : (k > total ? total : k);
+    return double(kth(k));
+}
+
+// 工资低于 salary 的人数（同一个 1 元桶内的员工视为相同工资）
+int SalaryRankIndex::countBelow(double salary) const
+{
+    return prefix(bucketOf(salary));
+}
+
+// 工资高于 salary 的人数
+int SalaryRankIndex::countAbove(double salary) const
+{
+    return total - prefix(bucketOf(salary) + 1);
+}
+
+// 查询员工的当前工资
+bool SalaryRankIndex::salaryOf(int id, double& salary) const
+{
+    auto it = salaries.constFind(id);
+    if (it == salaries.constEnd())
+    {
+        return false;
+    }
+    salary = it.value();
+    return true;
+}
@@ -0,0 +1,66 @@
+﻿#ifndef SALARYRANKINDEX_H
+#define SALARYRANKINDEX_H
+
+#include <QHash>
+#include <vector>
+
+// SalaryRankIndex 类是工资的顺序统计索引，用于中位数、分位数和排名查询
+// 以 1 元为一个桶，用树状数组（Fenwick 树）保存各桶人数的前缀和：
+// 增删改是一次 O(log n) 的更新，第 k 小的工资和某个工资的排名都是 O(log n) 的查询，不需要排序。
+// 另外保存每名员工的当前工资，修改和删除时据此移出旧值。
+// 与 EmployeeSearchIndex 相同，在后台线程构建完成后交给界面线程，之后只在界面线程上使用。
+class SalaryRankIndex
+{
+public:
+    SalaryRankIndex();
+
+    // 全量构建
+    void build(const std::vector<std::pair<int, double>>& salaries);
+
+    // 添加或修改一名员工的工资
+    void upsert(int id, double salary);
+
+    // 删除一名员工
+    void remove(int id);
+
+    // 员工人数
+    int count() const { return total; }
+
+    // 分位数（quantile 取 0~1），返回所在桶的下界（精确到 1 元）；没有员工时返回 0
+    double percentile(double quantile) const;
+
+    // 工资低于 salary 的人数
+    int countBelow(double salary) const;
+
+    // 工资高于 salary 的人数
+    int countAbove(double salary) const;
+
+    // 查询员工的当前工资，不存在时返回 false
+    bool salaryOf(int id, double& salary) const;
+
+    // 桶宽（元）和桶数量：覆盖 0 ~ 1048575 元，更高的工资计入最后一个桶
+    static const int BucketCount = 1 << 20;
+
+private:
+    // 工资所在的桶
+    static int bucketOf(double salary);
+
+    // 第 bucket 个桶的人数加 delta
+    void add(int bucket, int delta);
+
+    // 前 bucket 个桶（不含 bucket）的人数之和
+    int prefix(int bucket) const;
+
+    // 第 k 小（从 1 开始）的工资所在的桶
+    int kth(int k) const;
+
+    // 树状数组，下标从 1 开始
+    std::vector<int> tree;
+
+    // 每名员工的当前工资
+    QHash<int, double> salaries;
+
+    int total = 0;
+};
+
+#endif // SALARYRANKINDEX_H
@@ -0,0 +1,66 @@
+﻿#include "salarystatspanel.h"
+#include "salaryrankindex.h"  // 顺序统计索引
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+
+// SalaryStatsPanel 构造函数，创建界面
+SalaryStatsPanel::SalaryStatsPanel(QWidget* parent)
+    : QWidget(parent)
+    , percentiles(new QLabel(this))
+    , rankInput(new QLineEdit(this))
+    , rankResult(new QLabel(this))
+{
+    rankInput->setPlaceholderText(QString::fromLocal8Bit("员工ID"));
+    rankInput->setMaximumWidth(100);
+
+    QHBoxLayout* layout = new QHBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(percentiles);
+    layout->addStretch();
+    layout->addWidget(new QLabel(QString::fromLocal8Bit("工资排名"), this));
+    layout->addWidget(rankInput);
+    layout->addWidget(rankResult);
+
+    connect(rankInput, &QLineEdit::textChanged, this, &SalaryStatsPanel::refresh);
+    refresh();
+}
+
+// 设置顺序统计索引
+void SalaryStatsPanel::setIndex(const std::shared_ptr<SalaryRankIndex>& value)
+{
+    index = value;
+    refresh();
+}
+
+// 重新计算分位数和排名
+void SalaryStatsPanel::refresh()
+{
+    if (!index)
+    {
+        percentiles->setText(QString::fromLocal8Bit("统计数据加载中..."));
+        rankResult->clear();
+        return;
+    }
+
+    percentiles->setText(QString::fromLocal8Bit("工资中位数 %1    P90 %2    P99 %3")
+        .arg(index->percentile(0.50), 0, 'f', 0)
+        .arg(index->percentile(0.90), 0, 'f', 0)
+        .arg(index->percentile(0.99), 0, 'f', 0));
+
+    // 排名：工资高于该员工的人数 + 1，同时给出低于该员工的人数占比
+    bool ok = false;
+    int id = rankInput->text().toInt(&ok);
+    double salary = 0;
+    if (!ok || !index->salaryOf(id, salary))
+    {
+        rankResult->setText(rankInput->text().isEmpty() ? QString() : QString::fromLocal8Bit("无此员工"));
+        return;
+    }
+
+    int count = index->count();
+    int rank = index->countAbove(salary) + 1;
+    double belowShare = count > 0 ? 100.0 * index->countBelow(salary) / count : 0;
+    rankResult->setText(QString::fromLocal8Bit("第 %1 / %2 名，高于 %3% 的员工")
+        .arg(rank).arg(count).arg(belowShare, 0, 'f', 1));
+}
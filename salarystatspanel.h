@@ -0,0 +1,39 @@
+﻿#ifndef SALARYSTATSPANEL_H
+#define SALARYSTATSPANEL_H
+
+#include <QWidget>
+#include <memory>
+
+class QLabel;
+class QLineEdit;
+class SalaryRankIndex;
+
+// SalaryStatsPanel 类显示工资的中位数、P90、P99，并可以查询某名员工的工资排名
+// 所有数值都来自 SalaryRankIndex，每次查询为 O(log n)，员工数据变化后随时刷新
+class SalaryStatsPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit SalaryStatsPanel(QWidget* parent = nullptr);
+
+    // 设置使用的顺序统计索引（为空时显示“统计数据加载中”）
+    void setIndex(const std::shared_ptr<SalaryRankIndex>& index);
+
+public slots:
+    // 重新计算分位数和当前查询员工的排名
+    void refresh();
+
+private:
+    // 顺序统计索引
+    std::shared_ptr<SalaryRankIndex> index;
+
+    // 分位数文字
+    QLabel* percentiles;
+
+    // 排名查询的员工 ID 输入框和结果
+    QLineEdit* rankInput;
+    QLabel* rankResult;
+};
+
+#endif // SALARYSTATSPANEL_H
@@ -0,0 +1,290 @@
+﻿#include "scenariobenchmark.h"
+#include "employeestore.h"     // 员工数据存储
+#include "wagestax.h"          // 主窗口渲染
+#include "ui_wagestax.h"
+#include "databasepreloader.h" // 窗口数据加载
+#include "metricsregistry.h"   // 延迟直方图
+#include <QApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+namespace
+{
+    // 常见姓氏（拼音），越靠前越常见
+    const char* const Surnames[] = {
+        "Wang", "Li", "Zhang", "Liu", "Chen", "Yang", "Huang", "Zhao", "Wu", "Zhou",
+        "Xu", "Sun", "Ma", "Zhu", "Hu", "Guo", "He", "Gao", "Lin", "Luo",
+        "Zheng", "Liang", "Xie", "Song", "Tang", "Han", "Feng", "Deng", "Cao", "Peng",
+        "Zeng", "Xiao", "Tian", "Dong", "Pan", "Yuan", "Cai", "Jiang", "Yu", "Du"
+    };
+
+    // 常见名字用字（拼音），名字由一到两个字组成
+    const char* const GivenNames[] = {
+        "Wei", "Fang", "Na", "Min", "Jing", "Li", "Qiang", "Lei", "Jun", "Yang",
+        "Yong", "Yan", "Jie", "Tao", "Ming", "Chao", "Xiu", "Xia", "Ping", "Gang",
+        "Hui", "Hua", "Yu", "Hong", "Ling", "Bin", "Peng", "Hao", "Xin", "Ying"
+    };
+
+    // 高管所占比例
+    const double ExecutiveRatio = 0.005;
+
+    // 基准测试期间丢弃调试输出，showResult 每行都会打印日志，不应计入耗时
+    void quietMessageHandler(QtMsgType type, const QMessageLogContext&, const QString& message)
+    {
+        if (type == QtDebugMsg || type == QtInfoMsg)
+        {
+            return;
+        }
+        fprintf(stderr, "%s\n", message.toLocal8Bit().constData());
+    }
+
+    // 取命令行选项的值
+    QString option(const QStringList& arguments, const QString& name, const QString& fallback)
+    {
+        int index = arguments.indexOf(name);
+        return index >= 0 && index + 1 < arguments.size() ? arguments.at(index + 1) : fallback;
+    }
+
+    // 直方图摘要，单位毫秒
+    QJsonObject summarize(const MetricsHistogram& histogram)
+    {
+        QJsonObject object;
+        quint64 count = histogram.count();
+        object["count"] = double(count);
+        object["mean_ms"] = count ? double(histogram.sumValue()) / count / 1e6 : 0.0;
+        object["p50_ms"] = histogram.percentile(0.50) / 1e6;
+        object["p99_ms"] = histogram.percentile(0.99) / 1e6;
+        object["max_ms"] = histogram.maxValue() / 1e6;
+        return object;
+    }
+
+    // 单次计时的结果，单位毫秒
+    QJsonObject single(qint64 elapsedNs, qint64 rows)
+    {
+        QJsonObject object;
+        object["ms"] = elapsedNs / 1e6;
+        object["rows"] = double(rows);
+        return object;
+    }
+
+    // 运行一个规模的全部场景
+    QJsonObject runScenario(int size, int renderLimit, quint32 seed)
+    {
+        QJsonObject scenario;
+        scenario["employees"] = size;
+        std::mt19937 random(seed ^ quint32(size));
+
+        auto workforce = ScenarioBenchmark::generateWorkforce(size, seed);
+
+        // 基准测试使用独立的连接，与窗口的默认连接互不干扰；每个规模从空表开始
+        std::unique_ptr<EmployeeStore> bench = EmployeeStore::create("wagestax_benchmark");
+        bench->open();
+        bench->clear();
+
+        QElapsedTimer timer;
+
+        // 批量插入
+        timer.start();
+        int inserted = bench->addEmployees(workforce);
+        scenario["bulk_insert"] = single(timer.nsecsElapsed(), inserted);
+
+        // 全表查询
+        timer.restart();
+        auto all = bench->queryEmployees();
+        scenario["query_all"] = single(timer.nsecsElapsed(), qint64(all.size()));
+
+        // 按姓名搜索：随机挑选已存在的姓名
+        MetricsHistogram search;
+        qint64 matched = 0;
+        std::uniform_int_distribution<int> pick(0, qMax(0, size - 1));
+        for (int i = 0; i < 100 && size > 0; ++i)
+        {
+            const QString& name = workforce[size_t(pick(random))].first;
+            ScopedLatency latency(search);
+            matched += qint64(bench->queryEmployeeByIdOrName(-1, name).size());
+        }
+        QJsonObject searchResult = summarize(search);
+        searchResult["rows"] = double(matched);
+        scenario["name_search"] = searchResult;
+
+        // 排序和范围查询：工资 8000-12000，按税额降序取前 1000 名
+        EmployeeQuery spec;
+        spec.salary.minimum = 8000;
+        spec.salary.maximum = 12000;
+        spec.sortKey = EmployeeQuery::ByTax;
+        spec.descending = true;
+        timer.restart();
+        auto sorted = bench->queryEmployees(spec);
+        int sortedTotal = bench->countEmployees(spec);
+        QJsonObject sortedResult = single(timer.nsecsElapsed(), qint64(sorted.size()));
+        sortedResult["matched"] = sortedTotal;
+        scenario["sorted_range"] = sortedResult;
+
+        // 修改工资并重新计税
+        MetricsHistogram update;
+        std::uniform_real_distribution<double> raise(0.95, 1.15);
+        for (int i = 0; i < 200 && size > 0; ++i)
+        {
+            int index = pick(random);
+            ScopedLatency latency(update);
+            bench->updateEmployee(index + 1, workforce[size_t(index)].first, workforce[size_t(index)].second * raise(random));
+        }
+        scenario["update_recompute"] = summarize(update);
+        bench->close();
+
+        // 窗口数据就绪：从创建窗口到后台加载完成、列表可操作
+        {
+            timer.restart();
+            DatabasePreloader preloader;
+            preloader.start();
+            WagesTax window(nullptr, &preloader);
+            window.show();
+            while (!window.ui->centralwidget->isEnabled())
+            {
+                QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 50);
+            }
+            scenario["window_ready"] = single(timer.nsecsElapsed(), window.ui->listWidget->count());
+
+            // 边输入边搜索：逐字输入姓名，每个按键计时（过滤加渲染）
+            MetricsHistogram keystroke;
+            for (int i = 0; i < 20 && size > 0; ++i)
+            {
+                const QString& name = workforce[size_t(pick(random))].first;
+                for (int length = 1; length <= name.size(); ++length)
+                {
+                    window.ui->query_edit_6->setText(name.left(length));
+                    ScopedLatency latency(keystroke);
+                    window.applySearch();
+                    QCoreApplication::processEvents();
+                }
+            }
+            scenario["search_as_you_type"] = summarize(keystroke);
+            window.ui->query_edit_6->clear();
+
+            // 渲染：每行一个控件，超出上限的部分不渲染，避免百万行时耗尽内存
+            std::vector<std::pair<int, QString>> rows(all.begin(), all.begin() + qMin<size_t>(all.size(), size_t(renderLimit)));
+            timer.restart();
+            window.showResult(rows);
+            QCoreApplication::processEvents();
+            scenario["render"] = single(timer.nsecsElapsed(), window.ui->listWidget->count());
+
+            window.sql->close();
+        }
+
+        qWarning().noquote() << QString("benchmark %1 employees done").arg(size);
+        return scenario;
+    }
+}
+
+// 命令行是否请求基准测试
+bool ScenarioBenchmark::isRequested(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--benchmark") == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 生成模拟员工
+std::vector<std::pair<QString, double>> ScenarioBenchmark::generateWorkforce(int count, quint32 seed)
+{
+    std::mt19937 random(seed);
+
+    // 姓氏按 1/k 加权（类 Zipf 分布），名字用字均匀选取
+    std::vector<double> weights;
+    for (size_t k = 0; k < sizeof(Surnames) / sizeof(Surnames[0]); ++k)
+    {
+        weights.push_back(1.0 / double(k + 1));
+    }
+    std::discrete_distribution<int> surname(weights.begin(), weights.end());
+    std::uniform_int_distribution<int> given(0, int(sizeof(GivenNames) / sizeof(GivenNames[0])) - 1);
+    std::bernoulli_distribution twoCharacters(0.7);
+
+    // 工资：对数正态分布，中位数 8000，最低 2000；少数高管 5 万 ~ 20 万
+    std::lognormal_distribution<double> salary(std::log(8000.0), 0.5);
+    std::bernoulli_distribution executive(ExecutiveRatio);
+    std::uniform_real_distribution<double> executiveSalary(50000.0, 200000.0);
+
+    std::vector<std::pair<QString, double>> employees;
+    employees.reserve(size_t(qMax(0, count)));
+    for (int i = 0; i < count; ++i)
+    {
+        QString name = QLatin1String(Surnames[surname(random)]) + ' ' + QLatin1String(GivenNames[given(random)]);
+        if (twoCharacters(random))
+        {
+            name += QString(GivenNames[given(random)]).toLower();
+        }
+
+        double pay = executive(random) ? executiveSalary(random) : qMax(2000.0, salary(random));
+        employees.emplace_back(name, std::round(pay * 100.0) / 100.0);
+    }
+    return employees;
+}
+
+// 执行基准测试
+int ScenarioBenchmark::run(const QStringList& arguments)
+{
+    QString databasePath = option(arguments, "--db", "bench_tax_system.db");
+    QString outputPath = option(arguments, "--output", "benchmark.json");
+    int renderLimit = option(arguments, "--render-limit", "100000").toInt();
+    quint32 seed = option(arguments, "--seed", "20240601").toUInt();
+
+    std::vector<int> sizes;
+    for (const QString& text : option(arguments, "--sizes", "10000,100000,1000000").split(',', QString::SkipEmptyParts))
+    {
+        sizes.push_back(text.toInt());
+    }
+
+    // 文件后端使用临时数据库，绝不清空正式数据库
+    if (EmployeeStore::backend() == EmployeeStore::SqliteFile)
+    {
+        if (databasePath == EmployeeStore::path())
+        {
+            qWarning() << "Refusing to run the benchmark against the production database" << databasePath;
+            return 1;
+        }
+        EmployeeStore::configure(EmployeeStore::SqliteFile, databasePath);
+    }
+
+    QtMessageHandler previousHandler = qInstallMessageHandler(quietMessageHandler);
+
+    QJsonArray scenarios;
+    for (int size : sizes)
+    {
+        scenarios.append(runScenario(size, renderLimit, seed));
+    }
+
+    qInstallMessageHandler(previousHandler);
+
+    QJsonObject root;
+    root["qt_version"] = QT_VERSION_STR;
+    root["platform"] = QGuiApplication::platformName();
+    root["os"] = QSysInfo::prettyProductName();
+    root["seed"] = double(seed);
+    root["render_limit"] = renderLimit;
+    root["storage"] = EmployeeStore::backendName();
+    root["database"] = EmployeeStore::backend() == EmployeeStore::SqliteFile ? databasePath : QString();
+    root["scenarios"] = scenarios;
+
+    QFile file(outputPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qWarning() << "Failed to write benchmark results to" << outputPath;
+        return 1;
+    }
+    file.write(QJsonDocument(root).toJson());
+    qDebug() << "Benchmark results written to" << outputPath;
+    return 0;
+}
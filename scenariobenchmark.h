@@ -0,0 +1,31 @@
+﻿#ifndef SCENARIOBENCHMARK_H
+#define SCENARIOBENCHMARK_H
+
+#include <QString>
+#include <QStringList>
+#include <utility>
+#include <vector>
+
+// ScenarioBenchmark 类是端到端场景基准测试
+// 按给定规模生成模拟员工数据写入临时数据库，然后对真实流程计时：
+// 批量插入、全表查询、按姓名搜索、修改并重新计税、窗口数据就绪以及 WagesTax::showResult 渲染。
+// 结果写入 JSON 文件，便于在数据量增长之前发现性能拐点。
+//
+// 用法：WagesTax --benchmark [--sizes 10000,100000,1000000] [--db bench_tax_system.db]
+//                            [--output benchmark.json] [--render-limit 100000] [--seed 20240601]
+//                            [--storage sqlite|memory|columnar]
+class ScenarioBenchmark
+{
+public:
+    // 命令行是否请求基准测试（在创建 QApplication 之前调用，用于切换到 offscreen 平台）
+    static bool isRequested(int argc, char* argv[]);
+
+    // 执行基准测试，需要已经创建 QApplication，返回进程退出码
+    static int run(const QStringList& arguments);
+
+    // 生成 count 名模拟员工，相同的 seed 生成相同的数据
+    // 姓氏按常见程度加权，工资服从对数正态分布（中位数约 8000），少数为高管薪资
+    static std::vector<std::pair<QString, double>> generateWorkforce(int count, quint32 seed);
+};
+
+#endif // SCENARIOBENCHMARK_H
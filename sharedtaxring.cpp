@@ -0,0 +1,469 @@
+﻿#include "sharedtaxring.h"
+#include "taxcalccenter.h"  // 批量计税
+#include "tracerecorder.h"  // 时间线区间
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <csignal>
+#include <cstring>
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <cerrno>
+#include <signal.h>
+#endif
+
+namespace
+{
+    // 槽位描述区的起始偏移
+    const int SlotTableOffset = sizeof(SharedTaxRing::Header);
+
+    // 数据区起始偏移，按 64 字节对齐
+    int dataOffset(int slotCount)
+    {
+        return SlotTableOffset + slotCount * int(sizeof(SharedTaxRing::Slot));
+    }
+
+    // 第 i 个槽位完成信号量的名称
+    QString doneKey(const QString& key, int index)
+    {
+        return QString("%1_done_%2").arg(key).arg(index);
+    }
+
+    // 客户端检查计算进程是否存活的间隔
+    const int MonitorIntervalMs = 500;
+
+#ifdef Q_OS_WIN
+    // 正在运行处理循环的计算引擎，供控制台事件回调调用 stop()
+    std::atomic<SharedTaxEngine*> activeEngine(nullptr);
+
+    // 控制台 Ctrl+C / 关闭事件在单独的线程中回调，不是信号处理函数，可以直接调用 stop()
+    BOOL WINAPI onConsoleControl(DWORD)
+    {
+        SharedTaxEngine* engine = activeEngine.load();
+        if (engine)
+        {
+            engine->stop();
+            return TRUE;
+        }
+        return FALSE;
+    }
+#else
+    // 收到 SIGINT / SIGTERM 后置位，由 run() 中的监视线程读取
+    // 无锁的 std::atomic 既可以在信号处理函数中写，也可以跨线程读
+    std::atomic<bool> stopRequested(false);
+
+    // 监视线程检查 stopRequested 的间隔
+    const int SignalPollIntervalMs = 100;
+
+    // SIGINT / SIGTERM：信号处理函数中只能做异步信号安全的操作，这里只写标志
+    // stop() 里的 QSystemSemaphore::release 会加锁、可能分配内存，不能在这里调用
+    void onStopSignal(int)
+    {
+        stopRequested.store(true);
+    }
+#endif
+
+    // 进程是否存在
+    bool processExists(quint32 pid)
+    {
+        if (pid == 0)
+        {
+            return true;  // 未记录 PID，无法判断时视为存活
+        }
+#ifdef Q_OS_WIN
+        HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, DWORD(pid));
+        if (!process)
+        {
+            return GetLastError() == ERROR_ACCESS_DENIED;
+        }
+        const bool running = WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+        CloseHandle(process);
+        return running;
+#else
+        return ::kill(pid_t(pid), 0) == 0 || errno == EPERM;
+#endif
+    }
+}
+
+// 共享内存总大小
+int SharedTaxRing::segmentSize(int slotCount, int slotCapacity)
+{
+    return dataOffset(slotCount) + slotCount * slotCapacity * int(sizeof(double));
+}
+
+// SharedTaxEngine 构造函数
+SharedTaxEngine::SharedTaxEngine(const QString& key, int slotCount, int slotCapacity)
+    : key(key)
+    , slotCount(slotCount)
+    , slotCapacity(slotCapacity)
+    , memory(key)
+    , stopping(false)
+{
+
+}
+
+// SharedTaxEngine 析构函数
+SharedTaxEngine::~SharedTaxEngine()
+{
+    if (memory.isAttached())
+    {
+        // 通知仍在等待的客户端计算进程已经退出
+        SharedTaxRing::Header* header = static_cast<SharedTaxRing::Header*>(memory.data());
+        header->shutdown.storeRelease(1);
+        if (freeSlots)
+        {
+            freeSlots->release(slotCount);
+        }
+
+        // 已提交但没有处理的槽位不会再完成，唤醒等待它们的客户端
+        for (const std::unique_ptr<QSystemSemaphore>& done : doneSlots)
+        {
+            done->release();
+        }
+        memory.detach();
+    }
+}
+
+// 创建共享内存和信号量
+bool SharedTaxEngine::create()
+{
+    static_assert(sizeof(SharedTaxRing::Header) == 64, "header must occupy one cache line");
+    static_assert(sizeof(SharedTaxRing::Slot) == 64, "slot must occupy one cache line");
+
+    // 上次异常退出时可能遗留同名共享内存，先附加再断开让系统回收
+    if (memory.attach())
+    {
+        memory.detach();
+    }
+
+    if (!memory.create(SharedTaxRing::segmentSize(slotCount, slotCapacity)))
+    {
+        qDebug() << "Failed to create shared memory" << key << ":" << memory.errorString();
+        return false;
+    }
+
+    // 初始化头部和槽位描述
+    char* base = static_cast<char*>(memory.data());
+    std::memset(base, 0, dataOffset(slotCount));
+    SharedTaxRing::Header* header = reinterpret_cast<SharedTaxRing::Header*>(base);
+    header->magic = SharedTaxRing::Magic;
+    header->version = SharedTaxRing::Version;
+    header->slotCount = quint32(slotCount);
+    header->slotCapacity = quint32(slotCapacity);
+    header->enginePid = quint32(QCoreApplication::applicationPid());
+
+    // 创建信号量（Create 会重置上次遗留的计数）
+    freeSlots.reset(new QSystemSemaphore(key + "_free", slotCount, QSystemSemaphore::Create));
+    readySlots.reset(new QSystemSemaphore(key + "_ready", 0, QSystemSemaphore::Create));
+    for (int i = 0; i < slotCount; ++i)
+    {
+        doneSlots.emplace_back(new QSystemSemaphore(doneKey(key, i), 0, QSystemSemaphore::Create));
+    }
+
+    qDebug() << "Shared tax ring" << key << "created:" << slotCount << "slots x" << slotCapacity << "salaries.";
+    return true;
+}
+
+// 处理循环：等待提交的槽位，原地计算后通知对应客户端
+void SharedTaxEngine::run()
+{
+    char* base = static_cast<char*>(memory.data());
+    SharedTaxRing::Slot* slots = reinterpret_cast<SharedTaxRing::Slot*>(base + SlotTableOffset);
+    double* data = reinterpret_cast<double*>(base + dataOffset(slotCount));
+
+    // 运行期间 Ctrl+C / SIGTERM 请求处理循环退出，析构函数随后通知客户端
+#ifdef Q_OS_WIN
+    activeEngine.store(this);
+    SetConsoleCtrlHandler(onConsoleControl, TRUE);
+#else
+    stopRequested.store(false);
+    auto previousInterrupt = std::signal(SIGINT, onStopSignal);
+    auto previousTerminate = std::signal(SIGTERM, onStopSignal);
+
+    // 信号处理函数只置位标志，由这个普通线程发现后调用 stop() 唤醒处理循环
+    std::atomic<bool> watching(true);
+    std::unique_ptr<QThread> signalWatcher(QThread::create([this, &watching]() {
+        while (watching.load())
+        {
+            if (stopRequested.load())
+            {
+                stop();
+                return;
+            }
+            QThread::msleep(SignalPollIntervalMs);
+        }
+    }));
+    signalWatcher->start();
+#endif
+
+    // 从上次处理的位置之后开始扫描，保证各槽位大致按提交顺序处理
+    int cursor = 0;
+    while (!stopping.load())
+    {
+        if (!readySlots->acquire())
+        {
+            qDebug() << "Shared tax ring wait failed:" << readySlots->errorString();
+            break;
+        }
+        if (stopping.load())
+        {
+            break;
+        }
+
+        // 每次 acquire 对应一个已提交的槽位，找到它
+        for (int scanned = 0; scanned < slotCount; ++scanned)
+        {
+            int index = (cursor + scanned) % slotCount;
+            SharedTaxRing::Slot& slot = slots[index];
+            if (slot.state.loadAcquire() != SharedTaxRing::Submitted)
+            {
+                continue;
+            }
+
+            TraceSpan span("SharedTaxEngine::processSlot", "worker");
+
+            // 工资原地替换为税额
+            double* values = data + size_t(index) * size_t(slotCapacity);
+            int count = qMin(int(slot.count), slotCapacity);
+            TaxCalcCenter::calculateTaxBatch(values, values, count);
+
+            slot.state.storeRelease(SharedTaxRing::Done);
+            doneSlots[index]->release();
+            cursor = index + 1;
+            break;
+        }
+    }
+
+#ifdef Q_OS_WIN
+    SetConsoleCtrlHandler(onConsoleControl, FALSE);
+    activeEngine.store(nullptr);
+#else
+    watching.store(false);
+    signalWatcher->wait();
+    std::signal(SIGINT, previousInterrupt);
+    std::signal(SIGTERM, previousTerminate);
+#endif
+    qDebug() << "Shared tax ring" << key << "stopped.";
+}
+
+// 请求处理循环退出
+void SharedTaxEngine::stop()
+{
+    stopping.store(true);
+    if (readySlots)
+    {
+        readySlots->release();  // 唤醒正在等待的处理循环
+    }
+}
+
+// SharedTaxClient 构造函数
+SharedTaxClient::SharedTaxClient(const QString& key)
+    : key(key)
+    , memory(key)
+    , closing(false)
+    , engineLost(false)
+{
+
+}
+
+// SharedTaxClient 析构函数
+SharedTaxClient::~SharedTaxClient()
+{
+    if (monitor)
+    {
+        closing.store(true);
+        monitor->wait();
+    }
+    if (memory.isAttached())
+    {
+        memory.detach();
+    }
+}
+
+// 附加到共享内存并打开信号量
+bool SharedTaxClient::attach()
+{
+    if (!memory.attach())
+    {
+        qDebug() << "Failed to attach shared memory" << key << ":" << memory.errorString();
+        return false;
+    }
+
+    header = static_cast<SharedTaxRing::Header*>(memory.data());
+    if (header->magic != SharedTaxRing::Magic || header->version != SharedTaxRing::Version)
+    {
+        qDebug() << "Shared memory" << key << "has an incompatible layout.";
+        memory.detach();
+        header = nullptr;
+        return false;
+    }
+
+    freeSlots.reset(new QSystemSemaphore(key + "_free", 0, QSystemSemaphore::Open));
+    readySlots.reset(new QSystemSemaphore(key + "_ready", 0, QSystemSemaphore::Open));
+    for (quint32 i = 0; i < header->slotCount; ++i)
+    {
+        doneSlots.emplace_back(new QSystemSemaphore(doneKey(key, int(i)), 0, QSystemSemaphore::Open));
+    }
+
+    monitor.reset(QThread::create([this]() { monitorEngine(); }));
+    monitor->start();
+    return true;
+}
+
+// 计算进程是否仍在运行
+bool SharedTaxClient::engineAlive() const
+{
+    return header && !engineLost.load() && !header->shutdown.loadAcquire() && processExists(header->enginePid);
+}
+
+// 存活检查：计算进程被强制结束时不会设置 shutdown，也不会释放信号量，
+// 由客户端代为释放，让本进程中阻塞在 acquire / wait 的调用返回并看到 engineLost
+void SharedTaxClient::monitorEngine()
+{
+    int elapsedMs = 0;
+    while (!closing.load())
+    {
+        QThread::msleep(50);
+        elapsedMs += 50;
+        if (elapsedMs < MonitorIntervalMs)
+        {
+            continue;
+        }
+        elapsedMs = 0;
+
+        if (!engineAlive())
+        {
+            engineLost.store(true);
+            qDebug() << "Shared tax engine" << key << "is no longer running.";
+            freeSlots->release(int(header->slotCount));
+            for (const std::unique_ptr<QSystemSemaphore>& done : doneSlots)
+            {
+                done->release();
+            }
+            return;
+        }
+    }
+}
+
+// 每个槽位的容量
+int SharedTaxClient::slotCapacity() const
+{
+    return header ? int(header->slotCapacity) : 0;
+}
+
+// 槽位描述地址
+SharedTaxRing::Slot* SharedTaxClient::slot(int slotIndex) const
+{
+    char* base = reinterpret_cast<char*>(header);
+    return reinterpret_cast<SharedTaxRing::Slot*>(base + SlotTableOffset) + slotIndex;
+}
+
+// 槽位数据区地址
+double* SharedTaxClient::slotData(int slotIndex) const
+{
+    char* base = reinterpret_cast<char*>(header);
+    double* data = reinterpret_cast<double*>(base + dataOffset(int(header->slotCount)));
+    return data + size_t(slotIndex) * header->slotCapacity;
+}
+
+// 申请空闲槽位
+double* SharedTaxClient::acquire(int& slotIndex)
+{
+    if (!header || !freeSlots->acquire() || header->shutdown.loadAcquire() || engineLost.load())
+    {
+        return nullptr;
+    }
+
+    // 信号量保证至少有一个空闲槽位，用 CAS 抢占它（多个客户端可能同时申请）
+    for (;;)
+    {
+        for (quint32 i = 0; i < header->slotCount; ++i)
+        {
+            if (slot(int(i))->state.testAndSetAcquire(SharedTaxRing::Free, SharedTaxRing::Claimed))
+            {
+                slotIndex = int(i);
+                return slotData(slotIndex);
+            }
+        }
+    }
+}
+
+// 提交槽位
+void SharedTaxClient::submit(int slotIndex, int count)
+{
+    SharedTaxRing::Slot* target = slot(slotIndex);
+    target->count = quint32(qBound(0, count, slotCapacity()));
+    target->state.storeRelease(SharedTaxRing::Submitted);
+    readySlots->release();
+}
+
+// 等待槽位计算完成
+double* SharedTaxClient::wait(int slotIndex)
+{
+    // 被计算进程退出唤醒时槽位不是 Done 状态
+    if (!doneSlots[slotIndex]->acquire() || slot(slotIndex)->state.loadAcquire() != SharedTaxRing::Done)
+    {
+        return nullptr;
+    }
+    return slotData(slotIndex);
+}
+
+// 归还槽位
+void SharedTaxClient::release(int slotIndex)
+{
+    slot(slotIndex)->state.storeRelease(SharedTaxRing::Free);
+    freeSlots->release();
+}
+
+// 压测：以槽位容量为批次大小反复提交
+int SharedTaxClient::runLoad(const QString& key, qint64 salaries)
+{
+    SharedTaxClient client(key);
+    if (!client.attach())
+    {
+        return -1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    qint64 remaining = salaries;
+    double checksum = 0;
+    while (remaining > 0)
+    {
+        int slotIndex = 0;
+        double* values = client.acquire(slotIndex);
+        if (!values)
+        {
+            qDebug() << "Shared tax engine is not running.";
+            return -1;
+        }
+
+        int count = int(qMin<qint64>(remaining, client.slotCapacity()));
+        for (int i = 0; i < count; ++i)
+        {
+            values[i] = 3000.0 + double((remaining - i) % 50000);
+        }
+        client.submit(slotIndex, count);
+
+        double* taxes = client.wait(slotIndex);
+        if (!taxes)
+        {
+            qDebug() << "Shared tax engine stopped before the batch completed.";
+            return -1;
+        }
+        checksum += taxes[0];
+        client.release(slotIndex);
+
+        remaining -= count;
+    }
+
+    const double seconds = timer.nsecsElapsed() / 1e9;
+    qDebug() << "Shared memory load finished:"
+        << "salaries" << salaries
+        << "seconds" << seconds
+        << "salaries/s" << (seconds > 0 ? qint64(salaries / seconds) : 0)
+        << "checksum" << checksum;
+    return 0;
+}
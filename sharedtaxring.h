@@ -0,0 +1,172 @@
+﻿#ifndef SHAREDTAXRING_H
+#define SHAREDTAXRING_H
+
+// 共享内存与跨进程信号量
+#include <QSharedMemory>
+#include <QSystemSemaphore>
+#include <QAtomicInt>
+#include <QString>
+#include <QThread>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// SharedTaxRing 命名空间描述同机进程之间批量计税使用的共享内存布局
+// 共享内存由若干个槽位组成，每个槽位是一段连续的 double 数组：
+// 客户端直接把工资写进槽位，计算进程用批量算法原地把工资替换为税额，
+// 双方都不做序列化，也不复制数据
+//
+// 内存布局：
+//   [Header 64 字节][Slot 描述 64 字节 × slotCount][数据区 slotCapacity × 8 字节 × slotCount]
+//
+// 同步方式：
+//   - <key>_free：空闲槽位数量，客户端申请槽位前先获取
+//   - <key>_ready：已提交待计算的槽位数量，计算进程等待它
+//   - <key>_done_<i>：第 i 个槽位计算完成，由提交该槽位的客户端等待
+//
+// 退出与存活检查：
+//   - 计算进程收到 Ctrl+C / SIGTERM 时停止处理循环，析构时设置 shutdown 并唤醒所有等待中的客户端；
+//   - 头部记录计算进程的 PID，客户端在后台每隔一段时间检查该进程是否还在，
+//     计算进程异常退出（没有机会设置 shutdown）时由客户端自己唤醒等待中的调用，不会永久阻塞
+namespace SharedTaxRing
+{
+    // 共享内存头部的魔数和版本号，用于校验附加到的是同一种布局
+    const quint32 Magic = 0x57545852;  // "WTXR"
+    const quint32 Version = 2;
+
+    // 槽位状态
+    enum SlotState
+    {
+        Free = 0,       // 空闲，可以被客户端申请
+        Claimed = 1,    // 已被客户端申请，正在写入工资
+        Submitted = 2,  // 已提交，等待计算进程处理
+        Done = 3        // 计算完成，结果在数据区中
+    };
+
+    // 共享内存头部
+    struct Header
+    {
+        quint32 magic;
+        quint32 version;
+        quint32 slotCount;
+        quint32 slotCapacity;
+        QBasicAtomicInt shutdown;  // 非 0 表示计算进程正在退出
+        quint32 enginePid;         // 计算进程的 PID，客户端据此检查它是否存活
+        quint32 reserved[10];
+    };
+
+    // 槽位描述，独占一条缓存行，避免不同槽位之间的伪共享
+    struct Slot
+    {
+        QBasicAtomicInt state;  // SlotState
+        quint32 count;          // 本次提交的工资个数
+        quint32 reserved[14];
+    };
+
+    // 根据槽位数量和容量计算共享内存总大小
+    int segmentSize(int slotCount, int slotCapacity);
+}
+
+// SharedTaxEngine 类运行在计税进程中，创建共享内存并循环处理客户端提交的槽位
+class SharedTaxEngine
+{
+public:
+    // 构造函数
+    // 参数:
+    //   - key: 共享内存和信号量的名称前缀
+    //   - slotCount: 槽位数量，即可以同时在途的批次数
+    //   - slotCapacity: 每个槽位最多容纳的工资个数
+    SharedTaxEngine(const QString& key, int slotCount, int slotCapacity);
+
+    // 析构函数，通知客户端并释放共享内存
+    ~SharedTaxEngine();
+
+    // 创建共享内存和信号量
+    bool create();
+
+    // 处理循环，直到 stop() 被调用；运行期间 Ctrl+C / SIGTERM 也会调用 stop()
+    // （信号处理函数只置位标志，由运行期间的监视线程调用 stop()）
+    void run();
+
+    // 请求处理循环退出（可以在其他线程中调用，不能在信号处理函数中调用）
+    void stop();
+
+private:
+    QString key;
+    int slotCount;
+    int slotCapacity;
+
+    QSharedMemory memory;
+    std::unique_ptr<QSystemSemaphore> freeSlots;
+    std::unique_ptr<QSystemSemaphore> readySlots;
+    std::vector<std::unique_ptr<QSystemSemaphore>> doneSlots;
+
+    // 处理循环是否应当退出
+    std::atomic<bool> stopping;
+};
+
+// SharedTaxClient 类供同机的工资处理进程使用，附加到计税进程创建的共享内存
+// 用法：acquire() 得到槽位并直接写入工资 → submit() → wait() 后在同一块内存读取税额 → release()
+class SharedTaxClient
+{
+public:
+    // 构造函数，参数 key 与计税进程一致
+    explicit SharedTaxClient(const QString& key);
+
+    // 析构函数，断开共享内存
+    ~SharedTaxClient();
+
+    // 附加到共享内存并打开信号量
+    bool attach();
+
+    // 每个槽位最多容纳的工资个数
+    int slotCapacity() const;
+
+    // 申请一个空闲槽位（无空闲时阻塞）
+    // 参数:
+    //   - slotIndex: 输出，申请到的槽位序号
+    // 返回值：槽位数据区的指针，客户端直接在其中写入工资；计算进程已退出时返回 nullptr
+    double* acquire(int& slotIndex);
+
+    // 提交槽位中的前 count 个工资
+    void submit(int slotIndex, int count);
+
+    // 等待槽位计算完成，返回值为数据区指针，此时其中保存的是税额；
+    // 计算进程已退出、槽位没有算完时返回 nullptr
+    double* wait(int slotIndex);
+
+    // 计算进程是否仍在运行
+    bool engineAlive() const;
+
+    // 归还槽位
+    void release(int slotIndex);
+
+    // 压测：反复提交批次并打印吞吐量，返回进程退出码
+    static int runLoad(const QString& key, qint64 salaries);
+
+private:
+    // 槽位描述和数据区的地址
+    SharedTaxRing::Slot* slot(int slotIndex) const;
+    double* slotData(int slotIndex) const;
+
+    // 后台检查计算进程是否存活，发现它已退出时唤醒本进程中等待的调用
+    void monitorEngine();
+
+    QString key;
+    QSharedMemory memory;
+    SharedTaxRing::Header* header = nullptr;
+    std::unique_ptr<QSystemSemaphore> freeSlots;
+    std::unique_ptr<QSystemSemaphore> readySlots;
+    std::vector<std::unique_ptr<QSystemSemaphore>> doneSlots;
+
+    // 存活检查线程
+    std::unique_ptr<QThread> monitor;
+
+    // 客户端正在关闭，存活检查线程应当退出
+    std::atomic<bool> closing;
+
+    // 已发现计算进程退出
+    std::atomic<bool> engineLost;
+};
+
+#endif // SHAREDTAXRING_H
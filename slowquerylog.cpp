@@ -0,0 +1,226 @@
+﻿#include "slowquerylog.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QRegularExpression>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QTextStream>
+#include <QVariant>
+#include <algorithm>
+#include <vector>
+
+// 全局实例
+SlowQueryLog& SlowQueryLog::instance()
+{
+    static SlowQueryLog log;
+    return log;
+}
+
+// 构造函数，默认阈值 50 毫秒
+SlowQueryLog::SlowQueryLog()
+    : threshold(50)
+    , logPath("slow_query_log.txt")
+{
+
+}
+
+// 设置阈值
+void SlowQueryLog::setThresholdMs(double thresholdMs)
+{
+    QMutexLocker locker(&mutex);
+    threshold = thresholdMs;
+}
+
+// 读取阈值
+double SlowQueryLog::thresholdMs() const
+{
+    QMutexLocker locker(&mutex);
+    return threshold;
+}
+
+// 设置日志文件路径
+void SlowQueryLog::setLogPath(const QString& path)
+{
+    QMutexLocker locker(&mutex);
+    logPath = path;
+}
+
+// 归一化语句形状：字符串和数字字面量替换为 ?，命名参数也替换为 ?，空白合并为一个空格
+QString SlowQueryLog::shapeOf(const QString& sql)
+{
+    static const QRegularExpression stringLiteral("'(?:[^']|'')*'");
+    static const QRegularExpression numberLiteral("\\b\\d+(?:\\.\\d+)?\\b");
+    static const QRegularExpression namedParameter(":[A-Za-z_]\\w*");
+    static const QRegularExpression whitespace("\\s+");
+
+    QString shape = sql;
+    shape.replace(stringLiteral, "?");
+    shape.replace(numberLiteral, "?");
+    shape.replace(namedParameter, "?");
+    shape.replace(whitespace, " ");
+    return shape.trimmed();
+}
+
+// 记录一次执行
+void SlowQueryLog::record(const QSqlQuery& query, const QSqlDatabase& db, qint64 elapsedNs, int rows)
+{
+    const QString sql = query.lastQuery();
+    const QString shape = shapeOf(sql);
+
+    bool slow = false;
+    QString path;
+    {
+        QMutexLocker locker(&mutex);
+        ShapeStats& stats = shapes[shape];
+        stats.count++;
+        stats.totalNs += elapsedNs;
+        stats.maxNs = qMax(stats.maxNs, elapsedNs);
+        stats.rows += qMax(0, rows);
+
+        slow = elapsedNs >= qint64(threshold * 1e6);
+        if (slow)
+        {
+            stats.slowCount++;
+        }
+        path = logPath;
+    }
+
+    if (!slow)
+    {
+        return;
+    }
+
+    // 执行计划在锁外获取，避免阻塞其他线程的统计
+    QString plan = explain(query, db);
+    {
+        QMutexLocker locker(&mutex);
+        shapes[shape].lastPlan = plan;
+    }
+
+    // 绑定参数
+    QStringList parameters;
+    const QMap<QString, QVariant> bound = query.boundValues();
+    for (auto it = bound.constBegin(); it != bound.constEnd(); ++it)
+    {
+        parameters << QString("%1=%2").arg(it.key(), it.value().toString());
+    }
+
+    QFile logFile(path);
+    if (!logFile.open(QIODevice::Append | QIODevice::Text))
+    {
+        qDebug() << "Failed to open slow query log" << path;
+        return;
+    }
+
+    QTextStream out(&logFile);
+    out << QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss")
+        << " - SLOW QUERY " << QString::number(elapsedNs / 1e6, 'f', 3) << " ms, rows " << rows << "\n"
+        << "    sql: " << sql << "\n"
+        << "    params: " << parameters.join(", ") << "\n"
+        << "    plan:\n" << plan << "\n";
+}
+
+// 对语句执行 EXPLAIN QUERY PLAN，使用与原语句相同的连接
+// SQLite 生成的计划只取决于语句结构，与参数值无关，因此占位符全部绑定为 NULL，
+// 只需保证参数个数一致
+QString SlowQueryLog::explain(const QSqlQuery& query, const QSqlDatabase& db)
+{
+    const QString sql = query.lastQuery().trimmed();
+    if (sql.isEmpty() || sql.startsWith("EXPLAIN", Qt::CaseInsensitive))
+    {
+        return QString();
+    }
+
+    QSqlQuery plan(db);
+    if (!plan.prepare("EXPLAIN QUERY PLAN " + sql))
+    {
+        return "      (explain failed: " + plan.lastError().text() + ")\n";
+    }
+
+    const int parameterCount = query.boundValues().size();
+    for (int i = 0; i < parameterCount; ++i)
+    {
+        plan.addBindValue(QVariant());
+    }
+
+    if (!plan.exec())
+    {
+        return "      (explain failed: " + plan.lastError().text() + ")\n";
+    }
+
+    // 每行一个计划节点，detail 列是可读的描述（例如 SCAN employees）
+    QString text;
+    const int detailColumn = plan.record().indexOf("detail");
+    while (plan.next())
+    {
+        text += "      " + plan.value(detailColumn >= 0 ? detailColumn : plan.record().count() - 1).toString() + "\n";
+    }
+    return text;
+}
+
+// 汇总统计文本
+QString SlowQueryLog::toText() const
+{
+    QMutexLocker locker(&mutex);
+
+    std::vector<std::pair<QString, ShapeStats>> sorted(shapes.begin(), shapes.end());
+    std::sort(sorted.begin(), sorted.end(), [](const std::pair<QString, ShapeStats>& a, const std::pair<QString, ShapeStats>& b) {
+        return a.second.totalNs > b.second.totalNs;
+    });
+
+    QString text;
+    QTextStream out(&text);
+    out << QString("slow query threshold %1 ms\n").arg(threshold);
+    for (const auto& item : sorted)
+    {
+        const ShapeStats& stats = item.second;
+        out << item.first << "\n"
+            << QString("    count %1  slow %2  total %3 ms  mean %4 ms  max %5 ms  rows %6\n")
+            .arg(stats.count)
+            .arg(stats.slowCount)
+            .arg(stats.totalNs / 1e6, 0, 'f', 2)
+            .arg(stats.count ? stats.totalNs / 1e6 / stats.count : 0.0, 0, 'f', 3)
+            .arg(stats.maxNs / 1e6, 0, 'f', 3)
+            .arg(stats.rows);
+        if (!stats.lastPlan.isEmpty())
+        {
+            out << "    plan:\n" << stats.lastPlan;
+        }
+    }
+    out.flush();
+    return text;
+}
+
+// QueryProbe 构造函数，开始计时
+QueryProbe::QueryProbe(const QSqlQuery& query, const QSqlDatabase& db)
+    : query(query)
+    , db(db)
+{
+    timer.start();
+}
+
+// QueryProbe 析构函数，记录执行结果
+QueryProbe::~QueryProbe()
+{
+    finish();
+}
+
+// 记录执行结果
+void QueryProbe::finish()
+{
+    if (!timer.isValid())
+    {
+        return;
+    }
+    qint64 elapsed = timer.nsecsElapsed();
+    timer.invalidate();
+
+    if (!query.isActive() && query.lastError().isValid())
+    {
+        return;  // 执行失败的语句已经由调用方输出错误
+    }
+    SlowQueryLog::instance().record(query, db, elapsed, rows >= 0 ? rows : query.numRowsAffected());
+}
@@ -0,0 +1,88 @@
+﻿#ifndef SLOWQUERYLOG_H
+#define SLOWQUERYLOG_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+#include <map>
+
+class QSqlQuery;
+
+// SlowQueryLog 类对每条 SQL 语句计时，并按“语句形状”（去掉字面量、合并空白后的 SQL）汇总
+// 超过阈值的语句写入 slow_query_log.txt，记录绑定参数、行数以及 EXPLAIN QUERY PLAN 的输出，
+// 例如按姓名查询时计划中出现 “SCAN employees” 即说明发生了全表扫描
+class SlowQueryLog
+{
+public:
+    // 按语句形状汇总的统计
+    struct ShapeStats
+    {
+        quint64 count = 0;        // 执行次数
+        quint64 slowCount = 0;    // 超过阈值的次数
+        qint64 totalNs = 0;       // 总耗时
+        qint64 maxNs = 0;         // 最长耗时
+        qint64 rows = 0;          // 累计行数
+        QString lastPlan;         // 最近一次慢查询的执行计划
+    };
+
+    // 全局实例
+    static SlowQueryLog& instance();
+
+    // 设置慢查询阈值（毫秒），0 表示记录所有语句的执行计划
+    void setThresholdMs(double thresholdMs);
+    double thresholdMs() const;
+
+    // 设置日志文件路径
+    void setLogPath(const QString& path);
+
+    // 记录一次执行
+    // 参数:
+    //   - query: 已执行的语句（用于取得 SQL 文本和绑定参数）
+    //   - db: 语句所在的连接，慢查询的执行计划在同一连接上获取
+    //   - elapsedNs: 执行耗时（纳秒），包括读取结果
+    //   - rows: 返回或影响的行数
+    void record(const QSqlQuery& query, const QSqlDatabase& db, qint64 elapsedNs, int rows);
+
+    // 把 SQL 归一化为语句形状
+    static QString shapeOf(const QString& sql);
+
+    // 汇总统计的文本，按总耗时从高到低排列，用于诊断窗口
+    QString toText() const;
+
+private:
+    SlowQueryLog();
+
+    // 对慢语句执行 EXPLAIN QUERY PLAN，返回计划文本
+    static QString explain(const QSqlQuery& query, const QSqlDatabase& db);
+
+    mutable QMutex mutex;
+    double threshold;
+    QString logPath;
+    std::map<QString, ShapeStats> shapes;
+};
+
+// QueryProbe 类在 SqlManager 中包住一次语句执行：构造时开始计时，析构时交给 SlowQueryLog
+// 查询语句在遍历完结果后调用 setRows()，否则使用 numRowsAffected()
+// 一个 QueryProbe 只能包住一条语句：记录的是最后执行的语句，多条语句的耗时会全部算到它头上
+class QueryProbe
+{
+public:
+    QueryProbe(const QSqlQuery& query, const QSqlDatabase& db);
+    ~QueryProbe();
+
+    // 设置返回的行数
+    void setRows(int rowCount) { rows = rowCount; }
+
+    // 提前结束计时并记录（之后的代码不计入，析构时不再重复记录）
+    void finish();
+
+private:
+    const QSqlQuery& query;
+    QSqlDatabase db;
+    QElapsedTimer timer;
+    int rows = -1;
+};
+
+#endif // SLOWQUERYLOG_H
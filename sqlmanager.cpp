@@ -8,24 +8,220 @@
 #include <tuple>
 #include <QString>
 #include <QVariant>
+#include <QStringList>
+#include <cmath>
 
 #include "taxcalccenter.h"  // 用于计算税费的类
-#include <QMessageBox>
+#include "metricsregistry.h"  // 语句耗时统计
+#include "tracerecorder.h"    // 时间线区间
+#include "slowquerylog.h"     // 慢查询日志与执行计划
+#include "allocationtracker.h" // 按操作统计堆分配
+#include "configstore.h"      // PRAGMA 设置
+#include "databasemaintenance.h" // 改动行数统计
+#include <QRegExp>
 
-// SqlManager 构造函数，当前为空
-SqlManager::SqlManager()
+namespace
 {
+    // 内存后端使用的共享缓存内存数据库，同一进程内的所有连接看到同一份数据
+    const char* MemoryDatabaseUri = "file:wagestax_memory?mode=memory&cache=shared";
 
+    // 排序字段对应的列
+    const char* sortColumn(EmployeeQuery::SortKey key)
+    {
+        switch (key)
+        {
+        case EmployeeQuery::ByName:
+            return "name";
+        case EmployeeQuery::BySalary:
+            return "salary";
+        case EmployeeQuery::ByTax:
+            return "tax";
+        default:
+            return "id";
+        }
+    }
+
+    // 把范围条件追加到 WHERE 子句，参数按顺序追加到 values
+    void appendRange(QStringList& conditions, QVariantList& values, const char* column, const EmployeeQuery::Range& range)
+    {
+        if (!std::isinf(range.minimum))
+        {
+            conditions << QString("%1 %2 ?").arg(column).arg(range.minimumExclusive ? ">" : ">=");
+            values << range.minimum;
+        }
+        if (!std::isinf(range.maximum))
+        {
+            conditions << QString("%1 %2 ?").arg(column).arg(range.maximumExclusive ? "<" : "<=");
+            values << range.maximum;
+        }
+    }
+
+    // 范围条件编译为 WHERE 子句（没有条件时为空字符串）
+    QString whereClause(const EmployeeQuery& spec, QVariantList& values)
+    {
+        QStringList conditions;
+        appendRange(conditions, values, "salary", spec.salary);
+        appendRange(conditions, values, "tax", spec.tax);
+        return conditions.isEmpty() ? QString() : " WHERE " + conditions.join(" AND ");
+    }
+
+    // 工资所在税率档位的 SQL 表达式，与 TaxCalcCenter::bracketOf 一样按内置税率表划分
+    // 表达式在建表时写进汇总触发器，热加载的税率表不会改变它（限制见 README“税率表热加载”）
+    // 参数 salary 为扣除专项扣除后的工资表达式
+    QString bracketExpression(const QString& salary)
+    {
+        QString expression = QString("CASE WHEN %1 - %2 <= 0 THEN 0").arg(salary).arg(TaxCalcCenter::Threshold);
+        for (int k = 1; k < TaxCalcCenter::BracketCount; ++k)
+        {
+            expression += QString(" WHEN %1 - %2 <= %3 THEN %4")
+                .arg(salary).arg(TaxCalcCenter::Threshold).arg(TaxCalcCenter::BracketLower[k]).arg(k);
+        }
+        return expression + QString(" ELSE %1 END").arg(TaxCalcCenter::BracketCount);
+    }
+
+    // 按语句类型区分的执行耗时直方图
+    MetricsHistogram& statementLatency(const char* statement)
+    {
+        return MetricsRegistry::instance().histogram("wagestax_sql_statement_ns",
+            QString("statement=\"%1\"").arg(statement), "SqlManager statement latency in nanoseconds");
+    }
+}
+
+// SqlManager 构造函数，记录使用的连接名和只读文件
+SqlManager::SqlManager(const QString& connectionName, const QString& readOnlyPath)
+    : connectionName(connectionName)
+    , readOnlyPath(readOnlyPath)
+{
+
+}
+
+// 返回本对象使用的数据库连接
+QSqlDatabase SqlManager::database() const
+{
+    return QSqlDatabase::database(connectionName, false);
+}
+
+// 关闭并移除数据库连接
+void SqlManager::closeSql()
+{
+    if (!QSqlDatabase::contains(connectionName))
+    {
+        return;
+    }
+
+    {
+        // 移除连接前，指向它的 QSqlDatabase 对象必须已经销毁
+        QSqlDatabase db = database();
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+// 打开数据库
+bool SqlManager::open()
+{
+    createSql();
+    return database().isOpen();
+}
+
+// 关闭数据库
+void SqlManager::close()
+{
+    closeSql();
+}
+
+// 删除全部员工
+void SqlManager::clear()
+{
+    TraceSpan span("SqlManager::clear", "sql");
+
+    // 逐行 DELETE 会为每一行触发汇总触发器，直接删表后重建更快，触发器随表一起删除
+    {
+        static const char* const statements[] = {
+            "DROP TABLE IF EXISTS employees",
+            "DROP TABLE IF EXISTS payroll_summary",
+            "DROP TABLE IF EXISTS employee_deductions",
+            "DROP TABLE IF EXISTS employee_pay_breakdown"
+        };
+        QSqlQuery query(database());
+        for (const char* statement : statements)
+        {
+            QueryProbe probe(query, database());
+            if (!query.exec(statement))
+            {
+                qDebug() << "Error clearing employees:" << query.lastError().text();
+                return;
+            }
+        }
+        // 自增序列表在第一次插入后才存在，失败可以忽略
+        QueryProbe probe(query, database());
+        query.exec("DELETE FROM sqlite_sequence WHERE name = 'employees'");
+    }
+    createSchema();
+    DatabaseMaintenance::requestIdleRun();
+    emit EmployeeStoreEvents::instance()->employeesReset();
+}
+
+// 读取增量维护的工资汇总
+PayrollSummary SqlManager::payrollSummary()
+{
+    static MetricsHistogram& latency = statementLatency("select_summary");
+    ScopedLatency timer(latency);
+    TraceSpan span("SqlManager::payrollSummary", "sql");
+    QSqlQuery query(database());
+    QueryProbe probe(query, database());
+
+    PayrollSummary summary;
+    if (!query.exec("SELECT bracket, headcount, total_salary, total_tax FROM payroll_summary"))
+    {
+        qDebug() << "Summary query failed:" << query.lastError().text();
+        return summary;
+    }
+    while (query.next())
+    {
+        int bracket = query.value(0).toInt();
+        if (bracket < 0 || bracket >= PayrollSummary::BracketCount)
+        {
+            continue;
+        }
+        summary.brackets[bracket].headcount = query.value(1).toLongLong();
+        summary.brackets[bracket].totalSalary = query.value(2).toDouble();
+        summary.brackets[bracket].totalTax = query.value(3).toDouble();
+    }
+    probe.setRows(PayrollSummary::BracketCount);
+    return summary;
 }
 
 // 创建SQLite数据库及其表格
 void SqlManager::createSql()
 {
     // 使用SQLite数据库驱动连接数据库
-    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE");
+    QSqlDatabase db = QSqlDatabase::contains(connectionName)
+        ? database()
+        : QSqlDatabase::addDatabase("QSQLITE", connectionName);
 
-    // 设置数据库文件名
-    db.setDatabaseName("tax_system.db");
+    // 只读快照已经包含完整的表结构，打开后直接返回
+    if (!readOnlyPath.isEmpty())
+    {
+        db.setDatabaseName(readOnlyPath);
+        db.setConnectOptions("QSQLITE_OPEN_READONLY");
+        if (!db.open())
+        {
+            qDebug() << "Failed to open" << readOnlyPath << ":" << db.lastError().text();
+        }
+        return;
+    }
+
+    // 设置数据库文件名，内存后端使用共享缓存的内存数据库
+    if (EmployeeStore::backend() == EmployeeStore::SqliteMemory)
+    {
+        db.setDatabaseName(MemoryDatabaseUri);
+        db.setConnectOptions("QSQLITE_OPEN_URI");
+    }
+    else
+    {
+        db.setDatabaseName(EmployeeStore::path());
+    }
 
     // 尝试打开数据库，判断是否成功
     if (!db.open())
@@ -39,23 +235,185 @@ void SqlManager::createSql()
         qDebug() << "Database opened successfully!";
     }
 
+    applyPragmas();
+    createSchema();
+}
+
+// 执行配置中的 PRAGMA，名称和值只允许字母、数字、下划线和负号，不会拼接出其他语句
+void SqlManager::applyPragmas()
+{
+    QRegExp namePattern("[a-z_]+");
+    QRegExp valuePattern("-?[A-Za-z0-9_]+");
+
+    QHash<QString, QString> pragmas = ConfigStore::instance().section("sqlite.");
+    if (EmployeeStore::backend() == EmployeeStore::SqliteFile && !pragmas.contains("journal_mode"))
+    {
+        pragmas.insert("journal_mode", "WAL");
+    }
+    QSqlQuery query(database());
+    for (auto it = pragmas.constBegin(); it != pragmas.constEnd(); ++it)
+    {
+        if (!namePattern.exactMatch(it.key()) || !valuePattern.exactMatch(it.value()))
+        {
+            qWarning() << "Ignoring invalid pragma" << it.key() << "=" << it.value();
+            continue;
+        }
+        if (!query.exec(QString("PRAGMA %1 = %2").arg(it.key(), it.value())))
+        {
+            qWarning() << "PRAGMA" << it.key() << "failed:" << query.lastError().text();
+        }
+    }
+}
+
+// 创建表格、索引以及工资汇总表和触发器
+void SqlManager::createSchema()
+{
     // 创建员工表格（如果该表格不存在的话）
-    QSqlQuery query;
+    static MetricsHistogram& latency = statementLatency("create_schema");
+    ScopedLatency timer(latency);
+    TraceSpan span("SqlManager::createSchema", "sql");
+    // 建表语句每个连接只执行一次，不计入按语句形状汇总的统计（总耗时已由 create_schema 直方图记录）
+    QSqlQuery query(database());
     query.exec("CREATE TABLE IF NOT EXISTS employees ("
         "id INTEGER PRIMARY KEY AUTOINCREMENT, "  // 自增的员工ID
         "name TEXT NOT NULL, "                    // 员工姓名，不能为空
         "salary REAL NOT NULL, "                  // 员工薪水，不能为空
-        "tax REAL NOT NULL);");                   // 员工税额，不能为空
+        "tax REAL NOT NULL, "                     // 员工税额，不能为空
+        "deduction REAL NOT NULL DEFAULT 0);");   // 专项扣除合计，与 employee_deductions.total 同步，汇总触发器据此划分档位
+
+    // 排序和范围查询使用的复合索引：先按排序列，再按 ID，ORDER BY 列, id 可以直接沿索引扫描
+    query.exec("CREATE INDEX IF NOT EXISTS idx_employees_salary ON employees (salary, id)");
+    query.exec("CREATE INDEX IF NOT EXISTS idx_employees_tax ON employees (tax, id)");
+    query.exec("CREATE INDEX IF NOT EXISTS idx_employees_name ON employees (name, id)");
+
+    // 专项扣除表，每名员工最多一行，没有行表示没有扣除；删除员工时由触发器一并删除
+    query.exec("CREATE TABLE IF NOT EXISTS employee_deductions ("
+        "employee_id INTEGER PRIMARY KEY, "
+        "children_education REAL NOT NULL DEFAULT 0, "     // 子女教育
+        "housing_loan_interest REAL NOT NULL DEFAULT 0, "  // 住房贷款利息
+        "rent REAL NOT NULL DEFAULT 0, "                   // 住房租金
+        "elderly_support REAL NOT NULL DEFAULT 0, "        // 赡养老人
+        "social_insurance REAL NOT NULL DEFAULT 0, "       // 社会保险
+        "total REAL NOT NULL DEFAULT 0)");                 // 合计，写入时计算，分页读取时直接关联
+    query.exec("CREATE TRIGGER IF NOT EXISTS employees_deductions_delete AFTER DELETE ON employees BEGIN "
+        "DELETE FROM employee_deductions WHERE employee_id = OLD.id; END");
+
+    // 应发到实发的工资明细（社保、公积金、个税），由 PayBreakdown 按城市规则整体重算
+    query.exec("CREATE TABLE IF NOT EXISTS employee_pay_breakdown ("
+        "employee_id INTEGER PRIMARY KEY, "
+        "city TEXT NOT NULL, "
+        "gross REAL NOT NULL, "                  // 应发工资（计算时的工资）
+        "pension REAL NOT NULL, "                // 个人养老保险
+        "medical REAL NOT NULL, "                // 个人医疗保险
+        "unemployment REAL NOT NULL, "           // 个人失业保险
+        "housing_fund REAL NOT NULL, "           // 个人住房公积金
+        "employee_contribution REAL NOT NULL, "  // 个人缴费合计
+        "employer_contribution REAL NOT NULL, "  // 单位缴费合计
+        "deduction REAL NOT NULL, "              // 专项扣除合计
+        "tax REAL NOT NULL, "                    // 个人所得税
+        "net REAL NOT NULL, "                    // 实发工资
+        "computed_at TEXT NOT NULL)");
+    query.exec("CREATE TRIGGER IF NOT EXISTS employees_breakdown_delete AFTER DELETE ON employees BEGIN "
+        "DELETE FROM employee_pay_breakdown WHERE employee_id = OLD.id; END");
+
+    // 工资汇总表由触发器在每次增删改时增量维护，每个档位一行
+    // 汇总表、三个触发器、每档一行以及 deduction 列是否都已就绪；只读检查，不需要写锁
+    auto summaryReady = [&query](bool* hasDeduction) {
+        query.exec("SELECT "
+            "(SELECT COUNT(*) FROM sqlite_master WHERE type = 'table' AND name = 'payroll_summary'), "
+            "(SELECT COUNT(*) FROM sqlite_master WHERE type = 'trigger' AND name IN "
+            "('employees_summary_insert', 'employees_summary_delete', 'employees_summary_update')), "
+            "(SELECT COUNT(*) FROM pragma_table_info('employees') WHERE name = 'deduction')");
+        const bool valid = query.next();
+        const bool tableExists = valid && query.value(0).toInt() == 1;
+        const bool triggersExist = valid && query.value(1).toInt() == 3;
+        *hasDeduction = valid && query.value(2).toInt() == 1;
+        query.finish();
+        if (!tableExists || !triggersExist || !*hasDeduction)
+        {
+            return false;
+        }
+        query.exec("SELECT COUNT(*) FROM payroll_summary");
+        const bool rowsComplete = query.next() && query.value(0).toInt() == PayrollSummary::BracketCount;
+        query.finish();
+        return rowsComplete;
+    };
+
+    // 已经就绪时（除第一次打开外的每次打开）直接返回，多个连接同时打开也不会互相等待写锁
+    bool hasDeduction = false;
+    if (summaryReady(&hasDeduction))
+    {
+        return;
+    }
+
+    // 需要建表或回填时（新数据库或升级前的数据库）在同一个写事务中建表、回填并创建触发器，
+    // BEGIN IMMEDIATE 保证多个连接同时打开时只有一个执行回填；拿到写锁后重新检查，别的连接可能已经完成
+    query.exec("BEGIN IMMEDIATE");
+    const bool summaryExists = summaryReady(&hasDeduction);
+
+    // 旧数据库的 employees 没有 deduction 列：补上并从扣除表回填，按应纳税所得额重建汇总表和触发器
+    if (!hasDeduction)
+    {
+        query.exec("ALTER TABLE employees ADD COLUMN deduction REAL NOT NULL DEFAULT 0");
+        query.exec("UPDATE employees SET deduction = (SELECT total FROM employee_deductions WHERE employee_id = employees.id) "
+            "WHERE id IN (SELECT employee_id FROM employee_deductions)");
+    }
+
+    // 汇总表不完整（不存在、缺少触发器或档位行）时整体重建
+    if (!summaryExists)
+    {
+        query.exec("DROP TRIGGER IF EXISTS employees_summary_insert");
+        query.exec("DROP TRIGGER IF EXISTS employees_summary_delete");
+        query.exec("DROP TRIGGER IF EXISTS employees_summary_update");
+        query.exec("DROP TABLE IF EXISTS payroll_summary");
+
+        QString bracketOfNew = bracketExpression("(NEW.salary - NEW.deduction)");
+        QString bracketOfOld = bracketExpression("(OLD.salary - OLD.deduction)");
+
+        query.exec("CREATE TABLE payroll_summary ("
+            "bracket INTEGER PRIMARY KEY, "
+            "headcount INTEGER NOT NULL DEFAULT 0, "
+            "total_salary REAL NOT NULL DEFAULT 0, "
+            "total_tax REAL NOT NULL DEFAULT 0)");
+        query.exec(QString("INSERT INTO payroll_summary (bracket, headcount, total_salary, total_tax) "
+            "SELECT %1 AS bracket, COUNT(*), SUM(salary), SUM(tax) FROM employees GROUP BY bracket")
+            .arg(bracketExpression("(salary - deduction)")));
+        for (int bracket = 0; bracket < PayrollSummary::BracketCount; ++bracket)
+        {
+            query.exec(QString("INSERT OR IGNORE INTO payroll_summary (bracket) VALUES (%1)").arg(bracket));
+        }
+
+        query.exec(QString("CREATE TRIGGER employees_summary_insert AFTER INSERT ON employees BEGIN "
+            "UPDATE payroll_summary SET headcount = headcount + 1, total_salary = total_salary + NEW.salary, "
+            "total_tax = total_tax + NEW.tax WHERE bracket = %1; END").arg(bracketOfNew));
+        query.exec(QString("CREATE TRIGGER employees_summary_delete AFTER DELETE ON employees BEGIN "
+            "UPDATE payroll_summary SET headcount = headcount - 1, total_salary = total_salary - OLD.salary, "
+            "total_tax = total_tax - OLD.tax WHERE bracket = %1; END").arg(bracketOfOld));
+        query.exec(QString("CREATE TRIGGER employees_summary_update AFTER UPDATE OF salary, tax, deduction ON employees BEGIN "
+            "UPDATE payroll_summary SET headcount = headcount - 1, total_salary = total_salary - OLD.salary, "
+            "total_tax = total_tax - OLD.tax WHERE bracket = %1; "
+            "UPDATE payroll_summary SET headcount = headcount + 1, total_salary = total_salary + NEW.salary, "
+            "total_tax = total_tax + NEW.tax WHERE bracket = %2; END").arg(bracketOfOld, bracketOfNew));
+    }
+    if (!query.exec("COMMIT"))
+    {
+        qDebug() << "Failed to create payroll summary:" << query.lastError().text();
+        query.exec("ROLLBACK");
+    }
 }
 
 // 添加新员工记录
-void SqlManager::addEmployee(const QString& name, double salary)
+bool SqlManager::addEmployee(const QString& name, double salary)
 {
     // 计算员工的税额
     double tax = TaxCalcCenter::calculateTax(salary);
 
     // 创建SQL查询对象并准备插入操作
-    QSqlQuery query;
+    static MetricsHistogram& latency = statementLatency("insert");
+    ScopedLatency timer(latency);
+    TraceSpan span("SqlManager::addEmployee", "sql");
+    QSqlQuery query(database());
+    QueryProbe probe(query, database());
     query.prepare("INSERT INTO employees (name, salary, tax) VALUES (?, ?, ?)");
 
     // 绑定参数值
@@ -64,7 +422,10 @@ void SqlManager::addEmployee(const QString& name, double salary)
     query.addBindValue(tax);     // 员工税额
 
     // 执行查询并检查是否成功
-    if (!query.exec()) 
+    bool succeeded = query.exec();
+    timer.finish();
+    probe.finish();
+    if (!succeeded) 
     {
         // 如果执行失败，输出错误信息
         qDebug() << "Error inserting employee:" << query.lastError().text();
@@ -73,19 +434,81 @@ void SqlManager::addEmployee(const QString& name, double salary)
     {
         // 如果成功，输出成功信息
         qDebug() << "Employee added successfully!";
-        
-       QMessageBox::information(nullptr, QString::fromLocal8Bit("添加成功"), QString::fromLocal8Bit("成功录入！"), QMessageBox::StandardButton::Ok);
+        int id = query.lastInsertId().toInt();
+        emit EmployeeStoreEvents::instance()->employeeSaved(id, name, salary, formatEmployee(id, name, salary, tax));
     }
+    return succeeded;
+}
+
+// 在一个事务中批量添加员工
+int SqlManager::addEmployees(const std::vector<std::pair<QString, double>>& employees)
+{
+    static MetricsHistogram& latency = statementLatency("bulk_insert");
+    ScopedLatency timer(latency);
+    TraceSpan span("SqlManager::addEmployees", "sql");
+    AllocationScope allocations("import");
+
+    // 税额一次性批量计算
+    std::vector<double> salaries(employees.size());
+    for (size_t i = 0; i < employees.size(); ++i)
+    {
+        salaries[i] = employees[i].second;
+    }
+    std::vector<double> taxes(employees.size());
+    TaxCalcCenter::calculateTaxBatch(salaries.data(), taxes.data(), int(salaries.size()));
+
+    QSqlDatabase db = database();
+    if (!db.transaction())
+    {
+        qDebug() << "Error starting bulk insert:" << db.lastError().text();
+        return 0;
+    }
+
+    // 语句只准备一次，每行重新绑定参数后执行
+    // 整个循环只用一个 QueryProbe：始终是同一条 INSERT，逐行记录会让慢查询日志的加锁开销压过插入本身
+    QSqlQuery query(db);
+    QueryProbe probe(query, db);
+    query.prepare("INSERT INTO employees (name, salary, tax) VALUES (?, ?, ?)");
+
+    int inserted = 0;
+    for (size_t i = 0; i < employees.size(); ++i)
+    {
+        query.bindValue(0, employees[i].first);
+        query.bindValue(1, salaries[i]);
+        query.bindValue(2, taxes[i]);
+        if (!query.exec())
+        {
+            qDebug() << "Error inserting employee:" << query.lastError().text();
+            db.rollback();
+            return 0;
+        }
+        ++inserted;
+    }
+    probe.setRows(inserted);
+    probe.finish();
+
+    if (!db.commit())
+    {
+        qDebug() << "Error committing bulk insert:" << db.lastError().text();
+        db.rollback();
+        return 0;
+    }
+    emit EmployeeStoreEvents::instance()->employeesReset();
+    return inserted;
 }
 
 // 更新现有员工记录
-void SqlManager::updateEmployee(int id, const QString& name, double salary) 
+bool SqlManager::updateEmployee(int id, const QString& name, double salary) 
 {
-    // 计算新的税额
-    double tax = TaxCalcCenter::calculateTax(salary);
+    // 计算新的税额，扣除该员工的专项扣除
+    double tax = TaxCalcCenter::calculateTax(salary, deductions(id).total());
 
     // 创建SQL查询对象并准备更新操作
-    QSqlQuery query;
+    static MetricsHistogram& latency = statementLatency("update");
+    ScopedLatency timer(latency);
+    TraceSpan span("SqlManager::updateEmployee", "sql");
+    QSqlQuery query(database());
+    QueryProbe probe(query, database());
     query.prepare("UPDATE employees SET name = ?, salary = ?, tax = ? WHERE id = ?");
 
     // 绑定参数值
@@ -99,19 +522,29 @@ void SqlManager::updateEmployee(int id, const QString& name, double salary)
     {
         // 如果执行失败，输出错误信息
         qDebug() << "Error updating employee:" << query.lastError().text();
+        return false;
     }
-    else 
+
+    // 如果成功，输出成功信息
+    qDebug() << "Employee updated successfully!";
+    if (query.numRowsAffected() <= 0)
     {
-        // 如果成功，输出成功信息
-        qDebug() << "Employee updated successfully!";
+        return false;
     }
+    DatabaseMaintenance::recordChurn(query.numRowsAffected());
+    emit EmployeeStoreEvents::instance()->employeeSaved(id, name, salary, formatEmployee(id, name, salary, tax));
+    return true;
 }
 
 // 删除员工记录
-void SqlManager::deleteEmployee(int id) 
+bool SqlManager::deleteEmployee(int id) 
 {
     // 创建SQL查询对象并准备删除操作
-    QSqlQuery query;
+    static MetricsHistogram& latency = statementLatency("delete");
+    ScopedLatency timer(latency);
+    TraceSpan span("SqlManager::deleteEmployee", "sql");
+    QSqlQuery query(database());
+    QueryProbe probe(query, database());
     query.prepare("DELETE FROM employees WHERE id = ?");
 
     // 绑定员工ID作为删除条件
@@ -122,19 +555,130 @@ void SqlManager::deleteEmployee(int id)
     {
         // 如果执行失败，输出错误信息
         qDebug() << "Error deleting employee:" << query.lastError().text();
+        return false;
     }
-    else 
+
+    // 如果成功，输出成功信息
+    qDebug() << "Employee deleted successfully!";
+    if (query.numRowsAffected() <= 0)
     {
-        // 如果成功，输出成功信息
-        qDebug() << "Employee deleted successfully!";
+        return false;
     }
+    DatabaseMaintenance::recordChurn(query.numRowsAffected());
+    emit EmployeeStoreEvents::instance()->employeeRemoved(id);
+    return true;
+}
+
+// 读取员工的专项扣除
+EmployeeDeductions SqlManager::deductions(int id)
+{
+    static MetricsHistogram& latency = statementLatency("select_deductions");
+    ScopedLatency timer(latency);
+    QSqlQuery query(database());
+    QueryProbe probe(query, database());
+    query.prepare("SELECT children_education, housing_loan_interest, rent, elderly_support, social_insurance "
+        "FROM employee_deductions WHERE employee_id = ?");
+    query.addBindValue(id);
+
+    EmployeeDeductions result;
+    if (!query.exec())
+    {
+        qDebug() << "Deduction query failed:" << query.lastError().text();
+        return result;
+    }
+    if (query.next())
+    {
+        result.childrenEducation = query.value(0).toDouble();
+        result.housingLoanInterest = query.value(1).toDouble();
+        result.rent = query.value(2).toDouble();
+        result.elderlySupport = query.value(3).toDouble();
+        result.socialInsurance = query.value(4).toDouble();
+    }
+    return result;
+}
+
+// 写入专项扣除并重新计算税额
+bool SqlManager::setDeductions(int id, const EmployeeDeductions& deductions)
+{
+    static MetricsHistogram& latency = statementLatency("update_deductions");
+    ScopedLatency timer(latency);
+    TraceSpan span("SqlManager::setDeductions", "sql");
+
+    QSqlDatabase db = database();
+    if (!db.transaction())
+    {
+        qDebug() << "Error starting deduction update:" << db.lastError().text();
+        return false;
+    }
+
+    // 读取工资用于重新计税（三条语句各用一个 QueryProbe）
+    QSqlQuery query(db);
+    QString name;
+    double salary = 0;
+    {
+        QueryProbe probe(query, db);
+        query.prepare("SELECT name, salary FROM employees WHERE id = ?");
+        query.addBindValue(id);
+        if (!query.exec() || !query.next())
+        {
+            probe.finish();
+            db.rollback();
+            return false;
+        }
+        name = query.value(0).toString();
+        salary = query.value(1).toDouble();
+        probe.setRows(1);
+    }
+    const double tax = TaxCalcCenter::calculateTax(salary, deductions.total());
+    query.finish();
+
+    // 写入扣除明细和合计，然后更新税额和扣除合计（汇总表由触发器按新的应纳税所得额同步档位）
+    query.prepare("INSERT OR REPLACE INTO employee_deductions (employee_id, children_education, "
+        "housing_loan_interest, rent, elderly_support, social_insurance, total) VALUES (?, ?, ?, ?, ?, ?, ?)");
+    query.addBindValue(id);
+    query.addBindValue(deductions.childrenEducation);
+    query.addBindValue(deductions.housingLoanInterest);
+    query.addBindValue(deductions.rent);
+    query.addBindValue(deductions.elderlySupport);
+    query.addBindValue(deductions.socialInsurance);
+    query.addBindValue(deductions.total());
+    bool succeeded;
+    {
+        QueryProbe probe(query, db);
+        succeeded = query.exec();
+    }
+    if (succeeded)
+    {
+        QueryProbe probe(query, db);
+        query.prepare("UPDATE employees SET tax = ?, deduction = ? WHERE id = ?");
+        query.addBindValue(tax);
+        query.addBindValue(deductions.total());
+        query.addBindValue(id);
+        succeeded = query.exec();
+    }
+    if (!succeeded || !db.commit())
+    {
+        qDebug() << "Error updating deductions:" << query.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    DatabaseMaintenance::recordChurn(1);
+    emit EmployeeStoreEvents::instance()->employeeSaved(id, name, salary, formatEmployee(id, name, salary, tax));
+    return true;
 }
 
 // 查询所有员工记录
 std::vector<std::pair<int, QString>> SqlManager::queryEmployees()
 {
     // 创建SQL查询对象，查询所有员工记录
-    QSqlQuery query("SELECT * FROM employees");
+    static MetricsHistogram& latency = statementLatency("select_all");
+    ScopedLatency timer(latency);
+    TraceSpan span("SqlManager::queryEmployees", "sql");
+    AllocationScope allocations("query");
+    QSqlQuery query(database());
+    QueryProbe probe(query, database());
+    query.exec("SELECT * FROM employees");
 
     std::vector<std::pair<int, QString>> result;
     // 遍历查询结果
@@ -167,9 +711,187 @@ std::vector<std::pair<int, QString>> SqlManager::queryEmployees()
         result.push_back(std::make_pair(id, employeeInfo));
     }
 
+    probe.setRows(int(result.size()));
+    return result;
+}
+
+// 按 ID 顺序分页查询员工
+std::vector<std::pair<int, QString>> SqlManager::queryEmployeesAfter(int lastId, int limit)
+{
+    static MetricsHistogram& latency = statementLatency("select_page");
+    ScopedLatency timer(latency);
+    TraceSpan span("SqlManager::queryEmployeesAfter", "sql");
+    AllocationScope allocations("query");
+    QSqlQuery query(database());
+    QueryProbe probe(query, database());
+    query.setForwardOnly(true);  // 只向前遍历，SQLite 驱动无需缓存全部结果
+    query.prepare("SELECT id, name, salary, tax FROM employees WHERE id > ? ORDER BY id LIMIT ?");
+    query.addBindValue(lastId);
+    query.addBindValue(limit);
+
+    if (!query.exec())
+    {
+        qDebug() << "Page query failed:" << query.lastError().text();
+        return {};
+    }
+
+    std::vector<std::pair<int, QString>> result;
+    result.reserve(limit);
+    while (query.next())
+    {
+        int employeeId = query.value(0).toInt();
+        result.push_back(std::make_pair(employeeId,
+            formatEmployee(employeeId, query.value(1).toString(), query.value(2).toDouble(), query.value(3).toDouble())));
+    }
+
+    probe.setRows(int(result.size()));
+    return result;
+}
+
+// 按排序和范围条件查询
+std::vector<std::pair<int, QString>> SqlManager::queryEmployees(const EmployeeQuery& spec)
+{
+    static MetricsHistogram& latency = statementLatency("select_spec");
+    ScopedLatency timer(latency);
+    TraceSpan span("SqlManager::queryEmployees(spec)", "sql");
+    AllocationScope allocations("query");
+
+    QVariantList values;
+    QString direction = spec.descending ? " DESC" : " ASC";
+    QString orderBy = spec.sortKey == EmployeeQuery::ById
+        ? "id" + direction
+        : QString(sortColumn(spec.sortKey)) + direction + ", id" + direction;
+    QString sql = "SELECT id, name, salary, tax FROM employees" + whereClause(spec, values)
+        + " ORDER BY " + orderBy + " LIMIT ?";
+    values << qMax(0, spec.limit);
+
+    QSqlQuery query(database());
+    QueryProbe probe(query, database());
+    query.setForwardOnly(true);
+    query.prepare(sql);
+    for (int i = 0; i < values.size(); ++i)
+    {
+        query.bindValue(i, values.at(i));
+    }
+
+    if (!query.exec())
+    {
+        qDebug() << "Query failed:" << query.lastError().text();
+        return {};
+    }
+
+    std::vector<std::pair<int, QString>> result;
+    result.reserve(size_t(qMax(0, spec.limit)));
+    while (query.next())
+    {
+        int employeeId = query.value(0).toInt();
+        result.push_back(std::make_pair(employeeId,
+            formatEmployee(employeeId, query.value(1).toString(), query.value(2).toDouble(), query.value(3).toDouble())));
+    }
+
+    probe.setRows(int(result.size()));
     return result;
 }
 
+// 统计满足范围条件的员工
+int SqlManager::countEmployees(const EmployeeQuery& spec)
+{
+    static MetricsHistogram& latency = statementLatency("count_spec");
+    ScopedLatency timer(latency);
+    TraceSpan span("SqlManager::countEmployees(spec)", "sql");
+
+    QVariantList values;
+    QSqlQuery query(database());
+    QueryProbe probe(query, database());
+    query.prepare("SELECT COUNT(*) FROM employees" + whereClause(spec, values));
+    for (int i = 0; i < values.size(); ++i)
+    {
+        query.bindValue(i, values.at(i));
+    }
+
+    if (!query.exec() || !query.next())
+    {
+        qDebug() << "Count query failed:" << query.lastError().text();
+        return -1;
+    }
+    return query.value(0).toInt();
+}
+
+// 按 ID 顺序分页查询员工的完整数据
+std::vector<EmployeeRecord> SqlManager::queryRecordsAfter(int lastId, int limit)
+{
+    static MetricsHistogram& latency = statementLatency("select_page");
+    ScopedLatency timer(latency);
+    TraceSpan span("SqlManager::queryRecordsAfter", "sql");
+    AllocationScope allocations("query");
+    QSqlQuery query(database());
+    QueryProbe probe(query, database());
+    query.setForwardOnly(true);
+    query.prepare("SELECT e.id, e.name, e.salary, e.tax, IFNULL(d.total, 0), IFNULL(d.social_insurance, 0) FROM employees e "
+        "LEFT JOIN employee_deductions d ON d.employee_id = e.id WHERE e.id > ? ORDER BY e.id LIMIT ?");
+    query.addBindValue(lastId);
+    query.addBindValue(limit);
+
+    if (!query.exec())
+    {
+        qDebug() << "Page query failed:" << query.lastError().text();
+        return {};
+    }
+
+    std::vector<EmployeeRecord> result;
+    result.reserve(limit);
+    while (query.next())
+    {
+        EmployeeRecord record;
+        record.id = query.value(0).toInt();
+        record.name = query.value(1).toString();
+        record.salary = query.value(2).toDouble();
+        record.tax = query.value(3).toDouble();
+        record.deduction = query.value(4).toDouble();
+        record.socialInsurance = query.value(5).toDouble();
+        result.push_back(record);
+    }
+
+    probe.setRows(int(result.size()));
+    return result;
+}
+
+// 统计员工总数
+int SqlManager::countEmployees()
+{
+    static MetricsHistogram& latency = statementLatency("count");
+    ScopedLatency timer(latency);
+    TraceSpan span("SqlManager::countEmployees", "sql");
+    QSqlQuery query(database());
+    QueryProbe probe(query, database());
+    if (!query.exec("SELECT COUNT(*) FROM employees") || !query.next())
+    {
+        qDebug() << "Count query failed:" << query.lastError().text();
+        return -1;
+    }
+    return query.value(0).toInt();
+}
+
+// 把一行员工数据格式化为显示文本，格式与 queryEmployees 相同
+QString SqlManager::formatEmployee(int id, const QString& name, double salary, double tax)
+{
+    return QString("%1    %2    %3    %4")
+        .arg(id, 10)  // 设置宽度，确保对齐
+        .arg(name, 15) // 设置宽度，确保对齐
+        .arg(salary, 10, 'f', 2) // 设置宽度，保留2位小数
+        .arg(tax, 10, 'f', 2);  // 设置宽度，保留2位小数
+}
+
+// 记录失败原因，供核算、汇算、明细和快照等后台操作共用
+void SqlManager::reportError(QString* error, const char* source, const QString& message)
+{
+    qDebug() << source << ":" << message;
+    if (error)
+    {
+        *error = message;
+    }
+}
+
 std::vector<std::pair<int, QString>> SqlManager::queryEmployeeByIdOrName(int id, const QString& name) {
     // SQL查询字符串
     QString queryStr = "SELECT * FROM employees WHERE ";
@@ -201,7 +923,12 @@ std::vector<std::pair<int, QString>> SqlManager::queryEmployeeByIdOrName(int id,
     }
 
     // 创建SQL查询对象
-    QSqlQuery query;
+    static MetricsHistogram& latency = statementLatency("select_by_id_or_name");
+    ScopedLatency timer(latency);
+    TraceSpan span("SqlManager::queryEmployeeByIdOrName", "sql");
+    AllocationScope allocations("query");
+    QSqlQuery query(database());
+    QueryProbe probe(query, database());
     query.prepare(queryStr);
 
     // 设置查询参数
@@ -260,6 +987,7 @@ std::vector<std::pair<int, QString>> SqlManager::queryEmployeeByIdOrName(int id,
         result.push_back(std::make_pair(employeeId, employeeInfo));
     }
 
+    probe.setRows(int(result.size()));
     return result;
 }
 
@@ -297,7 +1025,12 @@ SqlManager::queryEmployeeByIdOrName(int id)
     }
 
     // 创建SQL查询对象
-    QSqlQuery query;
+    static MetricsHistogram& latency = statementLatency("select_by_id");
+    ScopedLatency timer(latency);
+    TraceSpan span("SqlManager::queryEmployeeByIdOrName(id)", "sql");
+    AllocationScope allocations("query");
+    QSqlQuery query(database());
+    QueryProbe probe(query, database());
     query.prepare(queryStr);
 
     // 设置查询参数
@@ -345,6 +1078,7 @@ SqlManager::queryEmployeeByIdOrName(int id)
         result.push_back(std::make_tuple(employeeId, employeeName, salary));
     }
 
+    probe.setRows(int(result.size()));
     return result;
 }
 
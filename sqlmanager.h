@@ -3,52 +3,137 @@
 
 // 包含 QObject 类定义，Qt 的所有类都继承自 QObject 类，提供对象间信号和槽机制
 #include <QObject>
+#include <QSqlDatabase>
+#include <QString>
+#include <vector>
+#include <tuple>
+#include "employeestore.h"
 
 // SqlManager 类负责与数据库的交互，包含创建数据库、增删改查员工信息等功能
-class SqlManager
+// 它是 EmployeeStore 的 SQLite 实现，数据库文件或内存数据库由 EmployeeStore 的配置决定
+class SqlManager : public EmployeeStore
 {
 public:
     // 构造函数，用于初始化 SqlManager 对象
-    SqlManager();
+    // 参数:
+    //   - connectionName: 使用的数据库连接名，默认使用 Qt 的默认连接。
+    //     Qt 的数据库连接只能在创建它的线程中使用，因此在后台线程中使用时必须指定一个该线程专用的连接名，
+    //     并在同一线程中关闭；PayrollLedger、AnnualSettlement 等基于 SqlManager 的类都遵循这条规则
+    //   - readOnlyPath: 非空时以只读方式打开该文件（例如报表快照），不执行 PRAGMA 和建表
+    explicit SqlManager(const QString& connectionName = QLatin1String(QSqlDatabase::defaultConnection),
+        const QString& readOnlyPath = QString());
 
     // createSql 函数用于创建数据库及相关表格
     // 该函数会检查数据库是否存在，如果不存在则创建数据库
     void createSql();
 
+    // closeSql 函数关闭并移除本对象使用的数据库连接
+    // 后台线程使用完临时连接后应调用它，连接只能在创建它的线程中关闭
+    void closeSql();
+
+    // database 函数返回本对象使用的数据库连接
+    QSqlDatabase database() const;
+
+    // open 函数即 createSql，返回连接是否成功打开
+    bool open() override;
+
+    // close 函数即 closeSql
+    void close() override;
+
+    // clear 函数删除全部员工并重置自增 ID
+    void clear() override;
+
     // addEmployee 函数用于向数据库中添加一名员工的信息
     // 参数:
     //   - name: 员工的姓名
     //   - salary: 员工的工资
-    void addEmployee(const QString& name, double salary);
+    // 返回值：是否添加成功
+    bool addEmployee(const QString& name, double salary) override;
+
+    // addEmployees 函数在一个事务中批量添加员工，税额使用批量算法一次算出
+    // 参数:
+    //   - employees: 员工姓名和工资的列表
+    // 返回值：成功写入的条数
+    int addEmployees(const std::vector<std::pair<QString, double>>& employees) override;
 
     // updateEmployee 函数用于更新数据库中指定员工的相关信息
     // 参数:
     //   - id: 员工的唯一标识符（通常是员工的 ID）
     //   - name: 员工的新姓名
     //   - salary: 员工的新工资
-    void updateEmployee(int id, const QString& name, double salary);
+    // 返回值：是否修改成功，失败原因写入调试输出
+    bool updateEmployee(int id, const QString& name, double salary) override;
+
+    // deductions 函数读取 employee_deductions 表中员工的专项扣除
+    EmployeeDeductions deductions(int id) override;
+
+    // setDeductions 函数在一个事务中写入专项扣除并重新计算该员工的税额
+    bool setDeductions(int id, const EmployeeDeductions& deductions) override;
 
     // deleteEmployee 函数用于从数据库中删除指定员工的信息
     // 参数:
     //   - id: 要删除的员工的唯一标识符
-    void deleteEmployee(int id);
+    // 返回值：是否删除成功，失败原因写入调试输出
+    bool deleteEmployee(int id) override;
 
     // queryEmployees 函数用于查询数据库中所有员工的基本信息
     // 返回值：一个包含员工 ID 和姓名的 vector 对象
-    std::vector<std::pair<int, QString>> queryEmployees();
+    std::vector<std::pair<int, QString>> queryEmployees() override;
 
     // queryEmployeeByIdOrName 函数用于通过员工 ID 或姓名来查询员工信息
     // 参数:
     //   - id: 员工的唯一标识符
     //   - name: 员工的姓名
     // 返回值：一个包含员工 ID 和姓名的 vector 对象
-    std::vector<std::pair<int, QString>> queryEmployeeByIdOrName(int id, const QString& name);
+    std::vector<std::pair<int, QString>> queryEmployeeByIdOrName(int id, const QString& name) override;
 
     // queryEmployeeByIdOrName 函数重载，用于通过员工 ID 查询员工的详细信息
     // 参数:
     //   - id: 员工的唯一标识符
     // 返回值：一个包含员工 ID、姓名和工资的 vector 对象
-    std::vector<std::tuple<int, QString, double>> queryEmployeeByIdOrName(int id);
+    std::vector<std::tuple<int, QString, double>> queryEmployeeByIdOrName(int id) override;
+
+    // queryEmployeesAfter 函数按 ID 顺序分页查询员工（键集分页，不使用 OFFSET）
+    // 参数:
+    //   - lastId: 上一页最后一名员工的 ID，第一页传 0
+    //   - limit: 每页最多返回的条数
+    // 返回值：与 queryEmployees 格式相同的员工列表
+    std::vector<std::pair<int, QString>> queryEmployeesAfter(int lastId, int limit) override;
+
+    // queryEmployees 函数重载，把排序和范围条件编译为 SQL，排序和过滤由数据库借助复合索引完成
+    std::vector<std::pair<int, QString>> queryEmployees(const EmployeeQuery& query) override;
+
+    // countEmployees 函数重载，统计满足范围条件的员工
+    int countEmployees(const EmployeeQuery& query) override;
+
+    // queryRecordsAfter 函数按 ID 顺序分页查询员工的完整数据，专项扣除合计通过 LEFT JOIN 一并读出
+    std::vector<EmployeeRecord> queryRecordsAfter(int lastId, int limit) override;
+
+    // countEmployees 函数返回员工总数，查询失败时返回 -1
+    int countEmployees() override;
+
+    // payrollSummary 函数读取由触发器维护的工资汇总表（每个档位一行）
+    PayrollSummary payrollSummary() override;
+
+    // formatEmployee 函数把一行员工数据格式化为列表中显示的文本
+    static QString formatEmployee(int id, const QString& name, double salary, double tax);
+
+    // reportError 函数记录失败原因：写入调试输出（前缀 source 标明来源），error 不为空时同时写入 error
+    static void reportError(QString* error, const char* source, const QString& message);
+
+private:
+    // 创建表格、索引、工资汇总表和触发器（已存在时跳过）
+    void createSchema();
+
+    // 执行配置中以 sqlite. 开头的 PRAGMA，例如 sqlite.journal_mode=WAL、sqlite.synchronous=NORMAL；
+    // 文件数据库没有配置 journal_mode 时使用 WAL，报表快照依赖它才不阻塞写入
+    void applyPragmas();
+
+    // 数据库连接名
+    QString connectionName;
+
+    // 只读打开的数据库文件，为空时使用配置的存储
+    QString readOnlyPath;
 };
 
 #endif // SQLMANAGER_H
@@ -0,0 +1,209 @@
+﻿#include "startupprofiler.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QEvent>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimer>
+#include <QWidget>
+
+QElapsedTimer StartupProfiler::clock;
+QMutex StartupProfiler::mutex;
+std::vector<StartupProfiler::Phase> StartupProfiler::phases;
+qint64 StartupProfiler::firstPaintNs = -1;
+bool StartupProfiler::tracing = false;
+bool StartupProfiler::exitAfterPaint = false;
+double StartupProfiler::budgetMs = 0;
+QString StartupProfiler::reportPath;
+
+// 开始计时
+void StartupProfiler::start()
+{
+    clock.start();
+    phases.reserve(16);
+}
+
+// 读取命令行参数
+void StartupProfiler::configure(const QStringList& arguments)
+{
+    int index = arguments.indexOf("--startup-trace");
+    if (index >= 0)
+    {
+        tracing = true;
+        // 后面紧跟的不是另一个选项时视为报告文件名
+        if (index + 1 < arguments.size() && !arguments.at(index + 1).startsWith("--"))
+        {
+            reportPath = arguments.at(index + 1);
+        }
+    }
+
+    exitAfterPaint = arguments.contains("--startup-exit");
+
+    index = arguments.indexOf("--startup-budget");
+    if (index >= 0 && index + 1 < arguments.size())
+    {
+        budgetMs = arguments.at(index + 1).toDouble();
+    }
+}
+
+// 是否启用了启动跟踪
+bool StartupProfiler::isTracing()
+{
+    return tracing;
+}
+
+// 开始一个阶段
+int StartupProfiler::begin(const QString& name, bool interactive)
+{
+    Phase phase;
+    phase.name = name;
+    phase.startNs = clock.nsecsElapsed();
+    phase.durationNs = -1;
+    phase.interactive = interactive;
+
+    QMutexLocker locker(&mutex);
+    phases.push_back(phase);
+    return int(phases.size()) - 1;
+}
+
+// 结束一个阶段
+void StartupProfiler::end(int phaseIndex)
+{
+    QMutexLocker locker(&mutex);
+    if (phaseIndex < 0 || phaseIndex >= int(phases.size()))
+    {
+        return;
+    }
+    Phase& phase = phases[phaseIndex];
+    phase.durationNs = clock.nsecsElapsed() - phase.startNs;
+}
+
+// 监视窗口的第一次绘制
+void StartupProfiler::watchFirstPaint(QWidget* window)
+{
+    window->installEventFilter(new FirstPaintWatcher(window));
+}
+
+// 记录首帧时间
+void StartupProfiler::markFirstPaint()
+{
+    if (firstPaintNs >= 0)
+    {
+        return;
+    }
+    firstPaintNs = clock.nsecsElapsed();
+
+    // 等本次绘制完成后再输出报告，避免把报告本身算进首帧
+    QTimer::singleShot(0, []() {
+        report();
+
+        if (exitAfterPaint)
+        {
+            bool overBudget = budgetMs > 0 && firstPaintExcludingInteractiveMs() > budgetMs;
+            QCoreApplication::exit(overBudget ? 1 : 0);
+        }
+        });
+}
+
+// 首帧时间（毫秒）
+double StartupProfiler::firstPaintMs()
+{
+    return firstPaintNs < 0 ? -1 : firstPaintNs / 1e6;
+}
+
+// 首帧时间扣除交互阶段（毫秒）
+double StartupProfiler::firstPaintExcludingInteractiveMs()
+{
+    if (firstPaintNs < 0)
+    {
+        return -1;
+    }
+
+    QMutexLocker locker(&mutex);
+    qint64 interactiveNs = 0;
+    for (const Phase& phase : phases)
+    {
+        if (phase.interactive && phase.durationNs > 0 && phase.startNs < firstPaintNs)
+        {
+            interactiveNs += phase.durationNs;
+        }
+    }
+    return (firstPaintNs - interactiveNs) / 1e6;
+}
+
+// 打印报告并写出 JSON
+void StartupProfiler::report()
+{
+    if (!tracing)
+    {
+        return;
+    }
+
+    qDebug() << "Startup trace:";
+    QJsonArray phaseArray;
+    QMutexLocker locker(&mutex);
+    for (const Phase& phase : phases)
+    {
+        double startMs = phase.startNs / 1e6;
+        double durationMs = phase.durationNs < 0 ? -1 : phase.durationNs / 1e6;
+        qDebug().noquote() << QString("  %1 %2 ms  +%3 ms%4")
+            .arg(phase.name, -28)
+            .arg(startMs, 10, 'f', 3)
+            .arg(durationMs, 10, 'f', 3)
+            .arg(phase.interactive ? "  (interactive)" : "");
+
+        QJsonObject item;
+        item["name"] = phase.name;
+        item["startMs"] = startMs;
+        item["durationMs"] = durationMs;
+        item["interactive"] = phase.interactive;
+        phaseArray.append(item);
+    }
+    locker.unlock();
+
+    qDebug().noquote() << QString("  first paint: %1 ms (excluding interactive: %2 ms)")
+        .arg(firstPaintMs(), 0, 'f', 3)
+        .arg(firstPaintExcludingInteractiveMs(), 0, 'f', 3);
+
+    if (reportPath.isEmpty())
+    {
+        return;
+    }
+
+    QJsonObject root;
+    root["phases"] = phaseArray;
+    root["firstPaintMs"] = firstPaintMs();
+    root["firstPaintExcludingInteractiveMs"] = firstPaintExcludingInteractiveMs();
+    root["budgetMs"] = budgetMs;
+
+    QFile file(reportPath);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        file.write(QJsonDocument(root).toJson());
+    }
+    else
+    {
+        qDebug() << "Failed to write startup trace to" << reportPath;
+    }
+}
+
+// FirstPaintWatcher 构造函数
+FirstPaintWatcher::FirstPaintWatcher(QObject* parent)
+    : QObject(parent)
+{
+
+}
+
+// 主窗口或其子控件的第一次绘制事件到达时记录首帧
+bool FirstPaintWatcher::eventFilter(QObject* watched, QEvent* event)
+{
+    if (event->type() == QEvent::Paint || event->type() == QEvent::UpdateRequest)
+    {
+        StartupProfiler::markFirstPaint();
+        watched->removeEventFilter(this);
+        deleteLater();
+    }
+    return QObject::eventFilter(watched, event);
+}
@@ -0,0 +1,103 @@
+﻿#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+// 引入 QObject，首帧绘制检测依赖事件过滤器
+#include <QObject>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+class QWidget;
+
+// StartupProfiler 类记录程序启动各阶段的耗时，以及从进程启动到主窗口首次绘制的时间
+// 命令行参数：
+//   --startup-trace [文件]   启动完成后打印各阶段耗时，给出文件名时同时写出 JSON 报告
+//   --startup-exit           首次绘制后立即退出（用于回归测试）
+//   --startup-budget <毫秒>  首次绘制（不含登录等交互阶段）超过预算时以非 0 退出码结束
+class StartupProfiler
+{
+public:
+    // 单个启动阶段的记录
+    struct Phase
+    {
+        QString name;        // 阶段名称
+        qint64 startNs;      // 相对进程启动的开始时间（纳秒）
+        qint64 durationNs;   // 耗时（纳秒），-1 表示尚未结束
+        bool interactive;    // 是否是等待用户输入的阶段（例如登录对话框）
+    };
+
+    // 在 main 的第一行调用，开始计时
+    static void start();
+
+    // 读取命令行参数
+    static void configure(const QStringList& arguments);
+
+    // 是否启用了 --startup-trace
+    static bool isTracing();
+
+    // 开始一个阶段，返回阶段序号
+    static int begin(const QString& name, bool interactive = false);
+
+    // 结束一个阶段
+    static void end(int phaseIndex);
+
+    // 监视窗口的第一次绘制，记录首帧时间并按配置输出报告或退出程序
+    static void watchFirstPaint(QWidget* window);
+
+    // 记录首帧时间（由首帧检测调用）
+    static void markFirstPaint();
+
+    // 首帧时间（毫秒），尚未绘制时返回 -1
+    static double firstPaintMs();
+
+    // 首帧时间扣除交互阶段后的值（毫秒），这是可用于回归比较的冷启动指标
+    static double firstPaintExcludingInteractiveMs();
+
+    // 打印报告，并在需要时写出 JSON 文件
+    static void report();
+
+private:
+    static QElapsedTimer clock;
+    // 后台加载阶段在工作线程中记录，阶段列表需要加锁
+    static QMutex mutex;
+    static std::vector<Phase> phases;
+    static qint64 firstPaintNs;
+    static bool tracing;
+    static bool exitAfterPaint;
+    static double budgetMs;
+    static QString reportPath;
+};
+
+// StartupPhase 类以 RAII 方式记录一个阶段：构造时开始，析构时结束
+class StartupPhase
+{
+public:
+    explicit StartupPhase(const QString& name, bool interactive = false)
+        : index(StartupProfiler::begin(name, interactive))
+    {
+    }
+
+    ~StartupPhase()
+    {
+        StartupProfiler::end(index);
+    }
+
+private:
+    int index;
+};
+
+// FirstPaintWatcher 类是安装在主窗口上的事件过滤器，检测到第一次绘制后移除自身
+class FirstPaintWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FirstPaintWatcher(QObject* parent = nullptr);
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+};
+
+#endif // STARTUPPROFILER_H
@@ -1,4 +1,56 @@
 ﻿#include "taxcalccenter.h"
+#include "metricsregistry.h"  // 调用次数与批量大小统计
+#include <QMutex>
+#include <atomic>
+#include <vector>
+
+// 起征点
+const double TaxCalcCenter::Threshold = 1600;
+
+// 各档下限与税率，与 calculateTax 中的阶梯保持一致
+const double TaxCalcCenter::BracketLower[TaxCalcCenter::BracketCount] =
+    { 0, 500, 2000, 5000, 20000, 40000, 60000, 80000, 100000 };
+const double TaxCalcCenter::BracketRate[TaxCalcCenter::BracketCount] =
+    { 0.05, 0.10, 0.15, 0.20, 0.25, 0.30, 0.35, 0.40, 0.45 };
+
+// 速算扣除数：第 k 档 = 第 k-1 档速算扣除数 + 第 k 档下限 × (第 k 档税率 - 第 k-1 档税率)
+const double TaxCalcCenter::QuickDeduction[TaxCalcCenter::BracketCount] =
+    { 0, 25, 125, 375, 1375, 3375, 6375, 10375, 15375 };
+
+namespace
+{
+    // 当前发布的税率表，为空时使用内置税率表
+    std::atomic<const TaxSchedule*> currentSchedule(nullptr);
+
+    // 发布过的全部税率表。读取方只持有裸指针，无法得知旧表何时不再被使用，
+    // 因此旧表一直保留到进程结束；每份只有几百字节，税率表也很少变化
+    QMutex publishMutex;
+    std::vector<std::shared_ptr<const TaxSchedule>> publishedSchedules;
+
+    // 内置税率表
+    const TaxSchedule& builtInSchedule()
+    {
+        static const TaxSchedule schedule = TaxSchedule::builtIn();
+        return schedule;
+    }
+}
+
+// 当前税率表
+const TaxSchedule& TaxCalcCenter::schedule()
+{
+    const TaxSchedule* current = currentSchedule.load(std::memory_order_acquire);
+    return current ? *current : builtInSchedule();
+}
+
+// 发布新的税率表，只有发布方之间互斥
+int TaxCalcCenter::publishSchedule(std::shared_ptr<TaxSchedule> next)
+{
+    QMutexLocker locker(&publishMutex);
+    next->version = int(publishedSchedules.size()) + 1;
+    publishedSchedules.push_back(next);
+    currentSchedule.store(next.get(), std::memory_order_release);
+    return next->version;
+}
 
 // TaxCalcCenter 类的构造函数，当前没有初始化成员变量或执行任何操作
 TaxCalcCenter::TaxCalcCenter()
@@ -9,57 +61,161 @@ TaxCalcCenter::TaxCalcCenter()
 // calculateTax 函数用于根据传入的薪资计算个人所得税
 double TaxCalcCenter::calculateTax(double salary)
 {
-    // 扣除起征点（1600元）后的应纳税所得额
-    double taxableIncome = salary - 1600;
+    // 统计调用次数（分片计数，多线程调用不争用同一缓存行）
+    static MetricsCounter& calls = MetricsRegistry::instance().counter(
+        "wagestax_tax_calculations_total", "mode=\"single\"", "Number of salaries run through TaxCalcCenter");
+    calls.add();
+
+    // 当前税率表，整个计算过程只读取一次
+    const TaxSchedule& table = schedule();
+
+    // 扣除起征点后的应纳税所得额
+    double taxableIncome = salary - table.threshold;
 
     // 如果应纳税所得额不超过0，则无需缴税，返回税额为0
     if (taxableIncome <= 0)
     {
         return 0;
     }
-       
 
-    // 初始化税额
-    double tax = 0;
-
-    // 根据不同的应纳税所得额区间，按阶梯税率计算税额
-    if (taxableIncome <= 500) {
-        // 如果应纳税所得额不超过500元，适用5%的税率
-        tax = taxableIncome * 0.05;
-    }
-    else if (taxableIncome <= 2000) {
-        // 如果应纳税所得额在500元到2000元之间，前500元适用5%，超出部分适用10%
-        tax = 500 * 0.05 + (taxableIncome - 500) * 0.10;
-    }
-    else if (taxableIncome <= 5000) {
-        // 如果应纳税所得额在2000元到5000元之间，前500元适用5%，接下来1500元适用10%，超出部分适用15%
-        tax = 500 * 0.05 + 1500 * 0.10 + (taxableIncome - 2000) * 0.15;
+    // 找到所得额所在的档位，按“所得额 × 税率 - 速算扣除数”计算，与逐档累加的结果相同
+    int k = BracketCount - 1;
+    while (k > 0 && taxableIncome <= table.lower[k])
+    {
+        --k;
     }
-    else if (taxableIncome <= 20000) {
-        // 如果应纳税所得额在5000元到20000元之间，前500元适用5%，接下来1500元适用10%，接下来的3000元适用15%，超出部分适用20%
-        tax = 500 * 0.05 + 1500 * 0.10 + 3000 * 0.15 + (taxableIncome - 5000) * 0.20;
+    double tax = taxableIncome * table.rate[k] - table.quickDeduction[k];
+
+    // 返回计算出的税额
+    return tax;
+}
+
+// 扣除专项扣除后计税
+double TaxCalcCenter::calculateTax(double salary, double deduction)
+{
+    return calculateTax(salary - deduction);
+}
+
+// bracketOf 函数返回工资所在的档位，第 k 档的上限是第 k+1 档的下限
+int TaxCalcCenter::bracketOf(double salary)
+{
+    double taxableIncome = salary - Threshold;
+    if (taxableIncome <= 0)
+    {
+        return 0;
     }
-    else if (taxableIncome <= 40000) {
-        // 如果应纳税所得额在20000元到40000元之间，前500元适用5%，接下来1500元适用10%，接下来的3000元适用15%，接下来的15000元适用20%，超出部分适用25%
-        tax = 500 * 0.05 + 1500 * 0.10 + 3000 * 0.15 + 15000 * 0.20 + (taxableIncome - 20000) * 0.25;
+    for (int k = 1; k < BracketCount; ++k)
+    {
+        if (taxableIncome <= BracketLower[k])
+        {
+            return k;
+        }
     }
-    else if (taxableIncome <= 60000) {
-        // 如果应纳税所得额在40000元到60000元之间，前500元适用5%，接下来1500元适用10%，接下来的3000元适用15%，接下来的15000元适用20%，接下来的20000元适用25%，超出部分适用30%
-        tax = 500 * 0.05 + 1500 * 0.10 + 3000 * 0.15 + 15000 * 0.20 + 20000 * 0.25 + (taxableIncome - 40000) * 0.30;
+    return BracketCount;
+}
+
+// calculateTaxBatch 函数批量计算税额
+// 累进税额是应纳税所得额的凸分段线性函数，因此等于各档“所得额 × 税率 - 速算扣除数”的最大值，
+// 再与 0 取最大值即可覆盖未达起征点的情况
+void TaxCalcCenter::calculateTaxBatch(const double* salaries, double* taxes, int count)
+{
+    // 统计批量调用的工资个数和批量大小分布
+    static MetricsCounter& calls = MetricsRegistry::instance().counter(
+        "wagestax_tax_calculations_total", "mode=\"batch\"");
+    static MetricsHistogram& batchSizes = MetricsRegistry::instance().histogram(
+        "wagestax_tax_batch_size", QString(), "Number of salaries per calculateTaxBatch call");
+    calls.add(quint64(count));
+    batchSizes.record(quint64(count));
+
+    // 当前税率表，整批工资使用同一份
+    const TaxSchedule& table = schedule();
+
+    for (int i = 0; i < count; ++i)
+    {
+        // 扣除起征点后的应纳税所得额
+        double taxableIncome = salaries[i] - table.threshold;
+
+        // 依次与每一档比较，取最大值
+        double tax = 0;
+        for (int k = 0; k < BracketCount; ++k)
+        {
+            double candidate = taxableIncome * table.rate[k] - table.quickDeduction[k];
+            tax = candidate > tax ? candidate : tax;
+        }
+
+        taxes[i] = tax;
     }
-    else if (taxableIncome <= 80000) {
-        // 如果应纳税所得额在60000元到80000元之间，前500元适用5%，接下来1500元适用10%，接下来的3000元适用15%，接下来的15000元适用20%，接下来的20000元适用25%，接下来的20000元适用30%，超出部分适用35%
-        tax = 500 * 0.05 + 1500 * 0.10 + 3000 * 0.15 + 15000 * 0.20 + 20000 * 0.25 + 20000 * 0.30 + (taxableIncome - 60000) * 0.35;
+}
+
+// calculateTaxBatch 函数重载，批量计算扣除专项扣除后的税额
+void TaxCalcCenter::calculateTaxBatch(const double* salaries, const double* deductions, double* taxes, int count)
+{
+    static MetricsCounter& calls = MetricsRegistry::instance().counter(
+        "wagestax_tax_calculations_total", "mode=\"batch_deduction\"");
+    calls.add(quint64(count));
+
+    const TaxSchedule& table = schedule();
+    for (int i = 0; i < count; ++i)
+    {
+        double taxableIncome = salaries[i] - deductions[i] - table.threshold;
+        double tax = 0;
+        for (int k = 0; k < BracketCount; ++k)
+        {
+            double candidate = taxableIncome * table.rate[k] - table.quickDeduction[k];
+            tax = candidate > tax ? candidate : tax;
+        }
+        taxes[i] = tax;
     }
-    else if (taxableIncome <= 100000) {
-        // 如果应纳税所得额在80000元到100000元之间，前500元适用5%，接下来1500元适用10%，接下来的3000元适用15%，接下来的15000元适用20%，接下来的20000元适用25%，接下来的20000元适用30%，接下来的20000元适用35%，超出部分适用40%
-        tax = 500 * 0.05 + 1500 * 0.10 + 3000 * 0.15 + 15000 * 0.20 + 20000 * 0.25 + 20000 * 0.30 + 20000 * 0.35 + (taxableIncome - 80000) * 0.40;
+}
+
+// calculateBonusTaxBatch 函数批量计算全年一次性奖金的税额
+void TaxCalcCenter::calculateBonusTaxBatch(const double* bonuses, double* taxes, int count)
+{
+    static MetricsCounter& calls = MetricsRegistry::instance().counter(
+        "wagestax_tax_calculations_total", "mode=\"bonus\"");
+    calls.add(quint64(count));
+
+    const TaxSchedule& table = schedule();
+    for (int i = 0; i < count; ++i)
+    {
+        // 月均奖金超过第 k 档下限时采用第 k 档，各档依次覆盖，最后留下的就是所在档位
+        const double average = bonuses[i] / 12;
+        double rate = 0;
+        double deduction = 0;
+        for (int k = 0; k < BracketCount; ++k)
+        {
+            const bool above = average > table.lower[k];
+            rate = above ? table.rate[k] : rate;
+            deduction = above ? table.quickDeduction[k] : deduction;
+        }
+        taxes[i] = bonuses[i] * rate - deduction;
     }
-    else {
-        // 如果应纳税所得额超过100000元，前500元适用5%，接下来1500元适用10%，接下来的3000元适用15%，接下来的15000元适用20%，接下来的20000元适用25%，接下来的20000元适用30%，接下来的20000元适用35%，接下来的20000元适用40%，超出部分适用45%
-        tax = 500 * 0.05 + 1500 * 0.10 + 3000 * 0.15 + 15000 * 0.20 + 20000 * 0.25 + 20000 * 0.30 + 20000 * 0.35 + 20000 * 0.40 + (taxableIncome - 100000) * 0.45;
+}
+
+// calculateAnnualTaxBatch 函数批量计算年度应纳税额，使用按 12 个月换算的税率表
+void TaxCalcCenter::calculateAnnualTaxBatch(const double* incomes, const double* deductions, double* taxes, int count)
+{
+    static MetricsCounter& calls = MetricsRegistry::instance().counter(
+        "wagestax_tax_calculations_total", "mode=\"annual\"");
+    calls.add(quint64(count));
+
+    const TaxSchedule& table = schedule();
+    const double annualThreshold = table.threshold * 12;
+    double annualDeduction[BracketCount];
+    for (int k = 0; k < BracketCount; ++k)
+    {
+        annualDeduction[k] = table.quickDeduction[k] * 12;
     }
 
-    // 返回计算出的税额
-    return tax;
+    for (int i = 0; i < count; ++i)
+    {
+        double taxableIncome = incomes[i] - deductions[i] - annualThreshold;
+        double tax = 0;
+        for (int k = 0; k < BracketCount; ++k)
+        {
+            double candidate = taxableIncome * table.rate[k] - annualDeduction[k];
+            tax = candidate > tax ? candidate : tax;
+        }
+        taxes[i] = tax;
+    }
 }
@@ -4,9 +4,14 @@
 // 引入 QObject 类头文件（尽管在当前代码中并未使用 QObject 的功能，
 // 但为了支持 Qt 的信号和槽机制、属性系统或其他 Qt 特性，可能会在后续扩展中使用）
 #include <QObject>
+#include <memory>
+#include "taxschedule.h"
 
 // TaxCalcCenter 类用于税务计算的中心，负责根据提供的工资计算税金
 // 类中有一个静态方法 calculateTax(double salary) 用于计算税金
+// 计算使用当前发布的税率表（schedule）：税率表文件变化后由 TaxScheduleWatcher 读取并通过 publishSchedule 发布，
+// 发布只是原子地替换一个指针，计算函数在开始时读取一次该指针，整个调用都使用同一份税率表，读取方从不加锁。
+// 正在进行的批量计算用旧表算完，之后开始的调用看到新表。
 class TaxCalcCenter
 {
 public:
@@ -19,6 +24,73 @@ public:
     // 该方法是静态的，意味着无需创建类的实例即可直接调用
     // 参数 salary 是输入的工资数额，返回值是计算得出的税额
     static double calculateTax(double salary);
+
+    // 静态方法 calculateTax 重载，先从工资中扣除专项扣除合计 deduction，再按起征点和税率表计税
+    static double calculateTax(double salary, double deduction);
+
+    // 静态方法 calculateTaxBatch，批量计算一组工资对应的税额
+    // 与 calculateTax 使用同一张税率表，但采用“速算扣除数”形式：
+    // 税额 = max(应纳税所得额 × 税率 - 速算扣除数)，循环体内没有分支，
+    // 编译器可以对其自动向量化，适合服务端批量请求和大批量重算
+    // 参数:
+    //   - salaries: 输入的工资数组
+    //   - taxes: 输出的税额数组（可以与 salaries 指向同一块内存，即原地计算）
+    //   - count: 数组元素个数
+    static void calculateTaxBatch(const double* salaries, double* taxes, int count);
+
+    // 静态方法 calculateTaxBatch 重载，同时读取工资数组和等长的专项扣除数组
+    // 调用方事先把每名员工的扣除合计排成与工资对齐的连续数组，循环中不需要任何查找
+    static void calculateTaxBatch(const double* salaries, const double* deductions, double* taxes, int count);
+
+    // 静态方法 calculateAnnualTaxBatch，批量计算全年综合所得对应的年度应纳税额
+    // 年度税率表由月度税率表换算：起征点、各档下限和速算扣除数均乘以 12，税率不变，
+    // 即年度税额 = 12 × 月度税额(全年收入 / 12)；与 calculateTaxBatch 相同，循环体内没有分支
+    // 参数:
+    //   - incomes: 输入的全年收入数组
+    //   - deductions: 全年专项扣除合计数组
+    //   - taxes: 输出的年度应纳税额数组（可以与 incomes 指向同一块内存）
+    //   - count: 数组元素个数
+    static void calculateAnnualTaxBatch(const double* incomes, const double* deductions, double* taxes, int count);
+
+    // 静态方法 calculateBonusTaxBatch，批量计算全年一次性奖金单独计税的税额
+    // 奖金除以 12 后按月度税率表确定税率和速算扣除数（不扣除起征点），税额 = 奖金 × 税率 - 速算扣除数。
+    // 速算扣除数只扣一次，税额在档位边界处会向上跳变（即所谓“盲区”），因此不能像月度税额那样取各档最大值，
+    // 这里用条件选择逐档覆盖税率，循环体内同样没有分支
+    // 参数:
+    //   - bonuses: 输入的奖金数组
+    //   - taxes: 输出的税额数组（可以与 bonuses 指向同一块内存）
+    //   - count: 数组元素个数
+    static void calculateBonusTaxBatch(const double* bonuses, double* taxes, int count);
+
+    // 静态方法 bracketOf，返回工资所在的税率档位，有专项扣除时传入扣除后的工资
+    // 0 表示未达起征点（不纳税），1 ~ BracketCount 对应税率表的第 1 ~ 9 档
+    // 档位分布统计（包括 SQLite 触发器）按内置税率表划分，不随热加载变化
+    static int bracketOf(double salary);
+
+    // 静态方法 schedule，返回当前发布的税率表，尚未发布时为内置税率表
+    // 只有一次原子读取，不加锁；返回的引用在进程结束前一直有效
+    static const TaxSchedule& schedule();
+
+    // 静态方法 publishSchedule，发布新的税率表并返回其发布序号
+    // 发布后 next 不能再被修改；被替换的旧表不会释放，仍在使用它的计算线程可以安全地算完
+    static int publishSchedule(std::shared_ptr<TaxSchedule> next);
+
+    // 以下为内置税率表，税率表文件不存在时使用
+
+    // 起征点（元）
+    static const double Threshold;
+
+    // 税率表的档位数量
+    static const int BracketCount = TaxSchedule::BracketCount;
+
+    // 每一档的下限（应纳税所得额，元）
+    static const double BracketLower[BracketCount];
+
+    // 每一档的税率
+    static const double BracketRate[BracketCount];
+
+    // 每一档的速算扣除数，由 BracketLower 和 BracketRate 推导得到
+    static const double QuickDeduction[BracketCount];
 };
 
 // 预处理指令的结尾，表示头文件结束
@@ -0,0 +1,150 @@
+﻿#include "taxschedule.h"
+#include "taxcalccenter.h"  // 内置税率表与发布
+#include "watchedfile.h"    // 文件热加载监视
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+// 默认的税率表文件
+QString TaxSchedule::defaultPath()
+{
+    return "tax_schedule.json";
+}
+
+// 内置税率表
+TaxSchedule TaxSchedule::builtIn()
+{
+    TaxSchedule schedule;
+    schedule.threshold = TaxCalcCenter::Threshold;
+    for (int k = 0; k < BracketCount; ++k)
+    {
+        schedule.lower[k] = TaxCalcCenter::BracketLower[k];
+        schedule.rate[k] = TaxCalcCenter::BracketRate[k];
+    }
+    schedule.deriveQuickDeductions();
+    return schedule;
+}
+
+// 速算扣除数：第 k 档 = 第 k-1 档速算扣除数 + 第 k 档下限 × (第 k 档税率 - 第 k-1 档税率)
+void TaxSchedule::deriveQuickDeductions()
+{
+    quickDeduction[0] = lower[0] * rate[0];
+    for (int k = 1; k < BracketCount; ++k)
+    {
+        quickDeduction[k] = quickDeduction[k - 1] + lower[k] * (rate[k] - rate[k - 1]);
+    }
+}
+
+// 从文件读取
+std::shared_ptr<TaxSchedule> TaxSchedule::load(const QString& path, QString* error)
+{
+    auto fail = [&](const QString& message) {
+        qDebug() << "Tax schedule" << path << ":" << message;
+        if (error)
+        {
+            *error = message;
+        }
+        return std::shared_ptr<TaxSchedule>();
+    };
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return fail(file.errorString());
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (document.isNull())
+    {
+        return fail(parseError.errorString());
+    }
+
+    QJsonObject object = document.object();
+    QJsonArray brackets = object.value("brackets").toArray();
+    if (!object.value("threshold").isDouble() || object.value("threshold").toDouble() < 0)
+    {
+        return fail("invalid threshold");
+    }
+    if (brackets.size() != BracketCount)
+    {
+        return fail(QString("expected %1 brackets, got %2").arg(BracketCount).arg(brackets.size()));
+    }
+
+    std::shared_ptr<TaxSchedule> schedule = std::make_shared<TaxSchedule>();
+    schedule->threshold = object.value("threshold").toDouble();
+    for (int k = 0; k < BracketCount; ++k)
+    {
+        QJsonArray pair = brackets[k].toArray();
+        if (pair.size() != 2 || !pair[0].isDouble() || !pair[1].isDouble())
+        {
+            return fail(QString("invalid bracket #%1").arg(k + 1));
+        }
+        schedule->lower[k] = pair[0].toDouble();
+        schedule->rate[k] = pair[1].toDouble();
+
+        const bool ordered = k == 0
+            ? schedule->lower[0] == 0
+            : schedule->lower[k] > schedule->lower[k - 1] && schedule->rate[k] >= schedule->rate[k - 1];
+        if (!ordered || schedule->rate[k] < 0 || schedule->rate[k] >= 1)
+        {
+            return fail(QString("bracket #%1 out of order").arg(k + 1));
+        }
+    }
+    schedule->deriveQuickDeductions();
+    schedule->source = path;
+    return schedule;
+}
+
+// TaxScheduleWatcher 构造函数
+TaxScheduleWatcher::TaxScheduleWatcher(const QString& path, QObject* parent)
+    : QObject(parent)
+    , path(path)
+    , file(new WatchedFile(path, this))
+{
+    connect(file, &WatchedFile::changed, this, &TaxScheduleWatcher::onFileChanged);
+}
+
+// 读取一次并开始监视
+void TaxScheduleWatcher::start()
+{
+    file->start();
+    if (QFileInfo::exists(path))
+    {
+        reload();
+    }
+    else
+    {
+        qDebug() << "Tax schedule" << path << "not found, using the built-in schedule";
+    }
+}
+
+// 税率表文件发生变化：被删除时继续使用当前税率表，被修改、创建或替换时重新读取
+void TaxScheduleWatcher::onFileChanged()
+{
+    if (QFileInfo::exists(path))
+    {
+        reload();
+    }
+}
+
+// 重新读取并发布
+void TaxScheduleWatcher::reload()
+{
+    file->markLoaded();
+
+    QString error;
+    std::shared_ptr<TaxSchedule> schedule = TaxSchedule::load(path, &error);
+    if (!schedule)
+    {
+        emit reloadFailed(error);
+        return;
+    }
+
+    const int version = TaxCalcCenter::publishSchedule(schedule);
+    qDebug() << "Tax schedule" << path << "published as version" << version;
+    emit scheduleChanged(version);
+}
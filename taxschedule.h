@@ -0,0 +1,83 @@
+﻿#ifndef TAXSCHEDULE_H
+#define TAXSCHEDULE_H
+
+#include <QObject>
+#include <QString>
+#include <memory>
+
+class WatchedFile;
+
+// TaxSchedule 结构体是一份完整的税率表：起征点、各档下限、税率和由它们推导出的速算扣除数。
+// 发布给 TaxCalcCenter 之后不再修改，计算线程读到的始终是一份完整、一致的表。
+// 档位数量固定为 BracketCount，工资汇总面板的档位分布和 SQLite 触发器都按这个数量建表。
+struct TaxSchedule
+{
+    // 税率表的档位数量
+    static const int BracketCount = 9;
+
+    double threshold = 0;                    // 起征点
+    double lower[BracketCount] = {};         // 每一档的下限（应纳税所得额）
+    double rate[BracketCount] = {};          // 每一档的税率
+    double quickDeduction[BracketCount] = {}; // 每一档的速算扣除数
+    QString source;                          // 来源文件，内置税率表为空
+    int version = 0;                         // 发布序号，内置税率表为 0
+
+    // 默认的税率表文件
+    static QString defaultPath();
+
+    // 内置税率表，与 TaxCalcCenter 的 Threshold、BracketLower、BracketRate 一致
+    static TaxSchedule builtIn();
+
+    // load 函数从 JSON 文件读取税率表，格式为 {"threshold": 1600, "brackets": [[0, 0.05], [500, 0.10], ...]}
+    // 档位数量必须等于 BracketCount，第一档下限为 0，下限严格递增，税率不递减（批量计税依赖税额是凸函数）
+    // 参数:
+    //   - path: 文件路径
+    //   - error: 失败时写入原因（可以为空）
+    // 返回值：成功时为新的税率表，失败时为空
+    static std::shared_ptr<TaxSchedule> load(const QString& path, QString* error = nullptr);
+
+    // 由 lower 和 rate 推导速算扣除数
+    void deriveQuickDeductions();
+};
+
+// TaxScheduleWatcher 类监视税率表文件（见 WatchedFile），文件变化后重新读取并发布给 TaxCalcCenter，不需要重启进程。
+// 文件被删除或读取失败时保留当前税率表。
+// 对象所在的线程需要运行事件循环；计算线程阻塞运行的进程（如共享内存计算引擎）可以把它移到单独的 QThread 中。
+class TaxScheduleWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 构造函数
+    // 参数:
+    //   - path: 税率表文件路径
+    //   - parent: 父对象
+    explicit TaxScheduleWatcher(const QString& path = TaxSchedule::defaultPath(), QObject* parent = nullptr);
+
+public slots:
+    // 文件存在时立即读取一次，然后开始监视
+    void start();
+
+    // 立即重新读取
+    void reload();
+
+signals:
+    // 新的税率表已发布
+    void scheduleChanged(int version);
+
+    // 重新读取失败，仍使用原来的税率表
+    void reloadFailed(const QString& error);
+
+private slots:
+    // 税率表文件发生变化
+    void onFileChanged();
+
+private:
+    // 税率表文件路径
+    QString path;
+
+    // 税率表文件监视
+    WatchedFile* file;
+};
+
+#endif // TAXSCHEDULE_H
@@ -0,0 +1,747 @@
+﻿#include "taxserver.h"
+#include "taxcalccenter.h"  // 税额计算（单条与批量）
+#include "sharedtaxring.h"  // 共享内存批量计税
+#include "taxschedule.h"    // 税率表热加载
+#include "tracerecorder.h"  // 时间线区间
+#include "configstore.h"    // 配置文件
+#include "employeestore.h"  // 数据库路径
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QThreadPool>
+#include <QVariant>
+#include <QtConcurrent>
+#include <QtEndian>
+#include <atomic>
+#include <cstring>
+
+namespace
+{
+    // 从缓冲区读取小端序整数
+    quint32 readU32(const char* data)
+    {
+        return qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(data));
+    }
+
+    // 从缓冲区读取小端序 double
+    double readDouble(const char* data)
+    {
+        quint64 bits = qFromLittleEndian<quint64>(reinterpret_cast<const uchar*>(data));
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // 向缓冲区追加小端序整数
+    void appendU32(QByteArray& buffer, quint32 value)
+    {
+        uchar bytes[4];
+        qToLittleEndian<quint32>(value, bytes);
+        buffer.append(reinterpret_cast<const char*>(bytes), 4);
+    }
+
+    // 把 double 编码为 8 字节小端序
+    void encodeDouble(double value, char* out)
+    {
+        quint64 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        qToLittleEndian<quint64>(bits, reinterpret_cast<uchar*>(out));
+    }
+
+    // 向缓冲区追加小端序 double
+    void appendDouble(QByteArray& buffer, double value)
+    {
+        char bytes[8];
+        encodeDouble(value, bytes);
+        buffer.append(bytes, 8);
+    }
+
+    // 追加一帧错误应答
+    void appendError(QByteArray& reply, quint32 requestId, const QString& message)
+    {
+        QByteArray text = message.toUtf8();
+        QByteArray payload;
+        appendU32(payload, text.size());
+        payload.append(text);
+        TaxProtocol::appendFrame(reply, TaxProtocol::Error, requestId, payload.constData(), payload.size());
+    }
+
+    // 监听 TCP 端口，新连接不在主线程创建套接字，而是把描述符交给工作线程
+    class TaxTcpListener : public QTcpServer
+    {
+    public:
+        explicit TaxTcpListener(TaxServer* server) : QTcpServer(server), server(server) {}
+
+    protected:
+        void incomingConnection(qintptr descriptor) override
+        {
+            server->dispatch(quintptr(descriptor), false);
+        }
+
+    private:
+        TaxServer* server;
+    };
+
+    // 监听本地套接字，处理方式与 TaxTcpListener 相同
+    class TaxLocalListener : public QLocalServer
+    {
+    public:
+        explicit TaxLocalListener(TaxServer* server) : QLocalServer(server), server(server) {}
+
+    protected:
+        void incomingConnection(quintptr descriptor) override
+        {
+            server->dispatch(descriptor, true);
+        }
+
+    private:
+        TaxServer* server;
+    };
+}
+
+// 向 buffer 末尾追加一帧
+void TaxProtocol::appendFrame(QByteArray& buffer, quint8 opcode, quint32 requestId, const char* payload, int payloadSize)
+{
+    appendU32(buffer, quint32(1 + 4 + payloadSize));  // 长度不含长度字段自身
+    buffer.append(char(opcode));
+    appendU32(buffer, requestId);
+    buffer.append(payload, payloadSize);
+}
+
+// TaxServerWorker 构造函数
+TaxServerWorker::TaxServerWorker(int index, const QString& databasePath)
+    : index(index)
+    , databasePath(databasePath)
+    , connectionName(QString("taxserver_worker_%1").arg(index))
+{
+
+}
+
+// TaxServerWorker 析构函数，关闭本线程的数据库连接
+TaxServerWorker::~TaxServerWorker()
+{
+    if (QSqlDatabase::contains(connectionName))
+    {
+        QSqlDatabase::database(connectionName, false).close();
+        QSqlDatabase::removeDatabase(connectionName);
+    }
+}
+
+// 在工作线程中接管连接
+void TaxServerWorker::acceptConnection(quintptr descriptor, bool local)
+{
+    QIODevice* device = nullptr;
+
+    if (local)
+    {
+        QLocalSocket* socket = new QLocalSocket(this);
+        if (!socket->setSocketDescriptor(descriptor))
+        {
+            qDebug() << "Worker" << index << "failed to adopt local socket:" << socket->errorString();
+            delete socket;
+            return;
+        }
+        connect(socket, &QLocalSocket::disconnected, this, &TaxServerWorker::onDisconnected);
+        device = socket;
+    }
+    else
+    {
+        QTcpSocket* socket = new QTcpSocket(this);
+        if (!socket->setSocketDescriptor(qintptr(descriptor)))
+        {
+            qDebug() << "Worker" << index << "failed to adopt tcp socket:" << socket->errorString();
+            delete socket;
+            return;
+        }
+        // 应答已经在应用层合并成大块写出，关闭 Nagle 以降低小请求的延迟
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        connect(socket, &QTcpSocket::disconnected, this, &TaxServerWorker::onDisconnected);
+        device = socket;
+    }
+
+    pending.insert(device, QByteArray());
+    connect(device, &QIODevice::readyRead, this, &TaxServerWorker::onReadyRead);
+}
+
+// 读取所有可用数据，处理完整的帧后一次性写回应答
+void TaxServerWorker::onReadyRead()
+{
+    QIODevice* device = qobject_cast<QIODevice*>(sender());
+    if (!device)
+    {
+        return;
+    }
+
+    QByteArray& buffer = pending[device];
+    buffer.append(device->readAll());
+
+    QByteArray reply;
+    if (!processFrames(buffer, reply))
+    {
+        qDebug() << "Worker" << index << "received a malformed frame, closing connection.";
+        device->close();
+        return;
+    }
+
+    if (!reply.isEmpty())
+    {
+        device->write(reply);
+    }
+}
+
+// 连接断开时释放缓冲区和套接字
+void TaxServerWorker::onDisconnected()
+{
+    QIODevice* device = qobject_cast<QIODevice*>(sender());
+    if (!device)
+    {
+        return;
+    }
+
+    pending.remove(device);
+    device->deleteLater();
+}
+
+// 解析并处理 buffer 中所有完整的帧
+// 连续的单条计算请求会先收集起来，再调用一次批量计算，最后按原顺序写出应答
+bool TaxServerWorker::processFrames(QByteArray& buffer, QByteArray& reply)
+{
+    TraceSpan span("TaxServerWorker::processFrames", "worker");
+
+    // 第一遍：找出所有完整的帧，收集单条计算请求的工资
+    struct Frame
+    {
+        quint8 opcode;
+        quint32 requestId;
+        int payloadOffset;
+        int payloadSize;
+    };
+    std::vector<Frame> frames;
+    salaries.clear();
+
+    const char* data = buffer.constData();
+    int offset = 0;
+    while (buffer.size() - offset >= TaxProtocol::HeaderSize)
+    {
+        quint32 length = readU32(data + offset);
+        if (length < 5 || length > TaxProtocol::MaxFrameSize)
+        {
+            return false;
+        }
+        if (quint32(buffer.size() - offset - 4) < length)
+        {
+            break;  // 帧还没有接收完整
+        }
+
+        Frame frame;
+        frame.opcode = quint8(data[offset + 4]);
+        frame.requestId = readU32(data + offset + 5);
+        frame.payloadOffset = offset + TaxProtocol::HeaderSize;
+        frame.payloadSize = int(length) - 5;
+        frames.push_back(frame);
+
+        if (frame.opcode == TaxProtocol::Calculate && frame.payloadSize == 8)
+        {
+            salaries.push_back(readDouble(data + frame.payloadOffset));
+        }
+
+        offset += 4 + int(length);
+    }
+
+    // 单条计算请求合并成一次批量计算
+    taxes.resize(salaries.size());
+    TaxCalcCenter::calculateTaxBatch(salaries.data(), taxes.data(), int(salaries.size()));
+
+    // 第二遍：按接收顺序生成应答
+    reply.reserve(int(frames.size()) * (TaxProtocol::HeaderSize + 8));
+    size_t nextTax = 0;
+    for (const Frame& frame : frames)
+    {
+        const char* payload = data + frame.payloadOffset;
+
+        switch (frame.opcode)
+        {
+        case TaxProtocol::Calculate:
+        {
+            if (frame.payloadSize != 8)
+            {
+                appendError(reply, frame.requestId, "Calculate expects one double");
+                break;
+            }
+            char value[8];
+            encodeDouble(taxes[nextTax++], value);
+            TaxProtocol::appendFrame(reply, TaxProtocol::Calculate, frame.requestId, value, 8);
+            break;
+        }
+        case TaxProtocol::BatchCalculate:
+        {
+            quint32 count = frame.payloadSize >= 4 ? readU32(payload) : 0;
+            if (frame.payloadSize < 4 || quint64(frame.payloadSize) != 4 + quint64(count) * 8)
+            {
+                appendError(reply, frame.requestId, "BatchCalculate payload size mismatch");
+                break;
+            }
+
+            // 线路上是小端序，先解码到连续数组再调用批量计算
+            std::vector<double> batch(count);
+            for (quint32 i = 0; i < count; ++i)
+            {
+                batch[i] = readDouble(payload + 4 + i * 8);
+            }
+            TaxCalcCenter::calculateTaxBatch(batch.data(), batch.data(), int(count));
+
+            QByteArray values;
+            values.reserve(int(4 + count * 8));
+            appendU32(values, count);
+            for (quint32 i = 0; i < count; ++i)
+            {
+                appendDouble(values, batch[i]);
+            }
+            TaxProtocol::appendFrame(reply, TaxProtocol::BatchCalculate, frame.requestId, values.constData(), values.size());
+            break;
+        }
+        case TaxProtocol::LookupEmployee:
+        {
+            if (frame.payloadSize != 4)
+            {
+                appendError(reply, frame.requestId, "LookupEmployee expects one int32");
+                break;
+            }
+            lookupEmployee(frame.requestId, qint32(readU32(payload)), reply);
+            break;
+        }
+        default:
+            appendError(reply, frame.requestId, QString("Unknown opcode %1").arg(frame.opcode));
+            break;
+        }
+    }
+
+    // 丢弃已经处理的数据，保留不完整的帧
+    buffer.remove(0, offset);
+    return true;
+}
+
+// 按员工 ID 查询员工信息
+void TaxServerWorker::lookupEmployee(quint32 requestId, qint32 employeeId, QByteArray& reply)
+{
+    if (!ensureDatabase())
+    {
+        appendError(reply, requestId, "Database unavailable");
+        return;
+    }
+
+    QSqlQuery query(QSqlDatabase::database(connectionName, false));
+    query.prepare("SELECT id, name, salary, tax FROM employees WHERE id = ?");
+    query.addBindValue(employeeId);
+
+    if (!query.exec())
+    {
+        appendError(reply, requestId, query.lastError().text());
+        return;
+    }
+
+    QByteArray payload;
+    if (query.next())
+    {
+        QByteArray name = query.value(1).toString().toUtf8();
+        payload.append(char(1));
+        appendU32(payload, quint32(query.value(0).toInt()));
+        appendDouble(payload, query.value(2).toDouble());
+        appendDouble(payload, query.value(3).toDouble());
+        appendU32(payload, name.size());
+        payload.append(name);
+    }
+    else
+    {
+        payload.append(char(0));
+    }
+    TaxProtocol::appendFrame(reply, TaxProtocol::LookupEmployee, requestId, payload.constData(), payload.size());
+}
+
+// 打开本线程的数据库连接
+bool TaxServerWorker::ensureDatabase()
+{
+    if (QSqlDatabase::contains(connectionName))
+    {
+        return QSqlDatabase::database(connectionName, false).isOpen();
+    }
+
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    db.setDatabaseName(databasePath);
+    // 服务端只读，避免与图形界面进程的写操作争用
+    db.setConnectOptions("QSQLITE_OPEN_READONLY");
+    if (!db.open())
+    {
+        qDebug() << "Worker" << index << "failed to open database:" << db.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+// TaxServer 构造函数，创建并启动工作线程
+TaxServer::TaxServer(int workerCount, const QString& databasePath, QObject* parent)
+    : QObject(parent)
+{
+    if (workerCount <= 0)
+    {
+        workerCount = qMax(1, QThread::idealThreadCount());
+    }
+
+    for (int i = 0; i < workerCount; ++i)
+    {
+        QThread* thread = new QThread(this);
+        thread->setObjectName(QString("taxserver worker %1").arg(i));
+        TaxServerWorker* worker = new TaxServerWorker(i, databasePath);
+        worker->moveToThread(thread);
+        connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+        thread->start();
+
+        threads.append(thread);
+        workers.append(worker);
+    }
+
+    qDebug() << "Tax server started with" << workerCount << "workers.";
+}
+
+// TaxServer 析构函数，等待工作线程退出
+TaxServer::~TaxServer()
+{
+    for (QThread* thread : threads)
+    {
+        thread->quit();
+    }
+    for (QThread* thread : threads)
+    {
+        thread->wait();
+    }
+}
+
+// 监听 TCP 端口
+bool TaxServer::listenTcp(quint16 port)
+{
+    tcpServer = new TaxTcpListener(this);
+    if (!tcpServer->listen(QHostAddress::Any, port))
+    {
+        qDebug() << "Failed to listen on tcp port" << port << ":" << tcpServer->errorString();
+        return false;
+    }
+    qDebug() << "Tax server listening on tcp port" << tcpServer->serverPort();
+    return true;
+}
+
+// 监听本地套接字
+bool TaxServer::listenLocal(const QString& name)
+{
+    // 清理上次异常退出遗留的套接字文件
+    QLocalServer::removeServer(name);
+
+    localServer = new TaxLocalListener(this);
+    if (!localServer->listen(name))
+    {
+        qDebug() << "Failed to listen on local socket" << name << ":" << localServer->errorString();
+        return false;
+    }
+    qDebug() << "Tax server listening on local socket" << localServer->fullServerName();
+    return true;
+}
+
+// 把新连接轮流分配给工作线程
+void TaxServer::dispatch(quintptr descriptor, bool local)
+{
+    TaxServerWorker* worker = workers.at(nextWorker);
+    nextWorker = (nextWorker + 1) % workers.size();
+
+    // 在工作线程的事件循环中创建套接字，之后该连接的所有读写都在这个线程完成
+    QMetaObject::invokeMethod(worker, [worker, descriptor, local]() {
+        worker->acceptConnection(descriptor, local);
+        }, Qt::QueuedConnection);
+}
+
+// 判断是否以无界面模式运行
+bool TaxServer::isServiceInvocation(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--server") == 0 || std::strcmp(argv[i], "--loadgen") == 0
+            || std::strcmp(argv[i], "--shm-engine") == 0 || std::strcmp(argv[i], "--shm-loadgen") == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 按命令行参数运行服务端或压测客户端
+int TaxServer::runFromCommandLine(const QStringList& arguments)
+{
+    // 读取 "--name value" 形式的参数
+    auto option = [&arguments](const QString& name, const QString& defaultValue) {
+        int index = arguments.indexOf(name);
+        return index >= 0 && index + 1 < arguments.size() ? arguments.at(index + 1) : defaultValue;
+    };
+
+    if (arguments.contains("--loadgen"))
+    {
+        TaxLoadClient::Options options;
+        options.endpoint = option("--loadgen", "tcp:127.0.0.1:7000");
+        options.connections = option("--connections", "4").toInt();
+        options.requests = option("--requests", "1000000").toLongLong();
+        options.pipeline = option("--pipeline", "256").toInt();
+        options.batch = option("--batch", "0").toInt();
+        return TaxLoadClient::run(options);
+    }
+
+    // 服务端与界面读取同一份配置，--db 默认使用配置的 storage_path（命令行 --storage-path 优先）
+    ConfigStore::instance().load();
+    EmployeeStore::loadConfiguration(arguments);
+
+    // 税率表在单独的线程中监视：共享内存计算引擎阻塞运行在主线程上，没有事件循环。
+    // 文件变化后新表原子地发布，计算线程不暂停，下一批即使用新表
+    QThread scheduleThread;
+    TaxScheduleWatcher* scheduleWatcher = new TaxScheduleWatcher(option("--tax-schedule", TaxSchedule::defaultPath()));
+    scheduleWatcher->moveToThread(&scheduleThread);
+    QObject::connect(&scheduleThread, &QThread::finished, scheduleWatcher, &QObject::deleteLater);
+    scheduleThread.start();
+
+    // 等待第一次读取完成，开始服务之前税率表已经就绪
+    QMetaObject::invokeMethod(scheduleWatcher, "start", Qt::BlockingQueuedConnection);
+
+    // 任一分支返回时停止监视线程
+    struct ThreadStopper
+    {
+        QThread& thread;
+        ~ThreadStopper() { thread.quit(); thread.wait(); }
+    } stopper{ scheduleThread };
+
+    if (arguments.contains("--shm-engine"))
+    {
+        SharedTaxEngine engine(option("--shm-engine", "wagestax_ring"),
+            option("--slots", "16").toInt(), option("--slot-capacity", "65536").toInt());
+        if (!engine.create())
+        {
+            return -1;
+        }
+        engine.run();
+        return 0;
+    }
+
+    if (arguments.contains("--shm-loadgen"))
+    {
+        return SharedTaxClient::runLoad(option("--shm-loadgen", "wagestax_ring"), option("--requests", "10000000").toLongLong());
+    }
+
+    QString endpoint = option("--server", "tcp:7000");
+    TaxServer server(option("--workers", "0").toInt(), option("--db", EmployeeStore::path()));
+
+    bool listening = false;
+    if (endpoint.startsWith("local:"))
+    {
+        listening = server.listenLocal(endpoint.mid(6));
+    }
+    else
+    {
+        listening = server.listenTcp(quint16(endpoint.section(':', -1).toUInt()));
+    }
+
+    if (!listening)
+    {
+        return -1;
+    }
+    return QCoreApplication::exec();
+}
+
+// 压测客户端：每条连接在线程池中独立运行，使用阻塞式读写
+int TaxLoadClient::run(const Options& options)
+{
+    const int connections = qMax(1, options.connections);
+    const int pipeline = qMax(1, options.pipeline);
+    const int batch = qMax(0, options.batch);
+
+    std::atomic<qint64> completed(0);
+    std::atomic<int> failures(0);
+    std::atomic<qint64> errorFrames(0);
+
+    // 一个已发送、等待应答的请求
+    struct SentRequest
+    {
+        quint8 opcode;
+        quint32 requestId;
+        int count;        // 携带的工资个数
+    };
+
+    // 单条连接的压测过程
+    auto runConnection = [&](int connectionIndex) {
+        QScopedPointer<QIODevice> device;
+        if (options.endpoint.startsWith("local:"))
+        {
+            QLocalSocket* socket = new QLocalSocket();
+            device.reset(socket);
+            socket->connectToServer(options.endpoint.mid(6));
+            if (!socket->waitForConnected(5000))
+            {
+                qDebug() << "Connection" << connectionIndex << "failed:" << socket->errorString();
+                ++failures;
+                return;
+            }
+        }
+        else
+        {
+            QTcpSocket* socket = new QTcpSocket();
+            device.reset(socket);
+            socket->connectToHost(options.endpoint.section(':', 1, 1), quint16(options.endpoint.section(':', 2, 2).toUInt()));
+            if (!socket->waitForConnected(5000))
+            {
+                qDebug() << "Connection" << connectionIndex << "failed:" << socket->errorString();
+                ++failures;
+                return;
+            }
+            socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        }
+
+        qint64 remaining = options.requests;
+        quint32 requestId = 0;
+
+        QByteArray request;
+        QByteArray payload;
+        QByteArray received;
+        std::vector<SentRequest> sent;
+        while (remaining > 0)
+        {
+            // 一轮连续发送 pipeline 个请求
+            request.clear();
+            sent.clear();
+            while (int(sent.size()) < pipeline && remaining > 0)
+            {
+                payload.clear();
+                if (batch > 0)
+                {
+                    // 最后一个请求只发送剩余的数量，总数不超过 --requests
+                    const int count = int(qMin<qint64>(batch, remaining));
+                    appendU32(payload, quint32(count));
+                    for (int i = 0; i < count; ++i)
+                    {
+                        appendDouble(payload, 3000.0 + double((requestId * 131 + i * 17) % 50000));
+                    }
+                    TaxProtocol::appendFrame(request, TaxProtocol::BatchCalculate, requestId, payload.constData(), payload.size());
+                    sent.push_back({ TaxProtocol::BatchCalculate, requestId, count });
+                    remaining -= count;
+                }
+                else
+                {
+                    appendDouble(payload, 3000.0 + double((requestId * 131) % 50000));
+                    TaxProtocol::appendFrame(request, TaxProtocol::Calculate, requestId, payload.constData(), payload.size());
+                    sent.push_back({ TaxProtocol::Calculate, requestId, 1 });
+                    remaining -= 1;
+                }
+                ++requestId;
+            }
+            device->write(request);
+
+            // 等待本轮所有应答到齐：服务端按发送顺序应答，逐帧核对请求号和操作码
+            // 错误帧单独计数，不算作完成的计算；已解析的帧随即丢弃，缓冲区不随 pipeline × batch 增长
+            size_t next = 0;
+            qint64 values = 0;
+            while (next < sent.size())
+            {
+                if (device->bytesAvailable() == 0 && !device->waitForReadyRead(5000))
+                {
+                    qDebug() << "Connection" << connectionIndex << "timed out waiting for replies.";
+                    ++failures;
+                    return;
+                }
+                received.append(device->readAll());
+
+                const char* data = received.constData();
+                int offset = 0;
+                while (next < sent.size() && received.size() - offset >= TaxProtocol::HeaderSize)
+                {
+                    const quint32 length = readU32(data + offset);
+                    if (length < 5 || length > TaxProtocol::MaxFrameSize)
+                    {
+                        qDebug() << "Connection" << connectionIndex << "received a malformed reply frame.";
+                        ++failures;
+                        return;
+                    }
+                    if (quint32(received.size() - offset - 4) < length)
+                    {
+                        break;  // 帧还没有接收完整
+                    }
+
+                    const quint8 opcode = quint8(data[offset + 4]);
+                    const quint32 replyId = readU32(data + offset + 5);
+                    const char* replyPayload = data + offset + TaxProtocol::HeaderSize;
+                    const int payloadSize = int(length) - 5;
+                    const SentRequest& expected = sent[next++];
+                    offset += 4 + int(length);
+
+                    if (replyId != expected.requestId)
+                    {
+                        qDebug() << "Connection" << connectionIndex << "expected reply" << expected.requestId
+                            << "but received" << replyId;
+                        ++failures;
+                        return;
+                    }
+                    if (opcode == TaxProtocol::Error)
+                    {
+                        // 只输出第一条错误信息，其余只计数
+                        if (errorFrames.fetch_add(1) == 0 && payloadSize >= 4)
+                        {
+                            const int textSize = int(qMin<quint32>(readU32(replyPayload), quint32(payloadSize - 4)));
+                            qDebug() << "Connection" << connectionIndex << "request" << replyId << "failed:"
+                                << QString::fromUtf8(replyPayload + 4, textSize);
+                        }
+                        continue;
+                    }
+
+                    const int expectedSize = expected.opcode == TaxProtocol::BatchCalculate ? 4 + 8 * expected.count : 8;
+                    if (opcode != expected.opcode || payloadSize != expectedSize)
+                    {
+                        qDebug() << "Connection" << connectionIndex << "received an unexpected reply to request"
+                            << replyId << "opcode" << opcode << "payload" << payloadSize;
+                        ++failures;
+                        return;
+                    }
+                    values += expected.count;
+                }
+                received.remove(0, offset);
+            }
+            completed += values;
+        }
+    };
+
+    QThreadPool::globalInstance()->setMaxThreadCount(qMax(QThreadPool::globalInstance()->maxThreadCount(), connections));
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QList<QFuture<void>> futures;
+    for (int i = 0; i < connections; ++i)
+    {
+        futures.append(QtConcurrent::run([&runConnection, i]() { runConnection(i); }));
+    }
+    for (QFuture<void>& future : futures)
+    {
+        future.waitForFinished();
+    }
+
+    const double seconds = timer.nsecsElapsed() / 1e9;
+    const qint64 total = completed.load();
+    qDebug() << "Load test finished:"
+        << "connections" << connections
+        << "pipeline" << pipeline
+        << "batch" << batch
+        << "calculations" << total
+        << "error frames" << errorFrames.load()
+        << "seconds" << seconds
+        << "calculations/s" << (seconds > 0 ? qint64(total / seconds) : 0);
+
+    // 错误应答同样视为压测失败，否则吞吐量里会混入服务端拒绝的请求
+    return failures.load() == 0 && errorFrames.load() == 0 ? 0 : -1;
+}
@@ -0,0 +1,166 @@
+﻿#ifndef TAXSERVER_H
+#define TAXSERVER_H
+
+// 引入 QObject，服务端和工作线程都依赖 Qt 的信号槽机制
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QSqlDatabase>
+#include <QStringList>
+#include <vector>
+
+class QIODevice;
+class QThread;
+class QTcpServer;
+class QLocalServer;
+
+// TaxProtocol 命名空间描述税务计算服务的二进制协议
+// 每一帧的格式（全部为小端序）：
+//   [quint32 长度（不含自身）][quint8 操作码][quint32 请求号][负载]
+// 客户端可以连续发送多帧而不等待应答（流水线），服务端按接收顺序回复，应答携带相同的请求号
+namespace TaxProtocol
+{
+    // 操作码
+    enum Opcode : quint8
+    {
+        Calculate = 1,        // 负载：double 工资；应答：double 税额
+        BatchCalculate = 2,   // 负载：quint32 个数 + 个数 × double；应答：quint32 个数 + 个数 × double
+        LookupEmployee = 3,   // 负载：qint32 员工ID；应答：quint8 是否找到 [+ qint32 ID + double 工资 + double 税额 + quint32 字节数 + UTF-8 姓名]
+        Error = 0xFF          // 应答：quint32 字节数 + UTF-8 错误信息
+    };
+
+    // 帧头长度：长度字段 4 字节 + 操作码 1 字节 + 请求号 4 字节
+    const int HeaderSize = 9;
+
+    // 单帧最大长度，超过则认为客户端数据异常并断开连接
+    const quint32 MaxFrameSize = 64 * 1024 * 1024;
+
+    // 向 buffer 末尾追加一帧
+    void appendFrame(QByteArray& buffer, quint8 opcode, quint32 requestId, const char* payload, int payloadSize);
+}
+
+// TaxServerWorker 类运行在独立线程中，负责若干客户端连接的读写和计算
+// 每个工作线程拥有自己的数据库连接，互不加锁
+class TaxServerWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 构造函数
+    // 参数:
+    //   - index: 工作线程序号，用于生成唯一的数据库连接名
+    //   - databasePath: 员工查询使用的数据库文件
+    TaxServerWorker(int index, const QString& databasePath);
+
+    // 析构函数，关闭本线程的数据库连接
+    ~TaxServerWorker();
+
+public slots:
+    // 在工作线程中接管一个已经建立的连接
+    // 参数:
+    //   - descriptor: 套接字描述符
+    //   - local: true 表示本地套接字（QLocalSocket），false 表示 TCP 套接字
+    void acceptConnection(quintptr descriptor, bool local);
+
+private slots:
+    // 套接字有数据可读时调用，解析所有完整的帧并批量处理
+    void onReadyRead();
+
+    // 套接字断开时调用，释放相关资源
+    void onDisconnected();
+
+private:
+    // 处理 buffer 中所有完整的帧，把应答写入 reply
+    // 返回值：false 表示数据非法，需要断开连接
+    bool processFrames(QByteArray& buffer, QByteArray& reply);
+
+    // 按员工 ID 查询，结果追加到 reply
+    void lookupEmployee(quint32 requestId, qint32 employeeId, QByteArray& reply);
+
+    // 打开本线程的数据库连接（首次查询时才打开）
+    bool ensureDatabase();
+
+    // 工作线程序号
+    int index;
+
+    // 数据库文件路径
+    QString databasePath;
+
+    // 本线程专用的数据库连接名
+    QString connectionName;
+
+    // 每个连接尚未处理完的输入数据
+    QHash<QIODevice*, QByteArray> pending;
+
+    // 批量计算的临时数组，复用以避免每次读事件都重新分配
+    std::vector<double> salaries;
+    std::vector<double> taxes;
+};
+
+// TaxServer 类负责监听 TCP 端口或本地套接字，并把新连接轮流分配给工作线程
+class TaxServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 构造函数
+    // 参数:
+    //   - workerCount: 工作线程数量，<= 0 时使用 CPU 核心数
+    //   - databasePath: 员工查询使用的数据库文件
+    TaxServer(int workerCount, const QString& databasePath, QObject* parent = nullptr);
+
+    // 析构函数，停止所有工作线程
+    ~TaxServer();
+
+    // 监听 TCP 端口
+    bool listenTcp(quint16 port);
+
+    // 监听本地套接字（Windows 命名管道或 Unix 域套接字）
+    bool listenLocal(const QString& name);
+
+    // 把新连接分配给下一个工作线程
+    void dispatch(quintptr descriptor, bool local);
+
+    // 判断命令行是否要求以服务模式或压测客户端模式运行（无需图形界面）
+    static bool isServiceInvocation(int argc, char* argv[]);
+
+    // 以命令行参数运行服务端或压测客户端，返回进程退出码
+    // 服务端：--server tcp:<端口> | local:<名称> [--workers N] [--db 路径，默认为配置的 storage_path]
+    // 客户端：--loadgen tcp:<主机>:<端口> | local:<名称> [--connections N] [--requests N] [--pipeline N] [--batch N]
+    // 共享内存计税进程：--shm-engine <名称> [--slots N] [--slot-capacity N]
+    // 共享内存压测客户端：--shm-loadgen <名称> [--requests N]
+    static int runFromCommandLine(const QStringList& arguments);
+
+private:
+    // 工作线程及其对象
+    QList<QThread*> threads;
+    QList<TaxServerWorker*> workers;
+
+    // 下一个接收连接的工作线程序号
+    int nextWorker = 0;
+
+    // 两种监听器，按需创建其中之一
+    QTcpServer* tcpServer = nullptr;
+    QLocalServer* localServer = nullptr;
+};
+
+// TaxLoadClient 类是随服务端附带的压测客户端，使用多条连接和流水线请求测量吞吐量
+class TaxLoadClient
+{
+public:
+    // 压测参数
+    struct Options
+    {
+        QString endpoint;        // tcp:<主机>:<端口> 或 local:<名称>
+        int connections = 4;     // 并发连接数
+        qint64 requests = 1000000; // 每条连接发送的计算次数（批量模式下按工资个数计）
+        int pipeline = 256;      // 每轮不等待应答连续发送的请求数
+        int batch = 0;           // > 0 时改用 BatchCalculate，每个请求携带 batch 个工资
+    };
+
+    // 执行压测并打印结果，返回进程退出码
+    static int run(const Options& options);
+};
+
+#endif // TAXSERVER_H
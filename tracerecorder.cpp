@@ -0,0 +1,205 @@
+﻿#include "tracerecorder.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QThread>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+std::atomic<bool> TraceRecorder::enabled(false);
+
+namespace
+{
+    // 一个完整区间事件
+    struct TraceEvent
+    {
+        const char* name;
+        const char* category;
+        qint64 startUs;
+        qint64 durationUs;
+    };
+
+    // 每个线程的事件缓冲区
+    // 只有所属线程写入，导出时由导出线程读取，因此每个缓冲区各带一把几乎无争用的锁
+    struct ThreadBuffer
+    {
+        int tid;
+        QString threadName;
+        QMutex mutex;
+        std::vector<TraceEvent> events;
+    };
+
+    // 进程级单调时钟，首次使用时启动一次，之后只读，多线程读取无需同步
+    const QElapsedTimer& processClock()
+    {
+        static const QElapsedTimer clock = []() {
+            QElapsedTimer timer;
+            timer.start();
+            return timer;
+        }();
+        return clock;
+    }
+
+    // 记录开始时刻（processClock 上的纳秒数），start() 写入，nowUs() 原子读取
+    std::atomic<qint64> startNs(0);
+
+    // 所有线程的缓冲区
+    // 缓冲区一旦创建就不再释放（线程退出后也保留），start() 只清空事件，
+    // 这样其他线程手里的缓冲区指针始终有效
+    QMutex buffersMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+    // 把 UTF-8 文本作为 JSON 字符串（含引号）追加到 json，转义引号、反斜杠和控制字符
+    void appendJsonString(QByteArray& json, const char* text)
+    {
+        json.append('"');
+        for (const char* p = text; *p; ++p)
+        {
+            const unsigned char c = static_cast<unsigned char>(*p);
+            if (c == '"' || c == '\\')
+            {
+                json.append('\\');
+                json.append(char(c));
+            }
+            else if (c < 0x20)
+            {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                json.append(escaped);
+            }
+            else
+            {
+                json.append(char(c));
+            }
+        }
+        json.append('"');
+    }
+
+    // 当前线程的缓冲区，首次记录时创建并注册
+    ThreadBuffer* currentBuffer()
+    {
+        thread_local ThreadBuffer* buffer = nullptr;
+        if (buffer)
+        {
+            return buffer;
+        }
+
+        std::unique_ptr<ThreadBuffer> created(new ThreadBuffer());
+        QThread* thread = QThread::currentThread();
+        bool isMainThread = QCoreApplication::instance() && thread == QCoreApplication::instance()->thread();
+        created->threadName = isMainThread ? QString("GUI")
+            : thread->objectName().isEmpty() ? QString("worker") : thread->objectName();
+        created->events.reserve(4096);
+
+        QMutexLocker locker(&buffersMutex);
+        created->tid = int(buffers.size()) + 1;
+        buffer = created.get();
+        buffers.push_back(std::move(created));
+        return buffer;
+    }
+}
+
+// 开始记录
+void TraceRecorder::start()
+{
+    {
+        QMutexLocker locker(&buffersMutex);
+        for (const std::unique_ptr<ThreadBuffer>& buffer : buffers)
+        {
+            QMutexLocker bufferLocker(&buffer->mutex);
+            buffer->events.clear();
+        }
+        startNs.store(processClock().nsecsElapsed(), std::memory_order_relaxed);
+    }
+    enabled.store(true, std::memory_order_release);
+}
+
+// 停止记录
+void TraceRecorder::stop()
+{
+    enabled.store(false, std::memory_order_release);
+}
+
+// 当前时间（微秒）
+qint64 TraceRecorder::nowUs()
+{
+    return (processClock().nsecsElapsed() - startNs.load(std::memory_order_relaxed)) / 1000;
+}
+
+// 记录一个完整区间
+void TraceRecorder::addComplete(const char* name, const char* category, qint64 startUs, qint64 durationUs)
+{
+    ThreadBuffer* buffer = currentBuffer();
+    TraceEvent event = { name, category, startUs, durationUs };
+
+    QMutexLocker locker(&buffer->mutex);
+    buffer->events.push_back(event);
+}
+
+// 导出为 trace-event JSON
+// 事件数量可能很大，这里直接拼接文本而不构造 QJsonDocument
+QByteArray TraceRecorder::toJson()
+{
+    QByteArray json;
+    json.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    bool first = true;
+    auto separator = [&json, &first]() {
+        if (!first)
+        {
+            json.append(",\n");
+        }
+        first = false;
+    };
+
+    QMutexLocker locker(&buffersMutex);
+    for (const std::unique_ptr<ThreadBuffer>& buffer : buffers)
+    {
+        QMutexLocker bufferLocker(&buffer->mutex);
+        if (buffer->events.empty())
+        {
+            continue;
+        }
+
+        // 线程名称元数据，时间线中按名称显示各线程（线程名来自 objectName，需要转义）
+        separator();
+        json.append("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":");
+        json.append(QByteArray::number(buffer->tid));
+        json.append(",\"args\":{\"name\":");
+        appendJsonString(json, (buffer->threadName + ' ' + QString::number(buffer->tid)).toUtf8().constData());
+        json.append("}}");
+
+        for (const TraceEvent& event : buffer->events)
+        {
+            separator();
+            json.append("{\"ph\":\"X\",\"pid\":1,\"tid\":");
+            json.append(QByteArray::number(buffer->tid));
+            json.append(",\"name\":");
+            appendJsonString(json, event.name);
+            json.append(",\"cat\":");
+            appendJsonString(json, event.category);
+            json.append(",\"ts\":");
+            json.append(QByteArray::number(event.startUs));
+            json.append(",\"dur\":");
+            json.append(QByteArray::number(event.durationUs));
+            json.append("}");
+        }
+    }
+
+    json.append("\n]}\n");
+    return json;
+}
+
+// 导出到文件
+bool TraceRecorder::saveToFile(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        return false;
+    }
+    file.write(toJson());
+    return true;
+}
@@ -0,0 +1,71 @@
+﻿#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+
+// TraceRecorder 类记录各层（界面槽函数、SQL、渲染、工作线程）的耗时区间，
+// 导出为 Chrome / Perfetto 可以直接加载的 trace-event JSON（chrome://tracing、ui.perfetto.dev）
+// 记录关闭时，每个区间的开销只是一次原子读取；开启后事件写入各线程自己的缓冲区
+class TraceRecorder
+{
+public:
+    // 开始记录（清空之前的事件）
+    static void start();
+
+    // 停止记录
+    static void stop();
+
+    // 是否正在记录
+    static bool isEnabled()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    // 记录一个完整区间
+    // 参数:
+    //   - name / category: 必须是静态字符串（例如字符串字面量），记录时不复制
+    //   - startUs / durationUs: 相对记录开始时间的微秒数
+    static void addComplete(const char* name, const char* category, qint64 startUs, qint64 durationUs);
+
+    // 当前时间（相对记录开始，微秒）
+    static qint64 nowUs();
+
+    // 把已记录的事件导出为 trace-event JSON
+    static QByteArray toJson();
+
+    // 导出到文件
+    static bool saveToFile(const QString& path);
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+// TraceSpan 类以 RAII 方式记录一个区间：构造时开始，析构时结束
+class TraceSpan
+{
+public:
+    TraceSpan(const char* name, const char* category)
+        : name(name)
+        , category(category)
+        , startUs(TraceRecorder::isEnabled() ? TraceRecorder::nowUs() : -1)
+    {
+    }
+
+    ~TraceSpan()
+    {
+        if (startUs >= 0 && TraceRecorder::isEnabled())
+        {
+            TraceRecorder::addComplete(name, category, startUs, TraceRecorder::nowUs() - startUs);
+        }
+    }
+
+private:
+    const char* name;
+    const char* category;
+    qint64 startUs;
+};
+
+#endif // TRACERECORDER_H
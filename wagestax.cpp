@@ -3,20 +3,138 @@
 #include <QMessageBox>
 #include <qdebug.h>
 #include <stdexcept>
+#include <QTimer>
+#include "startupprofiler.h"
+#include "metricsregistry.h"
+#include "diagnosticsdialog.h"
+#include "payrolldialog.h"
+#include "paybreakdowndialog.h"
+#include "deductionsdialog.h"
+#include "changepassworddialog.h"
+#include "tracerecorder.h"
+#include "allocationtracker.h"
+#include "sqlmanager.h"
+#include "payrolldashboard.h"
+#include "salaryrankindex.h"
+#include "salarystatspanel.h"
+#include "jobscheduler.h"
+#include <QFileDialog>
+#include <QLabel>
+#include <QMenuBar>
+#include <QHBoxLayout>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QScrollBar>
+
+namespace
+{
+    // 边输入边搜索的防抖间隔（毫秒）
+    const int SearchDebounceMs = 80;
+
+    // 边输入边搜索时最多渲染的行数，超出部分只在状态栏给出总数
+    const int SearchDisplayLimit = 200;
+
+    // 排序或筛选时最多渲染的行数
+    const int SpecDisplayLimit = 1000;
+
+    // 后台重建索引使用的连接名和每页读取的行数
+    const char* IndexRebuildConnection = "wagestax_index_rebuild";
+    const int IndexRebuildPageSize = 2000;
+}
 
 // WagesTax 构造函数
-WagesTax::WagesTax(QWidget* parent)
+WagesTax::WagesTax(QWidget* parent, DatabasePreloader* preloader)
     : QMainWindow(parent)    // 调用 QMainWindow 构造函数
+    , preloader(preloader)   // 启动时传入的数据库预加载器
+    , sql(EmployeeStore::create())  // 按配置创建员工数据存储
     , ui(new Ui::WagesTax)   // 初始化 UI
 {
-    ui->setupUi(this);      // 设置 UI 界面
-    
+    {
+        StartupPhase phase("WagesTax::setupUi");
+        ui->setupUi(this);      // 设置 UI 界面
+    }
+
+    // 诊断菜单和状态栏指标
+    setupDiagnostics();
 
-    sql.createSql();        // 初始化数据库连接或创建数据库
-    on_query_clicked();     // 执行查询操作，展示员工信息
+    // 列标题排序和范围筛选
+    setupQueryControls();
+
+    // 工资汇总面板放在员工列表下方
+    dashboard = new PayrollDashboard(ui->centralwidget);
+    ui->verticalLayout_6->insertWidget(ui->verticalLayout_6->indexOf(ui->listWidget) + 1, dashboard);
+
+    // 工资分位数和排名面板放在汇总面板下方
+    statsPanel = new SalaryStatsPanel(ui->centralwidget);
+    ui->verticalLayout_6->insertWidget(ui->verticalLayout_6->indexOf(dashboard) + 1, statsPanel);
+
+    // “专项扣除”按钮放在“删除”按钮之后，编辑选中员工的扣除
+    QPushButton* deductionsButton = new QPushButton(QString::fromLocal8Bit("专项扣除"), ui->centralwidget);
+    ui->horizontalLayout_2->addWidget(deductionsButton);
+    connect(deductionsButton, &QPushButton::clicked, this, &WagesTax::editDeductions);
 
     // 连接信号和槽函数，当用户选择列表项时触发 onItemSelected() 槽函数
     connect(ui->listWidget, &QListWidget::itemSelectionChanged, this, &WagesTax::onItemSelected);
+
+    // 全部员工列表分页显示，滚动到底部时追加下一页
+    connect(ui->listWidget->verticalScrollBar(), &QScrollBar::valueChanged, this, &WagesTax::onListScrolled);
+
+    // 边输入边搜索：每次按键重新开始计时，停顿后才过滤
+    searchTimer.setSingleShot(true);
+    searchTimer.setInterval(SearchDebounceMs);
+    connect(ui->query_edit_6, &QLineEdit::textEdited, this, &WagesTax::onSearchTextEdited);
+    connect(&searchTimer, &QTimer::timeout, this, &WagesTax::applySearch);
+
+    // 存储的变化事件同步到搜索索引
+    EmployeeStoreEvents* events = EmployeeStoreEvents::instance();
+    connect(events, &EmployeeStoreEvents::employeeSaved, this, [this](int id, const QString& name, double salary, const QString& display) {
+        if (rebuildingIndexes)
+        {
+            IndexChange change;
+            change.id = id;
+            change.name = name;
+            change.salary = salary;
+            change.display = display;
+            pendingIndexChanges.push_back(change);
+        }
+        if (searchIndex)
+        {
+            searchIndex->upsert(id, name, display);
+        }
+        if (rankIndex)
+        {
+            rankIndex->upsert(id, salary);
+        }
+        });
+    connect(events, &EmployeeStoreEvents::employeeRemoved, this, [this](int id) {
+        if (rebuildingIndexes)
+        {
+            IndexChange change;
+            change.id = id;
+            change.removed = true;
+            pendingIndexChanges.push_back(change);
+        }
+        if (searchIndex)
+        {
+            searchIndex->remove(id);
+        }
+        if (rankIndex)
+        {
+            rankIndex->remove(id);
+        }
+        });
+    connect(events, &EmployeeStoreEvents::employeesReset, this, &WagesTax::rebuildIndexes);
+    connect(&indexWatcher, &QFutureWatcherBase::finished, this, &WagesTax::onIndexRebuildFinished);
+    connect(events, &EmployeeStoreEvents::employeeSaved, this, &WagesTax::refreshDashboard);
+    connect(events, &EmployeeStoreEvents::employeeRemoved, this, &WagesTax::refreshDashboard);
+    connect(events, &EmployeeStoreEvents::employeesReset, this, &WagesTax::refreshDashboard);
+
+    // 数据库打开和首次查询放到后台进行，窗口先完成绘制
+    // 数据到达之前禁用输入区域，避免在连接打开前操作数据库
+    connect(&loadWatcher, &QFutureWatcherBase::finished, this, &WagesTax::onDeferredLoadFinished);
+    ui->centralwidget->setEnabled(false);
+    ui->statusbar->showMessage(QString::fromLocal8Bit("正在加载员工数据..."));
+    QTimer::singleShot(0, this, &WagesTax::startDeferredLoad);
 }
 
 // WagesTax 析构函数
@@ -28,12 +146,473 @@ WagesTax::~WagesTax()
 // 创建 SQL 连接或初始化 SQL 操作
 void WagesTax::createSql()
 {
-    sql.createSql();  // 初始化数据库或其他 SQL 相关操作
+    sql->open();  // 初始化数据库或其他 SQL 相关操作
+}
+
+// 槽函数：等待预加载器的结果，未传入预加载器时现在才开始预热
+void WagesTax::startDeferredLoad()
+{
+    if (!preloader)
+    {
+        ownPreloader.reset(new DatabasePreloader());
+        ownPreloader->start();
+        preloader = ownPreloader.get();
+    }
+    // 预加载已经完成时，监视器会立即发出 finished 信号
+    loadWatcher.setFuture(preloader->future());
+}
+
+// 槽函数：后台加载完成，打开界面线程的默认连接并展示结果
+void WagesTax::onDeferredLoadFinished()
+{
+    TraceSpan span("WagesTax::onDeferredLoadFinished", "ui");
+    StartupPhase phase("deferred load (ui)");
+
+    // 表结构已由后台线程创建，这里只是打开连接
+    sql->open();
+
+    DatabasePreloader::State state = loadWatcher.result();
+    if (!state.opened)
+    {
+        ui->statusbar->showMessage(QString::fromLocal8Bit("数据库打开失败"));
+    }
+    searchIndex = state.searchIndex;
+    rankIndex = state.rankIndex;
+    statsPanel->setIndex(rankIndex);
+
+    // 预加载器只带回第一页，其余行滚动到底部时再读取
+    listTotal = state.employeeCount;
+    showListPage(state.employees, false);
+
+    ui->centralwidget->setEnabled(true);
+    refreshDashboard();
+}
+
+// 显示全部员工列表的第一页
+void WagesTax::showFirstPage()
+{
+    listTotal = sql->countEmployees();
+    auto page = sql->queryEmployeesAfter(0, DatabasePreloader::FirstPageSize);
+    showListPage(page, false);
+}
+
+// 显示员工列表的一页
+void WagesTax::showListPage(std::vector<std::pair<int, QString>>& page, bool append)
+{
+    if (!append)
+    {
+        // renderRows 遇到空结果直接返回，这里自行清空列表
+        ui->listWidget->clear();
+        listLastId = 0;
+    }
+    renderRows(page, append);
+
+    pagedListing = true;
+    listHasMore = int(page.size()) == DatabasePreloader::FirstPageSize;
+    if (!page.empty())
+    {
+        listLastId = page.back().first;
+    }
+    ui->statusbar->showMessage(QString::fromLocal8Bit("共 %1 名员工，已显示 %2 名").arg(listTotal).arg(ui->listWidget->count()));
+}
+
+// 列表滚动到底部时追加下一页
+void WagesTax::onListScrolled(int value)
+{
+    if (!pagedListing || !listHasMore || value < ui->listWidget->verticalScrollBar()->maximum())
+    {
+        return;
+    }
+    TraceSpan span("WagesTax::onListScrolled", "ui");
+    auto page = sql->queryEmployeesAfter(listLastId, DatabasePreloader::FirstPageSize);
+    showListPage(page, true);
+}
+
+// 槽函数：查询框内容变化
+void WagesTax::onSearchTextEdited()
+{
+    searchTimer.start();
+}
+
+// 槽函数：用前缀索引过滤列表
+void WagesTax::applySearch()
+{
+    static MetricsHistogram& searchLatency = MetricsRegistry::instance().histogram(
+        "wagestax_search_ns", QString(), "Search-as-you-type filter and render latency in nanoseconds");
+    TraceSpan span("WagesTax::applySearch", "ui");
+
+    // 索引尚未就绪，或查询框已清空时，回到原来的查询逻辑
+    QString text = ui->query_edit_6->text().trimmed();
+    if (!searchIndex || text.isEmpty())
+    {
+        on_query_clicked();
+        return;
+    }
+
+    ScopedLatency timer(searchLatency);
+    int total = 0;
+    auto result = searchIndex->search(text, SearchDisplayLimit, total);
+    if (result.empty())
+    {
+        // showResult 遇到空结果直接返回，这里自行清空列表
+        ui->listWidget->clear();
+        pagedListing = false;
+    }
+    else
+    {
+        showResult(result);
+    }
+    timer.finish();
+
+    if (total > int(result.size()))
+    {
+        ui->statusbar->showMessage(QString::fromLocal8Bit("匹配 %1 名员工，显示前 %2 名").arg(total).arg(result.size()));
+    }
+    else
+    {
+        ui->statusbar->showMessage(QString::fromLocal8Bit("匹配 %1 名员工").arg(total));
+    }
+}
+
+// 槽函数：重新构建搜索索引和工资顺序统计索引
+void WagesTax::rebuildIndexes()
+{
+    TraceSpan span("WagesTax::rebuildIndexes", "ui");
+    if (!searchIndex || !rankIndex)
+    {
+        return;
+    }
+
+    // 两个索引在后台任务中用独立连接一次读取后构建，界面线程不扫描全表；
+    // 新的重建从现在开始读取，此前记录的增删改已经包含在读取结果中
+    pendingIndexChanges.clear();
+    rebuildingIndexes = true;
+    indexWatcher.setFuture(JobScheduler::instance().run<IndexBuild>("index_rebuild", JobScheduler::Normal, []() {
+        IndexBuild build;
+        std::unique_ptr<EmployeeStore> source = EmployeeStore::create(IndexRebuildConnection);
+        DatabasePreloader::Rows rows;
+        if (source->open() && DatabasePreloader::readAll(*source, IndexRebuildPageSize, rows))
+        {
+            build.searchIndex = std::make_shared<EmployeeSearchIndex>();
+            build.searchIndex->build(rows.displays, rows.names);
+            build.rankIndex = std::make_shared<SalaryRankIndex>();
+            build.rankIndex->build(rows.salaries);
+        }
+        source->close();
+        return build;
+    }));
+}
+
+// 槽函数：后台重建的索引就绪
+void WagesTax::onIndexRebuildFinished()
+{
+    TraceSpan span("WagesTax::onIndexRebuildFinished", "ui");
+    IndexBuild build = indexWatcher.result();
+    rebuildingIndexes = false;
+    if (!build.searchIndex || !build.rankIndex)
+    {
+        // 读取失败时保留旧索引，旧索引已随增删改事件更新
+        qWarning() << "Index rebuild failed, keeping the previous indexes";
+        pendingIndexChanges.clear();
+        return;
+    }
+
+    // 重放重建开始后的增删改，新索引此时与存储一致
+    for (const IndexChange& change : pendingIndexChanges)
+    {
+        if (change.removed)
+        {
+            build.searchIndex->remove(change.id);
+            build.rankIndex->remove(change.id);
+        }
+        else
+        {
+            build.searchIndex->upsert(change.id, change.name, change.display);
+            build.rankIndex->upsert(change.id, change.salary);
+        }
+    }
+    pendingIndexChanges.clear();
+    searchIndex = build.searchIndex;
+    rankIndex = build.rankIndex;
+    statsPanel->setIndex(rankIndex);
+    statsPanel->refresh();
+}
+
+// 槽函数：刷新工资汇总面板
+void WagesTax::refreshDashboard()
+{
+    // 初次加载完成、界面线程的连接打开之前不读取
+    if (!ui->centralwidget->isEnabled())
+    {
+        return;
+    }
+    TraceSpan span("WagesTax::refreshDashboard", "ui");
+    dashboard->setSummary(sql->payrollSummary());
+    statsPanel->refresh();
+}
+
+// 创建列标题和范围筛选输入框
+void WagesTax::setupQueryControls()
+{
+    // 用可点击的列标题替换原来的静态标题
+    QWidget* header = new QWidget(ui->centralwidget);
+    QHBoxLayout* headerLayout = new QHBoxLayout(header);
+    headerLayout->setContentsMargins(0, 0, 0, 0);
+    const char* titles[] = { "ID", "Name", "Salary", "Tax" };
+    for (int key = EmployeeQuery::ById; key <= EmployeeQuery::ByTax; ++key)
+    {
+        QPushButton* button = new QPushButton(header);
+        button->setFlat(true);
+        button->setFont(ui->label_5->font());
+        button->setProperty("sortKey", key);
+        button->setProperty("title", QString(titles[key]));
+        connect(button, &QPushButton::clicked, this, &WagesTax::onSortHeaderClicked);
+        headerLayout->addWidget(button);
+        sortHeaders.push_back(button);
+    }
+    ui->verticalLayout_6->insertWidget(ui->verticalLayout_6->indexOf(ui->label_5), header);
+    ui->label_5->hide();
+    updateSortHeaders();
+
+    // 范围筛选放在查询框下方，支持 8000-12000、>0、<=5000 等写法
+    QLabel* salaryLabel = new QLabel(QString::fromLocal8Bit("工资范围"), ui->centralwidget);
+    salaryFilter = new QLineEdit(ui->centralwidget);
+    salaryFilter->setPlaceholderText("8000-12000");
+    QLabel* taxLabel = new QLabel(QString::fromLocal8Bit("税额范围"), ui->centralwidget);
+    taxFilter = new QLineEdit(ui->centralwidget);
+    taxFilter->setPlaceholderText(">0");
+    QPushButton* filterButton = new QPushButton(QString::fromLocal8Bit("筛选"), ui->centralwidget);
+
+    ui->horizontalLayout_3->addWidget(salaryLabel);
+    ui->horizontalLayout_3->addWidget(salaryFilter);
+    ui->horizontalLayout_3->addWidget(taxLabel);
+    ui->horizontalLayout_3->addWidget(taxFilter);
+    ui->horizontalLayout_3->addWidget(filterButton);
+
+    connect(filterButton, &QPushButton::clicked, this, &WagesTax::applyFilters);
+    connect(salaryFilter, &QLineEdit::returnPressed, this, &WagesTax::applyFilters);
+    connect(taxFilter, &QLineEdit::returnPressed, this, &WagesTax::applyFilters);
+}
+
+// 在列标题上显示当前排序方向
+void WagesTax::updateSortHeaders()
+{
+    for (QPushButton* button : sortHeaders)
+    {
+        QString title = button->property("title").toString();
+        if (button->property("sortKey").toInt() == querySpec.sortKey)
+        {
+            title += QString(" ") + QChar(querySpec.descending ? 0x25BC : 0x25B2);  // ▼ / ▲
+        }
+        button->setText(title);
+    }
+}
+
+// 槽函数：点击列标题
+void WagesTax::onSortHeaderClicked()
+{
+    QObject* button = sender();
+    if (!button)
+    {
+        return;
+    }
+
+    EmployeeQuery::SortKey key = EmployeeQuery::SortKey(button->property("sortKey").toInt());
+    querySpec.descending = key == querySpec.sortKey ? !querySpec.descending : false;
+    querySpec.sortKey = key;
+    updateSortHeaders();
+
+    ui->query_edit_6->clear();
+    on_query_clicked();
+}
+
+// 槽函数：应用范围筛选
+void WagesTax::applyFilters()
+{
+    EmployeeQuery::Range salary;
+    EmployeeQuery::Range tax;
+    if (!EmployeeQuery::Range::parse(salaryFilter->text(), salary)
+        || !EmployeeQuery::Range::parse(taxFilter->text(), tax))
+    {
+        QMessageBox::warning(this, QString::fromLocal8Bit("筛选失败"),
+            QString::fromLocal8Bit("范围格式不正确，例如：8000-12000、>0、<=5000"));
+        return;
+    }
+
+    querySpec.salary = salary;
+    querySpec.tax = tax;
+    ui->query_edit_6->clear();
+    on_query_clicked();
+}
+
+// 按当前排序和筛选条件查询并显示
+void WagesTax::runSpecQuery()
+{
+    TraceSpan span("WagesTax::runSpecQuery", "ui");
+    querySpec.limit = SpecDisplayLimit;
+
+    auto result = sql->queryEmployees(querySpec);
+    int total = sql->countEmployees(querySpec);
+    if (result.empty())
+    {
+        ui->listWidget->clear();
+        pagedListing = false;
+    }
+    else
+    {
+        showResult(result);
+    }
+
+    if (total > int(result.size()))
+    {
+        ui->statusbar->showMessage(QString::fromLocal8Bit("符合条件 %1 名员工，显示前 %2 名").arg(total).arg(result.size()));
+    }
+    else
+    {
+        ui->statusbar->showMessage(QString::fromLocal8Bit("符合条件 %1 名员工").arg(total));
+    }
+}
+
+// 创建工资核算菜单、诊断菜单和状态栏标签
+void WagesTax::setupDiagnostics()
+{
+    QMenu* payrollMenu = ui->menubar->addMenu(QString::fromLocal8Bit("工资核算"));
+    QAction* payrollAction = payrollMenu->addAction(QString::fromLocal8Bit("月度核算..."));
+    connect(payrollAction, &QAction::triggered, this, &WagesTax::showPayroll);
+    QAction* breakdownAction = payrollMenu->addAction(QString::fromLocal8Bit("工资明细（社保、公积金）..."));
+    connect(breakdownAction, &QAction::triggered, this, &WagesTax::showPayBreakdown);
+
+    QMenu* accountMenu = ui->menubar->addMenu(QString::fromLocal8Bit("账号"));
+    QAction* passwordAction = accountMenu->addAction(QString::fromLocal8Bit("修改密码..."));
+    connect(passwordAction, &QAction::triggered, this, &WagesTax::changePassword);
+
+    QMenu* menu = ui->menubar->addMenu(QString::fromLocal8Bit("诊断"));
+    QAction* action = menu->addAction(QString::fromLocal8Bit("诊断信息..."));
+    connect(action, &QAction::triggered, this, &WagesTax::showDiagnostics);
+
+    // 勾选时开始记录时间线，取消勾选时停止并选择保存位置
+    QAction* traceAction = menu->addAction(QString::fromLocal8Bit("记录时间线"));
+    traceAction->setCheckable(true);
+    traceAction->setChecked(TraceRecorder::isEnabled());
+    connect(traceAction, &QAction::toggled, this, &WagesTax::toggleTrace);
+
+    metricsLabel = new QLabel(this);
+    ui->statusbar->addPermanentWidget(metricsLabel);
+}
+
+// 槽函数：开始或停止记录时间线
+void WagesTax::toggleTrace(bool checked)
+{
+    if (checked)
+    {
+        TraceRecorder::start();
+        ui->statusbar->showMessage(QString::fromLocal8Bit("正在记录时间线..."), 3000);
+        return;
+    }
+
+    TraceRecorder::stop();
+    QString path = QFileDialog::getSaveFileName(this, QString::fromLocal8Bit("保存时间线"), "wagestax_trace.json", "Trace (*.json)");
+    if (!path.isEmpty() && !TraceRecorder::saveToFile(path))
+    {
+        QMessageBox::warning(this, QString::fromLocal8Bit("保存失败"), QString::fromLocal8Bit("无法写入文件！"));
+    }
+}
+
+// 槽函数：打开诊断信息窗口
+void WagesTax::showDiagnostics()
+{
+    if (!diagnostics)
+    {
+        diagnostics = new DiagnosticsDialog(this);
+    }
+    diagnostics->show();
+    diagnostics->raise();
+    diagnostics->activateWindow();
+}
+
+// 槽函数：打开工资核算窗口
+void WagesTax::showPayroll()
+{
+    if (!payroll)
+    {
+        payroll = new PayrollDialog(this);
+    }
+    payroll->show();
+    payroll->raise();
+    payroll->activateWindow();
+}
+
+// 记录登录的账号和会话令牌
+void WagesTax::setSession(const QString& username, const QString& token)
+{
+    sessionUser = username;
+    sessionToken = token;
+}
+
+// 槽函数：修改当前账号的密码，成功后换用新的会话令牌
+void WagesTax::changePassword()
+{
+    if (sessionUser.isEmpty())
+    {
+        QMessageBox::information(this, QString::fromLocal8Bit("修改密码"), QString::fromLocal8Bit("当前没有登录的账号。"));
+        return;
+    }
+    ChangePasswordDialog dialog(sessionUser, sessionToken, this);
+    if (dialog.exec() == QDialog::Accepted)
+    {
+        sessionToken = dialog.sessionToken();
+        ui->statusbar->showMessage(QString::fromLocal8Bit("密码已修改"), 5000);
+    }
+}
+
+// 槽函数：编辑选中员工的专项扣除，确定后写回存储并重新计税
+void WagesTax::editDeductions()
+{
+    QListWidgetItem* selectedItem = ui->listWidget->currentItem();
+    QWidget* widget = selectedItem ? ui->listWidget->itemWidget(selectedItem) : nullptr;
+    if (!widget)
+    {
+        QMessageBox::warning(this, QString::fromLocal8Bit("提示"), QString::fromLocal8Bit("请先选择一名员工！"));
+        return;
+    }
+
+    int itemId = widget->property("itemId").toInt();
+    auto result = sql->queryEmployeeByIdOrName(itemId);
+    if (result.empty())
+    {
+        return;
+    }
+
+    DeductionsDialog dialog(QString("%1 %2").arg(itemId).arg(std::get<1>(result.front())), sql->deductions(itemId), this);
+    if (dialog.exec() != QDialog::Accepted)
+    {
+        return;
+    }
+    if (!sql->setDeductions(itemId, dialog.deductions()))
+    {
+        QMessageBox::warning(this, QString::fromLocal8Bit("修改失败"), QString::fromLocal8Bit("无法保存专项扣除！"));
+        return;
+    }
+    on_query_clicked();
+}
+
+// 槽函数：打开工资明细窗口
+void WagesTax::showPayBreakdown()
+{
+    if (!payBreakdown)
+    {
+        payBreakdown = new PayBreakdownDialog(this);
+    }
+    payBreakdown->show();
+    payBreakdown->raise();
+    payBreakdown->activateWindow();
 }
 
 // 槽函数：处理当列表项被选中时的操作
 void WagesTax::onItemSelected() 
 {
+    TraceSpan span("WagesTax::onItemSelected", "ui");
+
     // 获取当前选中的列表项
     QListWidgetItem* selectedItem = ui->listWidget->currentItem();
 
@@ -51,7 +630,7 @@ void WagesTax::onItemSelected()
             int itemId = idVariant.toInt();
 
             // 根据 ID 查询员工信息
-            auto result = sql.queryEmployeeByIdOrName(itemId);
+            auto result = sql->queryEmployeeByIdOrName(itemId);
             if (result.empty())
             {
                 return;  // 如果没有找到对应的员工，返回
@@ -67,6 +646,9 @@ void WagesTax::onItemSelected()
 // 槽函数：处理添加员工操作
 void WagesTax::on_add_clicked()
 {
+    TraceSpan span("WagesTax::on_add_clicked", "ui");
+    AllocationScope allocations("recompute");
+
     // 如果员工姓名或薪资为空，弹出警告框
     if (ui->name_edit->text().isEmpty() 
         ||
@@ -77,17 +659,27 @@ void WagesTax::on_add_clicked()
     }
 
     // 调用 SQL 添加员工信息
-    sql.addEmployee(ui->name_edit->text(),
-        ui->salary_edit_2->text().toDouble());
+    if (sql->addEmployee(ui->name_edit->text(),
+        ui->salary_edit_2->text().toDouble()))
+    {
+        QMessageBox::information(this, QString::fromLocal8Bit("添加成功"), QString::fromLocal8Bit("成功录入！"), QMessageBox::StandardButton::Ok);
+    }
+    else
+    {
+        // 写入失败（例如数据库被其他连接长时间锁住）时提示用户，输入框中的内容保留以便重试
+        QMessageBox::warning(this, QString::fromLocal8Bit("添加失败"), QString::fromLocal8Bit("员工未保存，数据库忙或写入出错，请稍后重试！"));
+        return;
+    }
 
-    // 查询所有员工并展示
-    auto result = sql.queryEmployees();
-    showResult(result);
+    // 显示员工列表的第一页
+    showFirstPage();
 }
 
 // 槽函数：处理删除员工操作
 void WagesTax::on_delete_2_clicked()
 {
+    TraceSpan span("WagesTax::on_delete_2_clicked", "ui");
+
     // 获取当前选中的列表项
     QListWidgetItem* selectedItem = 
         ui->listWidget->currentItem();
@@ -106,8 +698,14 @@ void WagesTax::on_delete_2_clicked()
             // 将 QVariant 转换为整数类型的 ID
             int itemId = idVariant.toInt();
 
-            // 调用 SQL 删除该员工
-            sql.deleteEmployee(itemId);
+            // 调用 SQL 删除该员工，失败时（例如数据库被其他连接长时间锁住）提示用户
+            if (!sql->deleteEmployee(itemId))
+            {
+                QMessageBox::warning(this,
+                    QString::fromLocal8Bit("删除失败"),
+                    QString::fromLocal8Bit("员工未删除，数据库忙或写入出错，请稍后重试！"));
+                return;
+            }
 
             // 刷新查询结果，更新列表
             on_query_clicked();
@@ -137,6 +735,9 @@ void WagesTax::on_delete_2_clicked()
 // 槽函数：处理修改员工信息操作
 void WagesTax::on_modify_clicked()
 {
+    TraceSpan span("WagesTax::on_modify_clicked", "ui");
+    AllocationScope allocations("recompute");
+
     // 获取当前选中的列表项
     QListWidgetItem* selectedItem = 
         ui->listWidget->currentItem();
@@ -161,13 +762,19 @@ void WagesTax::on_modify_clicked()
 
             // 根据 ID 查询员工信息并获取结果
             auto result =
-                sql.queryEmployeeByIdOrName(itemId, "").front();
+                sql->queryEmployeeByIdOrName(itemId, "").front();
 
-            // 更新员工信息
-            sql.updateEmployee(
+            // 更新员工信息，失败时（例如数据库被其他连接长时间锁住）提示用户，输入框中的内容保留以便重试
+            if (!sql->updateEmployee(
                 std::get<0>(result),
                 ui->name_edit->text(),
-                ui->salary_edit_2->text().toDouble());
+                ui->salary_edit_2->text().toDouble()))
+            {
+                QMessageBox::warning(this,
+                    QString::fromLocal8Bit("修改失败"),
+                    QString::fromLocal8Bit("修改未保存，数据库忙或写入出错，请稍后重试！"));
+                return;
+            }
 
             // 刷新查询结果，更新列表
             on_query_clicked();
@@ -191,11 +798,17 @@ void WagesTax::on_modify_clicked()
 // 槽函数：处理查询员工操作
 void WagesTax::on_query_clicked()
 {
-    // 如果查询框为空，显示所有员工
+    TraceSpan span("WagesTax::on_query_clicked", "ui");
+
+    // 如果查询框为空，分页显示所有员工（设置了排序或筛选时按条件查询）
     if (ui->query_edit_6->text().isEmpty())
     {
-        auto result = sql.queryEmployees();
-        showResult(result);
+        if (!querySpec.isDefault())
+        {
+            runSpecQuery();
+            return;
+        }
+        showFirstPage();
     }
     else
     {
@@ -213,7 +826,7 @@ void WagesTax::on_query_clicked()
             // 如果是数字，调用查询函数，按 ID 查询
             auto result
                 =
-                sql.queryEmployeeByIdOrName(id, QString());
+                sql->queryEmployeeByIdOrName(id, QString());
             showResult(result);
         }
         else 
@@ -221,7 +834,7 @@ void WagesTax::on_query_clicked()
             // 如果不是数字，按姓名查询
             auto result
                 = 
-                sql.queryEmployeeByIdOrName(-1, input);
+                sql->queryEmployeeByIdOrName(-1, input);
             showResult(result);
         }
     }
@@ -229,6 +842,12 @@ void WagesTax::on_query_clicked()
 
 // 显示查询结果
 void WagesTax::showResult(std::vector<std::pair<int, QString>>& result)
+{
+    renderRows(result, false);
+}
+
+// 渲染员工行
+void WagesTax::renderRows(std::vector<std::pair<int, QString>>& result, bool append)
 {
     // 检查输入的结果列表是否为空
     if (result.empty())
@@ -237,8 +856,22 @@ void WagesTax::showResult(std::vector<std::pair<int, QString>>& result)
         return; // 如果没有数据，直接返回
     }
 
-    // 清空现有的列表项，为展示新的数据做准备
-    ui->listWidget->clear();
+    static MetricsHistogram& renderLatency = MetricsRegistry::instance().histogram(
+        "wagestax_render_ns", QString(), "WagesTax::showResult latency in nanoseconds");
+    static MetricsCounter& renderedRows = MetricsRegistry::instance().counter(
+        "wagestax_rendered_rows_total", QString(), "Rows rendered by WagesTax::showResult");
+    static MetricsGauge& listRows = MetricsRegistry::instance().gauge(
+        "wagestax_list_rows", QString(), "Rows currently shown in the employee list");
+    ScopedLatency timer(renderLatency);
+    TraceSpan span("WagesTax::showResult", "render");
+    AllocationScope allocations("render");
+
+    // 清空现有的列表项，为展示新的数据做准备；追加下一页时保留已显示的行
+    if (!append)
+    {
+        ui->listWidget->clear();
+        pagedListing = false;
+    }
 
     // 获取结果的总数，并通过调试输出进行记录
     int totalResults 
@@ -336,6 +969,20 @@ void WagesTax::showResult(std::vector<std::pair<int, QString>>& result)
             qCritical() << "An unknown error occurred for employee ID:" << employeeId;
         }
     }
+
+    // 记录渲染行数和耗时，并在状态栏显示
+    int rendered = ui->listWidget->count();
+    renderedRows.add(quint64(rendered));
+    listRows.set(rendered);
+    double renderMs = timer.elapsedNs() / 1e6;
+    timer.finish();
+
+    static MetricsHistogram& selectAll = MetricsRegistry::instance().histogram(
+        "wagestax_sql_statement_ns", "statement=\"select_all\"");
+    metricsLabel->setText(QString::fromLocal8Bit("渲染 %1 行 %2 ms | 全表查询 p99 %3 ms")
+        .arg(rendered)
+        .arg(renderMs, 0, 'f', 1)
+        .arg(selectAll.percentile(0.99) / 1e6, 0, 'f', 1));
 }
 
 
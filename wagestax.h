@@ -3,12 +3,28 @@
 
 // 包含 Qt 框架的头文件
 #include <QMainWindow>
+#include <QFutureWatcher>
+#include <QTimer>
+#include <vector>
 // 引入登录对话框和数据库管理类
 #include "logindialog.h"
-#include "sqlmanager.h"
+#include "employeestore.h"
+#include "databasepreloader.h"
+#include "employeesearchindex.h"
+#include <memory>
 
 
 // Qt 命名空间的开头部分
+class QLabel;
+class QLineEdit;
+class QPushButton;
+class DiagnosticsDialog;
+class PayrollDialog;
+class PayBreakdownDialog;
+class PayrollDashboard;
+class SalaryRankIndex;
+class SalaryStatsPanel;
+
 QT_BEGIN_NAMESPACE
 namespace Ui { class WagesTax; }  // 声明 UI 类，WagesTax 用于存放界面元素
 QT_END_NAMESPACE
@@ -19,9 +35,13 @@ class WagesTax : public QMainWindow
 {
     Q_OBJECT  // Qt 特性，用于提供信号和槽功能
 
+    // 场景基准测试直接调用 showResult 并读取界面状态
+    friend class ScenarioBenchmark;
+
 public:
     // 构造函数：初始化 WagesTax 窗口，接受父级窗口指针（默认为 nullptr）
-    WagesTax(QWidget* parent = nullptr);
+    // preloader 为启动时已经开始预热数据库的预加载器，为空时窗口自行创建一个
+    WagesTax(QWidget* parent = nullptr, DatabasePreloader* preloader = nullptr);
 
     // 析构函数：清理和销毁 WagesTax 对象
     ~WagesTax();
@@ -29,6 +49,9 @@ public:
     // 初始化数据库（创建 SQL 连接或相关设置）
     void createSql();
 
+    // 记录登录的账号和会话令牌，修改密码时使用
+    void setSession(const QString& username, const QString& token);
+
 private slots:
     // 槽函数：当用户选择列表中的某一项时调用，处理选中项的操作
     void onItemSelected();
@@ -51,11 +74,158 @@ private slots:
     // 槽函数：清除输入框的内容和选择的列表项
     void clearInput();
 
+    // 槽函数：窗口显示后等待预加载器的结果（必要时才启动预加载）
+    void startDeferredLoad();
+
+    // 槽函数：后台加载完成后在界面线程打开默认连接并展示结果
+    void onDeferredLoadFinished();
+
+    // 槽函数：打开诊断信息窗口
+    void showDiagnostics();
+
+    // 槽函数：编辑选中员工的专项扣除
+    void editDeductions();
+
+    // 槽函数：打开工资核算窗口
+    void showPayroll();
+
+    // 槽函数：打开工资明细（社保、公积金、个税）窗口
+    void showPayBreakdown();
+
+    // 槽函数：修改当前账号的密码
+    void changePassword();
+
+    // 槽函数：开始（checked 为 true）或停止记录时间线，停止时保存为 trace-event JSON
+    void toggleTrace(bool checked);
+
+    // 槽函数：查询框内容变化，重新开始防抖计时（取消尚未执行的搜索）
+    void onSearchTextEdited();
+
+    // 槽函数：防抖计时结束，用前缀索引过滤列表
+    void applySearch();
+
+    // 槽函数：员工数据整体变化（批量导入、清空）后重新构建搜索索引和工资顺序统计索引，
+    // 两个索引在同一个后台任务中用独立连接一次读取后构建，完成后由 onIndexRebuildFinished 替换
+    void rebuildIndexes();
+
+    // 槽函数：后台重建的索引就绪，重放重建期间的增删改后替换当前索引
+    void onIndexRebuildFinished();
+
+    // 槽函数：点击列标题按该列排序，再次点击切换升序/降序
+    void onSortHeaderClicked();
+
+    // 槽函数：应用工资和税额的范围筛选
+    void applyFilters();
+
+    // 槽函数：员工数据变化后刷新工资汇总面板（只读取各档位的汇总行）和工资统计面板
+    void refreshDashboard();
+
 private:
-    
+    // 创建菜单（工资核算、账号、诊断）和状态栏中的诊断入口
+    void setupDiagnostics();
+
+    // 创建可点击的列标题和范围筛选输入框
+    void setupQueryControls();
+
+    // 按当前排序和筛选条件查询并显示（排序和过滤由数据库完成）
+    void runSpecQuery();
+
+    // 显示全部员工列表的第一页，其余行滚动到底部时再读取
+    void showFirstPage();
+
+    // 把员工列表的一页显示出来（append 为 true 时追加到末尾），并记录下一页的起点
+    void showListPage(std::vector<std::pair<int, QString>>& page, bool append);
+
+    // 列表滚动到底部时追加下一页
+    void onListScrolled(int value);
+
+    // 渲染员工行，append 为 false 时先清空列表
+    void renderRows(std::vector<std::pair<int, QString>>& rows, bool append);
+
+    // 在列标题上显示当前排序方向
+    void updateSortHeaders();
+
+    // 当前的排序和筛选条件
+    EmployeeQuery querySpec;
+
+    // 列表正在分页显示全部员工时为 true，listLastId 是已显示的最后一名员工的 ID
+    bool pagedListing = false;
+    bool listHasMore = false;
+    int listLastId = 0;
+    int listTotal = 0;
+
+    // 列标题按钮，顺序与 EmployeeQuery::SortKey 相同
+    std::vector<QPushButton*> sortHeaders;
+
+    // 工资和税额范围输入框
+    QLineEdit* salaryFilter = nullptr;
+    QLineEdit* taxFilter = nullptr;
+
+    // 工资汇总面板
+    PayrollDashboard* dashboard = nullptr;
+
+    // 工资的顺序统计索引，随存储的变化事件同步更新
+    std::shared_ptr<SalaryRankIndex> rankIndex;
+
+    // 工资分位数和排名面板
+    SalaryStatsPanel* statsPanel = nullptr;
+
+    // 诊断信息窗口（首次打开时创建）
+    DiagnosticsDialog* diagnostics = nullptr;
+
+    // 工资核算窗口（首次打开时创建）
+    PayrollDialog* payroll = nullptr;
+
+    // 工资明细窗口（首次打开时创建）
+    PayBreakdownDialog* payBreakdown = nullptr;
+
+    // 登录的账号和会话令牌
+    QString sessionUser;
+    QString sessionToken;
+
+    // 状态栏中显示最近一次渲染耗时和 SQL 延迟的标签
+    QLabel* metricsLabel = nullptr;
+
+    // 数据库预加载器，由 main 传入或由窗口自行创建
+    DatabasePreloader* preloader;
+    std::unique_ptr<DatabasePreloader> ownPreloader;
+
+    // 后台加载员工列表的监视器
+    QFutureWatcher<DatabasePreloader::State> loadWatcher;
+
+    // 姓名和 ID 的前缀索引，随存储的变化事件同步更新
+    std::shared_ptr<EmployeeSearchIndex> searchIndex;
+
+    // 后台重建的索引
+    struct IndexBuild
+    {
+        std::shared_ptr<EmployeeSearchIndex> searchIndex;
+        std::shared_ptr<SalaryRankIndex> rankIndex;
+    };
+
+    // 重建期间发生的单条增删改，新索引就绪后在其上重放
+    struct IndexChange
+    {
+        int id = 0;
+        QString name;
+        double salary = 0;
+        QString display;
+        bool removed = false;
+    };
+
+    // 后台重建索引的监视器
+    QFutureWatcher<IndexBuild> indexWatcher;
+
+    // 是否正在后台重建索引，以及重建开始后记录的增删改
+    bool rebuildingIndexes = false;
+    std::vector<IndexChange> pendingIndexChanges;
+
+    // 边输入边搜索的防抖计时器
+    QTimer searchTimer;
+
 
-    // 数据库管理对象，用于执行与数据库的交互操作（如查询、插入、更新等）
-    SqlManager sql;
+    // 员工数据存储，用于执行查询、插入、更新等操作（后端由配置决定）
+    std::unique_ptr<EmployeeStore> sql;
 
     // Ui::WagesTax 指针，指向自动生成的 UI 类，用于管理 UI 元素
     Ui::WagesTax* ui;
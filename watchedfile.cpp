@@ -0,0 +1,59 @@
+﻿#include "watchedfile.h"
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QTimer>
+
+namespace
+{
+    // 文件变化后等待的时间，编辑器分几次写入时只通知一次
+    const int DebounceMs = 200;
+}
+
+// WatchedFile 构造函数
+WatchedFile::WatchedFile(const QString& path, QObject* parent)
+    : QObject(parent)
+    , filePath(path)
+    , watcher(new QFileSystemWatcher(this))
+    , debounce(new QTimer(this))
+{
+    debounce->setSingleShot(true);
+    debounce->setInterval(DebounceMs);
+    connect(debounce, &QTimer::timeout, this, &WatchedFile::changed);
+    connect(watcher, &QFileSystemWatcher::fileChanged, this, &WatchedFile::onChanged);
+    connect(watcher, &QFileSystemWatcher::directoryChanged, this, &WatchedFile::onChanged);
+}
+
+// 开始监视
+void WatchedFile::start()
+{
+    QFileInfo info(filePath);
+    watcher->addPath(info.absolutePath());
+    if (info.exists())
+    {
+        watcher->addPath(info.absoluteFilePath());
+    }
+}
+
+// 记录当前的修改时间和大小
+void WatchedFile::markLoaded()
+{
+    QFileInfo info(filePath);
+    loadedModified = info.lastModified();
+    loadedSize = info.exists() ? info.size() : -1;
+}
+
+// 文件或目录发生变化：文件被替换后原来的监视会失效，重新加入
+void WatchedFile::onChanged()
+{
+    QFileInfo info(filePath);
+    const qint64 size = info.exists() ? info.size() : -1;
+    if (info.lastModified() == loadedModified && size == loadedSize)
+    {
+        return;
+    }
+    if (info.exists() && !watcher->files().contains(info.absoluteFilePath()))
+    {
+        watcher->addPath(info.absoluteFilePath());
+    }
+    debounce->start();
+}
@@ -0,0 +1,58 @@
+﻿#ifndef WATCHEDFILE_H
+#define WATCHEDFILE_H
+
+#include <QDateTime>
+#include <QObject>
+#include <QString>
+
+class QFileSystemWatcher;
+class QTimer;
+
+// WatchedFile 类监视一个需要热加载的文件（配置文件、税率表），文件被修改、创建、替换或删除时发出 changed 信号。
+// 编辑器保存文件时常常先删除再创建，或分几次写入，因此同时监视文件所在目录，
+// 并把短时间内的多次变化合并为一次通知。目录中其他文件（如数据库日志）的变化通过比较修改时间和大小过滤掉。
+// 对象所在的线程需要运行事件循环。
+class WatchedFile : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 构造函数
+    // 参数:
+    //   - path: 被监视的文件路径
+    //   - parent: 父对象
+    explicit WatchedFile(const QString& path, QObject* parent = nullptr);
+
+    // 开始监视文件及其所在目录，文件不存在时只监视目录，创建后自动加入
+    void start();
+
+    // 记录当前文件的修改时间和大小，读取文件后调用，之后与此相同的状态不再通知
+    void markLoaded();
+
+    // 文件路径
+    QString path() const { return filePath; }
+
+signals:
+    // 文件相对上次 markLoaded 发生了变化（已合并连续变化）
+    void changed();
+
+private slots:
+    // 文件或目录发生变化
+    void onChanged();
+
+private:
+    // 文件路径
+    QString filePath;
+
+    // 文件系统监视器
+    QFileSystemWatcher* watcher;
+
+    // 合并连续变化的定时器
+    QTimer* debounce;
+
+    // 上次读取时文件的修改时间和大小，不存在时大小为 -1
+    QDateTime loadedModified;
+    qint64 loadedSize = -1;
+};
+
+#endif // WATCHEDFILE_H